@@ -0,0 +1,401 @@
+#ifndef GDWG_CONCURRENT_GRAPH_H
+#define GDWG_CONCURRENT_GRAPH_H
+#include "gdwg_graph.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+namespace gdwg {
+	// A graph safe to use from many threads at once. Nodes are spread over lock stripes by
+	// std::hash<N>, and a node's out-edges and in-edge sources live in its stripe. Readers take
+	// shared locks on the stripes they touch, writers exclusive ones; an operation on several stripes
+	// locks them in ascending order, so two operations can't wait on each other. Erasing or replacing
+	// a node locks the stripes of its neighbours, not the whole graph.
+	template<typename N, typename E>
+	class concurrent_graph {
+	 public:
+		using edge = gdwg::edge<N, E>;
+		static constexpr auto default_stripes = std::size_t{64};
+
+		explicit concurrent_graph(std::size_t stripes = default_stripes);
+		concurrent_graph(concurrent_graph const&) = delete;
+		auto operator=(concurrent_graph const&) -> concurrent_graph& = delete;
+
+		auto insert_node(N const& value) -> bool;
+		auto insert_edge(N const& src, N const& dst, std::optional<E> weight = std::nullopt) -> bool;
+		auto replace_node(N const& old_data, N const& new_data) -> bool;
+		auto merge_replace_node(N const& old_data, N const& new_data) -> void;
+		auto erase_node(N const& value) -> bool;
+		auto erase_edge(N const& src, N const& dst, std::optional<E> weight = std::nullopt) -> bool;
+		auto clear() -> void;
+
+		[[nodiscard]] auto is_node(N const& value) const -> bool;
+		[[nodiscard]] auto empty() const -> bool;
+		[[nodiscard]] auto is_connected(N const& src, N const& dst) const -> bool;
+		// iterators couldn't outlive the locks, so find only reports whether the edge exists
+		[[nodiscard]] auto find(N const& src, N const& dst, std::optional<E> weight = std::nullopt) const -> bool;
+		[[nodiscard]] auto connections(N const& src) const -> std::vector<N>;
+		[[nodiscard]] auto edges(N const& src, N const& dst) const -> std::vector<std::unique_ptr<edge>>;
+		[[nodiscard]] auto nodes() const -> std::vector<N>;
+
+		// a consistent copy, taken with every stripe locked
+		[[nodiscard]] auto snapshot() const -> graph<N, E>;
+
+	 private:
+		struct node_entry {
+			// out-edges sorted by (dst, weight), the unweighted edge first
+			std::vector<std::pair<N, std::optional<E>>> out;
+			// the source of every in-edge, sorted, repeated once per edge
+			std::vector<N> in;
+		};
+		// a stripe per cache line, so locking one doesn't contend with its neighbours
+		struct alignas(64) stripe {
+			mutable std::shared_mutex mutex;
+			std::map<N, node_entry> nodes;
+		};
+		using shared_lock = std::shared_lock<std::shared_mutex>;
+		using unique_lock = std::unique_lock<std::shared_mutex>;
+
+		std::vector<stripe> stripes_;
+
+		[[nodiscard]] auto stripe_of(N const& value) const noexcept -> std::size_t;
+		// locks the stripes at indices in ascending order, each once
+		template<typename Lock>
+		[[nodiscard]] auto lock_stripes(std::vector<std::size_t> indices) const -> std::vector<Lock>;
+		template<typename Lock>
+		[[nodiscard]] auto lock_all() const -> std::vector<Lock>;
+		// exclusive locks on the stripes of value, other and every neighbour of value; empty if value
+		// isn't a node. Neighbours are read under the locks taken so far, and the set is widened until
+		// it covers them, since they may change while no lock is held
+		[[nodiscard]] auto lock_neighbourhood(N const& value, N const& other) -> std::vector<unique_lock>;
+
+		// the entry of value in its stripe, nullptr if it isn't a node; the stripe must be locked
+		[[nodiscard]] auto entry(N const& value) const -> node_entry const*;
+		[[nodiscard]] auto entry(N const& value) -> node_entry*;
+		// for values the caller has already checked are nodes
+		[[nodiscard]] auto existing(N const& value) -> node_entry&;
+		// the first of e's out-edges to dst, or where it would be
+		[[nodiscard]] static auto first_edge_to(node_entry const& e, N const& dst)
+		    -> typename std::vector<std::pair<N, std::optional<E>>>::const_iterator;
+		// add or remove one edge, with both endpoints' stripes locked exclusively
+		auto link(N const& src, N const& dst, std::optional<E> const& weight) -> bool;
+		auto unlink(N const& src, N const& dst, std::optional<E> const& weight) -> bool;
+		// removes every edge into or out of value and returns them as (src, dst, weight)
+		auto detach(N const& value) -> std::vector<std::tuple<N, N, std::optional<E>>>;
+	};
+} // namespace gdwg
+template<typename N, typename E>
+gdwg::concurrent_graph<N, E>::concurrent_graph(std::size_t stripes)
+: stripes_(std::max(stripes, std::size_t{1})) {}
+template<typename N, typename E>
+auto gdwg::concurrent_graph<N, E>::stripe_of(N const& value) const noexcept -> std::size_t {
+	return std::hash<N>{}(value) % stripes_.size();
+}
+template<typename N, typename E>
+template<typename Lock>
+auto gdwg::concurrent_graph<N, E>::lock_stripes(std::vector<std::size_t> indices) const -> std::vector<Lock> {
+	std::sort(indices.begin(), indices.end());
+	indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+	auto locks = std::vector<Lock>();
+	locks.reserve(indices.size());
+	for (auto const i : indices) {
+		locks.emplace_back(stripes_[i].mutex);
+	}
+	return locks;
+}
+template<typename N, typename E>
+template<typename Lock>
+auto gdwg::concurrent_graph<N, E>::lock_all() const -> std::vector<Lock> {
+	auto locks = std::vector<Lock>();
+	locks.reserve(stripes_.size());
+	for (auto& s : stripes_) {
+		locks.emplace_back(s.mutex);
+	}
+	return locks;
+}
+template<typename N, typename E>
+auto gdwg::concurrent_graph<N, E>::lock_neighbourhood(N const& value, N const& other) -> std::vector<unique_lock> {
+	auto wanted = std::vector<std::size_t>{stripe_of(value), stripe_of(other)};
+	for (;;) {
+		std::sort(wanted.begin(), wanted.end());
+		wanted.erase(std::unique(wanted.begin(), wanted.end()), wanted.end());
+		auto locks = lock_stripes<unique_lock>(wanted);
+		auto const* const e = entry(value);
+		if (e == nullptr) {
+			return {};
+		}
+		auto needed = wanted;
+		for (auto const& [dst, weight] : e->out) {
+			needed.push_back(stripe_of(dst));
+		}
+		for (auto const& src : e->in) {
+			needed.push_back(stripe_of(src));
+		}
+		std::sort(needed.begin(), needed.end());
+		needed.erase(std::unique(needed.begin(), needed.end()), needed.end());
+		if (needed == wanted) {
+			return locks;
+		}
+		wanted = std::move(needed);
+	}
+}
+template<typename N, typename E>
+auto gdwg::concurrent_graph<N, E>::entry(N const& value) const -> node_entry const* {
+	auto const& nodes = stripes_[stripe_of(value)].nodes;
+	auto it = nodes.find(value);
+	return it == nodes.end() ? nullptr : &it->second;
+}
+template<typename N, typename E>
+auto gdwg::concurrent_graph<N, E>::entry(N const& value) -> node_entry* {
+	auto& nodes = stripes_[stripe_of(value)].nodes;
+	auto it = nodes.find(value);
+	return it == nodes.end() ? nullptr : &it->second;
+}
+template<typename N, typename E>
+auto gdwg::concurrent_graph<N, E>::existing(N const& value) -> node_entry& {
+	return stripes_[stripe_of(value)].nodes.find(value)->second;
+}
+template<typename N, typename E>
+auto gdwg::concurrent_graph<N, E>::first_edge_to(node_entry const& e, N const& dst)
+    -> typename std::vector<std::pair<N, std::optional<E>>>::const_iterator {
+	return std::lower_bound(e.out.begin(), e.out.end(), dst, [](auto const& r, N const& v) { return r.first < v; });
+}
+template<typename N, typename E>
+auto gdwg::concurrent_graph<N, E>::link(N const& src, N const& dst, std::optional<E> const& weight) -> bool {
+	auto& out = existing(src).out;
+	auto const record = std::pair<N, std::optional<E>>(dst, weight);
+	auto pos = std::lower_bound(out.begin(), out.end(), record);
+	if (pos != out.end() and *pos == record) {
+		return false;
+	}
+	out.insert(pos, record);
+	auto& in = existing(dst).in;
+	in.insert(std::upper_bound(in.begin(), in.end(), src), src);
+	return true;
+}
+template<typename N, typename E>
+auto gdwg::concurrent_graph<N, E>::unlink(N const& src, N const& dst, std::optional<E> const& weight) -> bool {
+	auto& out = existing(src).out;
+	auto const record = std::pair<N, std::optional<E>>(dst, weight);
+	auto pos = std::lower_bound(out.begin(), out.end(), record);
+	if (pos == out.end() or *pos != record) {
+		return false;
+	}
+	out.erase(pos);
+	auto& in = existing(dst).in;
+	in.erase(std::lower_bound(in.begin(), in.end(), src));
+	return true;
+}
+template<typename N, typename E>
+auto gdwg::concurrent_graph<N, E>::detach(N const& value) -> std::vector<std::tuple<N, N, std::optional<E>>> {
+	auto removed = std::vector<std::tuple<N, N, std::optional<E>>>();
+	auto const* const e = &existing(value);
+	for (auto const& [dst, weight] : e->out) {
+		removed.emplace_back(value, dst, weight);
+	}
+	// in holds a source once per edge, the edges themselves are in the source's out list
+	for (auto it = e->in.begin(); it != e->in.end(); it = std::upper_bound(it, e->in.end(), *it)) {
+		if (*it == value) {
+			continue;
+		}
+		auto const& source = existing(*it);
+		for (auto first = first_edge_to(source, value); first != source.out.end() and first->first == value; ++first) {
+			removed.emplace_back(*it, value, first->second);
+		}
+	}
+	for (auto const& [src, dst, weight] : removed) {
+		unlink(src, dst, weight);
+	}
+	return removed;
+}
+template<typename N, typename E>
+auto gdwg::concurrent_graph<N, E>::insert_node(N const& value) -> bool {
+	auto& s = stripes_[stripe_of(value)];
+	auto lock = unique_lock(s.mutex);
+	return s.nodes.try_emplace(value).second;
+}
+template<typename N, typename E>
+auto gdwg::concurrent_graph<N, E>::insert_edge(N const& src, N const& dst, std::optional<E> weight) -> bool {
+	auto locks = lock_stripes<unique_lock>({stripe_of(src), stripe_of(dst)});
+	if (entry(src) == nullptr or entry(dst) == nullptr) {
+		throw std::runtime_error("Cannot call gdwg::concurrent_graph<N, E>::insert_edge when either src or dst node "
+		                         "does not exist");
+	}
+	return link(src, dst, weight);
+}
+template<typename N, typename E>
+auto gdwg::concurrent_graph<N, E>::replace_node(N const& old_data, N const& new_data) -> bool {
+	auto locks = lock_neighbourhood(old_data, new_data);
+	if (locks.empty()) {
+		throw std::runtime_error("Cannot call gdwg::concurrent_graph<N, E>::replace_node on a node that doesn't exist");
+	}
+	if (entry(new_data) != nullptr) {
+		return false;
+	}
+	auto const removed = detach(old_data);
+	stripes_[stripe_of(old_data)].nodes.erase(old_data);
+	stripes_[stripe_of(new_data)].nodes.try_emplace(new_data);
+	auto const renamed = [&](N const& v) -> N const& { return v == old_data ? new_data : v; };
+	for (auto const& [src, dst, weight] : removed) {
+		link(renamed(src), renamed(dst), weight);
+	}
+	return true;
+}
+template<typename N, typename E>
+auto gdwg::concurrent_graph<N, E>::merge_replace_node(N const& old_data, N const& new_data) -> void {
+	auto locks = lock_neighbourhood(old_data, new_data);
+	if (locks.empty() or entry(new_data) == nullptr) {
+		throw std::runtime_error("Cannot call gdwg::concurrent_graph<N, E>::merge_replace_node on old or new data if "
+		                         "they don't exist in the graph");
+	}
+	if (old_data == new_data) {
+		return;
+	}
+	auto const removed = detach(old_data);
+	stripes_[stripe_of(old_data)].nodes.erase(old_data);
+	auto const renamed = [&](N const& v) -> N const& { return v == old_data ? new_data : v; };
+	// edges that now duplicate one of new_data's are dropped by link
+	for (auto const& [src, dst, weight] : removed) {
+		link(renamed(src), renamed(dst), weight);
+	}
+}
+template<typename N, typename E>
+auto gdwg::concurrent_graph<N, E>::erase_node(N const& value) -> bool {
+	auto locks = lock_neighbourhood(value, value);
+	if (locks.empty()) {
+		return false;
+	}
+	detach(value);
+	stripes_[stripe_of(value)].nodes.erase(value);
+	return true;
+}
+template<typename N, typename E>
+auto gdwg::concurrent_graph<N, E>::erase_edge(N const& src, N const& dst, std::optional<E> weight) -> bool {
+	auto locks = lock_stripes<unique_lock>({stripe_of(src), stripe_of(dst)});
+	if (entry(src) == nullptr or entry(dst) == nullptr) {
+		throw std::runtime_error("Cannot call gdwg::concurrent_graph<N, E>::erase_edge on src or dst if they don't "
+		                         "exist in the graph");
+	}
+	return unlink(src, dst, weight);
+}
+template<typename N, typename E>
+auto gdwg::concurrent_graph<N, E>::clear() -> void {
+	auto locks = lock_all<unique_lock>();
+	for (auto& s : stripes_) {
+		s.nodes.clear();
+	}
+}
+template<typename N, typename E>
+auto gdwg::concurrent_graph<N, E>::is_node(N const& value) const -> bool {
+	auto const& s = stripes_[stripe_of(value)];
+	auto lock = shared_lock(s.mutex);
+	return s.nodes.contains(value);
+}
+template<typename N, typename E>
+auto gdwg::concurrent_graph<N, E>::empty() const -> bool {
+	auto locks = lock_all<shared_lock>();
+	return std::all_of(stripes_.begin(), stripes_.end(), [](stripe const& s) { return s.nodes.empty(); });
+}
+template<typename N, typename E>
+auto gdwg::concurrent_graph<N, E>::is_connected(N const& src, N const& dst) const -> bool {
+	auto locks = lock_stripes<shared_lock>({stripe_of(src), stripe_of(dst)});
+	auto const* const e = entry(src);
+	if (e == nullptr or entry(dst) == nullptr) {
+		throw std::runtime_error("Cannot call gdwg::concurrent_graph<N, E>::is_connected if src or dst node don't "
+		                         "exist in the graph");
+	}
+	auto it = first_edge_to(*e, dst);
+	return it != e->out.end() and it->first == dst;
+}
+template<typename N, typename E>
+auto gdwg::concurrent_graph<N, E>::find(N const& src, N const& dst, std::optional<E> weight) const -> bool {
+	auto const& s = stripes_[stripe_of(src)];
+	auto lock = shared_lock(s.mutex);
+	auto const* const e = entry(src);
+	if (e == nullptr) {
+		return false;
+	}
+	// an edge to dst can only be stored while dst is a node, so dst's stripe needn't be locked
+	auto const record = std::pair<N, std::optional<E>>(dst, std::move(weight));
+	return std::binary_search(e->out.begin(), e->out.end(), record);
+}
+template<typename N, typename E>
+auto gdwg::concurrent_graph<N, E>::connections(N const& src) const -> std::vector<N> {
+	auto const& s = stripes_[stripe_of(src)];
+	auto lock = shared_lock(s.mutex);
+	auto const* const e = entry(src);
+	if (e == nullptr) {
+		throw std::runtime_error("Cannot call gdwg::concurrent_graph<N, E>::connections if src doesn't exist in the "
+		                         "graph");
+	}
+	auto result = std::vector<N>();
+	for (auto const& [dst, weight] : e->out) {
+		if (result.empty() or result.back() != dst) {
+			result.push_back(dst);
+		}
+	}
+	return result;
+}
+template<typename N, typename E>
+auto gdwg::concurrent_graph<N, E>::edges(N const& src, N const& dst) const -> std::vector<std::unique_ptr<edge>> {
+	auto locks = lock_stripes<shared_lock>({stripe_of(src), stripe_of(dst)});
+	auto const* const e = entry(src);
+	if (e == nullptr or entry(dst) == nullptr) {
+		throw std::runtime_error("Cannot call gdwg::concurrent_graph<N, E>::edges if src or dst node don't exist in "
+		                         "the graph");
+	}
+	auto result = std::vector<std::unique_ptr<edge>>();
+	auto it = first_edge_to(*e, dst);
+	for (; it != e->out.end() and it->first == dst; ++it) {
+		if (it->second) {
+			result.push_back(std::make_unique<weighted_edge<N, E>>(src, dst, *it->second));
+		}
+		else {
+			result.push_back(std::make_unique<unweighted_edge<N, E>>(src, dst));
+		}
+	}
+	return result;
+}
+template<typename N, typename E>
+auto gdwg::concurrent_graph<N, E>::nodes() const -> std::vector<N> {
+	auto result = std::vector<N>();
+	{
+		auto locks = lock_all<shared_lock>();
+		for (auto const& s : stripes_) {
+			for (auto const& [value, e] : s.nodes) {
+				result.push_back(value);
+			}
+		}
+	}
+	std::sort(result.begin(), result.end());
+	return result;
+}
+template<typename N, typename E>
+auto gdwg::concurrent_graph<N, E>::snapshot() const -> graph<N, E> {
+	auto values = std::vector<N>();
+	auto triples = std::vector<std::tuple<N, N, std::optional<E>>>();
+	{
+		auto locks = lock_all<shared_lock>();
+		for (auto const& s : stripes_) {
+			for (auto const& [value, e] : s.nodes) {
+				values.push_back(value);
+				for (auto const& [dst, weight] : e.out) {
+					triples.emplace_back(value, dst, weight);
+				}
+			}
+		}
+	}
+	auto g = graph<N, E>(values.begin(), values.end());
+	g.insert_edges(triples.begin(), triples.end());
+	return g;
+}
+#endif // GDWG_CONCURRENT_GRAPH_H
@@ -0,0 +1,111 @@
+#include "gdwg_concurrent_graph.h"
+
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_CASE("concurrent_graph: single threaded use matches graph") {
+	for (auto stripes : {std::size_t{1}, std::size_t{3}, std::size_t{64}}) {
+		auto c = gdwg::concurrent_graph<std::string, int>(stripes);
+		auto g = gdwg::graph<std::string, int>();
+		CHECK(c.empty());
+		for (auto const* n : {"a", "b", "c", "d", "e"}) {
+			CHECK(c.insert_node(n) == g.insert_node(n));
+		}
+		CHECK_FALSE(c.insert_node("a"));
+		auto const edges = std::vector<std::tuple<std::string, std::string, std::optional<int>>>{
+		    {"a", "b", 1}, {"a", "b", std::nullopt}, {"a", "c", 2}, {"b", "a", 3}, {"c", "c", 4},
+		    {"d", "a", 5}, {"e", "b", 6}, {"b", "e", std::nullopt}, {"a", "b", 1},
+		};
+		for (auto const& [src, dst, weight] : edges) {
+			CHECK(c.insert_edge(src, dst, weight) == g.insert_edge(src, dst, weight));
+		}
+		CHECK(c.snapshot() == g);
+		CHECK(c.is_connected("a", "b"));
+		CHECK_FALSE(c.is_connected("b", "c"));
+		CHECK(c.find("a", "b"));
+		CHECK(c.find("a", "b", 1));
+		CHECK_FALSE(c.find("a", "b", 2));
+		CHECK(c.connections("a") == g.connections("a"));
+		auto const ab = c.edges("a", "b");
+		REQUIRE(ab.size() == 2);
+		CHECK(ab[0]->print_edge() == g.edges("a", "b")[0]->print_edge());
+		CHECK(ab[1]->print_edge() == g.edges("a", "b")[1]->print_edge());
+
+		CHECK(c.replace_node("c", "f") == g.replace_node("c", "f"));
+		CHECK_FALSE(c.replace_node("a", "b"));
+		CHECK(c.snapshot() == g);
+		c.merge_replace_node("b", "a");
+		g.merge_replace_node("b", "a");
+		CHECK(c.snapshot() == g);
+		CHECK(c.erase_edge("a", "a", 3) == g.erase_edge("a", "a", 3));
+		CHECK(c.erase_node("a") == g.erase_node("a"));
+		CHECK_FALSE(c.erase_node("a"));
+		CHECK(c.snapshot() == g);
+		CHECK(c.nodes() == g.nodes());
+
+		auto const missing = [&c] { return c.insert_edge("a", "f"); };
+		CHECK_THROWS_WITH(missing(),
+		                  "Cannot call gdwg::concurrent_graph<N, E>::insert_edge when either src or dst node does not "
+		                  "exist");
+		CHECK_THROWS_AS(c.connections("a"), std::runtime_error);
+		c.clear();
+		CHECK(c.empty());
+	}
+}
+TEST_CASE("concurrent_graph: concurrent writers and readers leave a consistent graph") {
+	auto constexpr nodes = 200;
+	auto constexpr threads = 4;
+	auto c = gdwg::concurrent_graph<int, int>(8);
+	for (auto i = 0; i < nodes; ++i) {
+		c.insert_node(i);
+	}
+	auto workers = std::vector<std::thread>();
+	for (auto t = 0; t < threads; ++t) {
+		workers.emplace_back([&c, t] {
+			// each writer owns the edges whose weight is its index, so the final edge set is known
+			for (auto i = 0; i < 2000; ++i) {
+				auto const src = (i * 7 + t) % nodes;
+				auto const dst = (i * 13 + 3 * t) % nodes;
+				c.insert_edge(src, dst, t);
+				if (i % 3 == 0) {
+					c.erase_edge(src, dst, t);
+				}
+				static_cast<void>(c.is_connected(dst, src));
+				static_cast<void>(c.connections(src));
+			}
+		});
+	}
+	// meanwhile nodes outside the range are renamed, merged and erased, taking their neighbours' stripes
+	workers.emplace_back([&c] {
+		for (auto i = 0; i < 500; ++i) {
+			c.insert_node(nodes + 1);
+			c.insert_edge(nodes + 1, i % nodes, -1);
+			c.insert_edge(i % nodes, nodes + 1, -1);
+			c.replace_node(nodes + 1, nodes + 2);
+			c.insert_node(nodes + 3);
+			c.merge_replace_node(nodes + 2, nodes + 3);
+			c.erase_node(nodes + 3);
+		}
+	});
+	for (auto& w : workers) {
+		w.join();
+	}
+	auto expected = gdwg::graph<int, int>();
+	for (auto i = 0; i < nodes; ++i) {
+		expected.insert_node(i);
+	}
+	for (auto t = 0; t < threads; ++t) {
+		for (auto i = 0; i < 2000; ++i) {
+			auto const src = (i * 7 + t) % nodes;
+			auto const dst = (i * 13 + 3 * t) % nodes;
+			expected.insert_edge(src, dst, t);
+			if (i % 3 == 0) {
+				expected.erase_edge(src, dst, t);
+			}
+		}
+	}
+	CHECK(c.snapshot() == expected);
+}
@@ -0,0 +1,829 @@
+#ifndef GDWG_CONTRACTION_HIERARCHY_H
+#define GDWG_CONTRACTION_HIERARCHY_H
+#include "gdwg_graph.h"
+#include "gdwg_graph_io.h"
+#include "gdwg_mapped_graph.h"
+#include "gdwg_shortest_paths.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+namespace gdwg {
+	template<typename E>
+	struct contraction_options {
+		// the cost of an unweighted edge
+		E unweighted_cost = E{1};
+		// worker threads for the witness searches, 0 for one per core
+		std::size_t threads = 0;
+		// nodes a witness search settles before giving up, keeping the shortcut it looked to avoid
+		std::size_t witness_limit = 500;
+		// the same for the searches estimating how many shortcuts a node would need, which run for
+		// every neighbour of every contracted node and only have to rank nodes roughly
+		std::size_t estimate_limit = 30;
+	};
+
+	namespace detail {
+		// Hierarchy file layout, as for snapshots: the header, then sections aligned to
+		// snapshot_alignment. Nodes are stored sorted, so a node's id is its rank. The arcs from node
+		// i up to nodes contracted after it are up[up_offsets[i], up_offsets[i + 1]), the arcs into
+		// it from those nodes down[down_offsets[i], down_offsets[i + 1]).
+		inline constexpr auto hierarchy_magic = std::array<char, 8>{'G', 'D', 'W', 'G', 'C', 'H', 'I', 'E'};
+		inline constexpr auto hierarchy_version = std::uint32_t{1};
+
+		struct hierarchy_header {
+			std::array<char, 8> magic;
+			std::uint32_t version;
+			std::uint32_t byte_order;
+			// sizeof(N), or 0 when the nodes are strings kept in a string table
+			std::uint32_t node_size;
+			std::uint32_t weight_size;
+			std::uint64_t node_count;
+			std::uint64_t up_count;
+			std::uint64_t down_count;
+			std::uint64_t shortcut_count;
+			// byte offsets of the sections, nodes_at is the string table's offsets for string nodes
+			std::uint64_t nodes_at;
+			std::uint64_t names_at;
+			std::uint64_t levels_at;
+			std::uint64_t up_offsets_at;
+			std::uint64_t up_at;
+			std::uint64_t down_offsets_at;
+			std::uint64_t down_at;
+			std::uint64_t file_size;
+		};
+
+		template<typename E>
+		struct hierarchy_arc {
+			// the other end, contracted after the node the arc is stored with
+			std::uint32_t target;
+			// the node a shortcut bypasses, no_node for an edge of the graph
+			std::uint32_t middle;
+			E weight;
+		};
+
+		// Contracts nodes in rounds. Each round takes the nodes whose priority is lower than all of
+		// their neighbours', which share no arcs, finds the shortcuts they need with witness searches
+		// in parallel, then removes them and adds the shortcuts. Priorities are the edge difference
+		// of a simulated contraction plus how many neighbours and how deep a hierarchy below a node
+		// were contracted already, and are recomputed for the neighbours of each round.
+		template<typename E>
+		class contractor {
+		 public:
+			using arc = hierarchy_arc<E>;
+			static constexpr auto no_node = std::numeric_limits<std::uint32_t>::max();
+
+			// out holds each node's arcs to distinct other nodes
+			contractor(std::vector<std::vector<arc>> out, contraction_options<E> const& options);
+			auto run() -> void;
+
+			// after run, each node's arcs to and from the nodes contracted after it
+			std::vector<std::vector<arc>> out_;
+			std::vector<std::vector<arc>> in_;
+			// the position of each node in the contraction order
+			std::vector<std::uint32_t> level_;
+
+		 private:
+			struct shortcut {
+				std::uint32_t from;
+				std::uint32_t to;
+				std::uint32_t middle;
+				E weight;
+			};
+
+			contraction_options<E> options_;
+			std::vector<std::int64_t> priority_;
+			std::vector<std::uint32_t> contracted_neighbours_;
+			std::vector<std::uint32_t> depth_;
+			// the nodes of the current round, which witness paths may not pass through
+			std::vector<char> contracting_;
+			std::vector<char> touched_;
+			// a witness search tree per worker
+			std::vector<shortest_path_tree<E>> trees_;
+			std::uint32_t next_level_ = 0;
+
+			// the shortcuts contracting v needs by witness searches settling up to settle_limit nodes,
+			// appended to found when it isn't null
+			auto shortcuts_of(std::uint32_t v,
+			                  std::size_t settle_limit,
+			                  shortest_path_tree<E>& tree,
+			                  std::vector<shortcut>* found) const -> std::size_t;
+			// Dijkstra from u avoiding v and the nodes being contracted, up to distance limit or until
+			// every out-neighbour of v is settled
+			auto witness_search(std::uint32_t u,
+			                    std::uint32_t v,
+			                    E limit,
+			                    std::size_t settle_limit,
+			                    shortest_path_tree<E>& tree) const -> void;
+			auto update_priority(std::uint32_t v, shortest_path_tree<E>& tree) -> void;
+			// whether v comes before every remaining neighbour, ties broken by a hash of the ids
+			[[nodiscard]] auto first_among_neighbours(std::uint32_t v) const noexcept -> bool;
+			auto contract(std::uint32_t v, std::vector<std::uint32_t>& touched) -> void;
+			auto add_shortcut(shortcut const& s) -> void;
+			// task(item, worker) for every item, the workers taking small batches in turn
+			template<typename F>
+			auto for_each(std::vector<std::uint32_t> const& items, F const& task) -> void;
+		};
+	} // namespace detail
+
+	template<typename N, typename E>
+	    requires std::is_arithmetic_v<E>
+	class contraction_hierarchy;
+
+	// Writes hierarchy to path, for load_hierarchy. N must be trivially copyable or std::string
+	template<typename N, typename E>
+	    requires std::is_arithmetic_v<E>
+	auto save_hierarchy(contraction_hierarchy<N, E> const& hierarchy, std::string const& path) -> void;
+	// Reads a hierarchy written by save_hierarchy, copying each section out of a read-only mapping
+	template<typename N, typename E>
+	    requires std::is_arithmetic_v<E>
+	auto load_hierarchy(std::string const& path) -> contraction_hierarchy<N, E>;
+
+	// Shortest path index over a snapshot of a graph with non-negative weights. Preprocessing
+	// contracts the nodes one by one in order of importance, adding a shortcut between two
+	// neighbours of a contracted node when the path through it is the only shortest one. A query
+	// then only has to search upwards, to nodes contracted later, from both ends. Build it once from
+	// a graph, or offline with save_hierarchy and load_hierarchy, and query it with a query object.
+	template<typename N, typename E>
+	    requires std::is_arithmetic_v<E>
+	class contraction_hierarchy {
+	 public:
+		static constexpr auto no_node = detail::contractor<E>::no_node;
+
+		// Answers queries on a hierarchy, which must outlive it. Queries reuse the search trees, so
+		// one query object serves one thread.
+		class query {
+		 public:
+			explicit query(contraction_hierarchy const& hierarchy);
+
+			// the distance from src to dst, std::nullopt if dst can't be reached
+			[[nodiscard]] auto distance(N const& src, N const& dst) -> std::optional<E>;
+			// the shortest path from src to dst with its shortcuts expanded into nodes of the graph
+			[[nodiscard]] auto path(N const& src, N const& dst) -> std::optional<shortest_path_result<N, E>>;
+			// how many nodes the last query settled in both directions
+			[[nodiscard]] auto settled_count() const noexcept -> std::size_t;
+
+		 private:
+			contraction_hierarchy const* hierarchy_;
+			shortest_path_tree<E> forward_;
+			shortest_path_tree<E> backward_;
+			// the highest node of the shortest path found
+			std::uint32_t meet_ = no_node;
+
+			auto search(std::uint32_t src, std::uint32_t dst) -> std::optional<E>;
+		};
+
+		explicit contraction_hierarchy(graph<N, E> const& g, contraction_options<E> const& options = {});
+
+		[[nodiscard]] auto node_count() const noexcept -> std::size_t;
+		// the arcs kept, shortcuts included
+		[[nodiscard]] auto arc_count() const noexcept -> std::size_t;
+		[[nodiscard]] auto shortcut_count() const noexcept -> std::size_t;
+
+	 private:
+		using arc = detail::hierarchy_arc<E>;
+
+		// sorted, a node's id is its position
+		std::vector<N> nodes_;
+		std::vector<std::uint32_t> level_;
+		std::vector<std::uint64_t> up_offsets_;
+		std::vector<arc> up_;
+		std::vector<std::uint64_t> down_offsets_;
+		std::vector<arc> down_;
+		std::size_t shortcut_count_ = 0;
+
+		contraction_hierarchy() = default;
+		[[nodiscard]] auto id_of(N const& value) const noexcept -> std::optional<std::uint32_t>;
+		// the arcs from id to nodes above it, and into id from nodes above it
+		[[nodiscard]] auto up(std::uint32_t id) const noexcept -> std::span<arc const>;
+		[[nodiscard]] auto down(std::uint32_t id) const noexcept -> std::span<arc const>;
+		// the arc from -> to, stored with whichever end is lower, nullptr if there is none
+		[[nodiscard]] auto find_arc(std::uint32_t from, std::uint32_t to) const noexcept -> arc const*;
+		// appends the nodes after from on the path an arc from -> to stands for
+		auto unpack(std::uint32_t from, std::uint32_t to, std::vector<N>& nodes) const -> void;
+
+		template<typename Node, typename Edge>
+		    requires std::is_arithmetic_v<Edge>
+		friend auto save_hierarchy(contraction_hierarchy<Node, Edge> const& hierarchy, std::string const& path)
+		    -> void;
+		template<typename Node, typename Edge>
+		    requires std::is_arithmetic_v<Edge>
+		friend auto load_hierarchy(std::string const& path) -> contraction_hierarchy<Node, Edge>;
+	};
+} // namespace gdwg
+
+template<typename E>
+gdwg::detail::contractor<E>::contractor(std::vector<std::vector<arc>> out, contraction_options<E> const& options)
+: out_(std::move(out))
+, in_(out_.size())
+, options_(options) {
+	for (auto from = std::uint32_t{0}; from < out_.size(); ++from) {
+		for (auto const& a : out_[from]) {
+			in_[a.target].push_back(arc{from, a.middle, a.weight});
+		}
+	}
+}
+template<typename E>
+auto gdwg::detail::contractor<E>::run() -> void {
+	auto const count = out_.size();
+	level_.assign(count, 0);
+	priority_.assign(count, 0);
+	contracted_neighbours_.assign(count, 0);
+	depth_.assign(count, 0);
+	contracting_.assign(count, 0);
+	touched_.assign(count, 0);
+	trees_.resize(std::max(std::size_t{1}, detail::worker_count(options_.threads)));
+	auto remaining = std::vector<std::uint32_t>(count);
+	for (auto id = std::uint32_t{0}; id < count; ++id) {
+		remaining[id] = id;
+	}
+	for_each(remaining, [this](std::uint32_t v, std::size_t worker) { update_priority(v, trees_[worker]); });
+	auto selected = std::vector<std::uint32_t>();
+	auto touched = std::vector<std::uint32_t>();
+	auto found = std::vector<std::vector<shortcut>>(trees_.size());
+	while (not remaining.empty()) {
+		selected.clear();
+		for (auto const v : remaining) {
+			if (first_among_neighbours(v)) {
+				selected.push_back(v);
+				contracting_[v] = 1;
+			}
+		}
+		for_each(selected, [this, &found](std::uint32_t v, std::size_t worker) {
+			shortcuts_of(v, options_.witness_limit, trees_[worker], &found[worker]);
+		});
+		touched.clear();
+		for (auto const v : selected) {
+			contract(v, touched);
+		}
+		for (auto& shortcuts : found) {
+			for (auto const& s : shortcuts) {
+				add_shortcut(s);
+			}
+			shortcuts.clear();
+		}
+		std::erase_if(remaining, [this](std::uint32_t v) { return contracting_[v] != 0; });
+		for (auto const v : selected) {
+			contracting_[v] = 0;
+		}
+		// the neighbours left with fewer arcs or new shortcuts
+		for_each(touched, [this](std::uint32_t v, std::size_t worker) { update_priority(v, trees_[worker]); });
+		for (auto const v : touched) {
+			touched_[v] = 0;
+		}
+	}
+	trees_.clear();
+}
+template<typename E>
+auto gdwg::detail::contractor<E>::witness_search(std::uint32_t u,
+                                                 std::uint32_t v,
+                                                 E limit,
+                                                 std::size_t settle_limit,
+                                                 shortest_path_tree<E>& tree) const -> void {
+	tree_search::start(tree, out_.size(), u, E{});
+	auto targets = out_[v].size();
+	while (not tree_search::empty(tree) and not(limit < tree_search::top(tree))
+	       and tree.settled_count() < settle_limit)
+	{
+		auto const x = tree_search::pop(tree);
+		auto const target = [x](arc const& a) { return a.target == x; };
+		if (std::any_of(out_[v].begin(), out_[v].end(), target) and --targets == 0) {
+			return;
+		}
+		auto const base = tree.distance(x);
+		for (auto const& a : out_[x]) {
+			if (a.target != v and contracting_[a.target] == 0) {
+				auto const distance = static_cast<E>(base + a.weight);
+				tree_search::relax(tree, a.target, distance, x, distance);
+			}
+		}
+	}
+}
+template<typename E>
+auto gdwg::detail::contractor<E>::shortcuts_of(std::uint32_t v,
+                                               std::size_t settle_limit,
+                                               shortest_path_tree<E>& tree,
+                                               std::vector<shortcut>* found) const -> std::size_t {
+	auto count = std::size_t{0};
+	for (auto const& into : in_[v]) {
+		auto const u = into.target;
+		auto limit = std::optional<E>();
+		for (auto const& onto : out_[v]) {
+			if (onto.target != u) {
+				auto const via = static_cast<E>(into.weight + onto.weight);
+				limit = limit ? std::max(*limit, via) : via;
+			}
+		}
+		if (not limit) {
+			continue;
+		}
+		witness_search(u, v, *limit, settle_limit, tree);
+		// a path reached without v is a witness however far the search got with it
+		for (auto const& onto : out_[v]) {
+			auto const w = onto.target;
+			auto const via = static_cast<E>(into.weight + onto.weight);
+			if (w != u and (not tree.reached(w) or via < tree.distance(w))) {
+				++count;
+				if (found != nullptr) {
+					found->push_back(shortcut{u, w, v, via});
+				}
+			}
+		}
+	}
+	return count;
+}
+template<typename E>
+auto gdwg::detail::contractor<E>::update_priority(std::uint32_t v, shortest_path_tree<E>& tree) -> void {
+	auto const added = static_cast<std::int64_t>(shortcuts_of(v, options_.estimate_limit, tree, nullptr));
+	auto const removed = static_cast<std::int64_t>(in_[v].size() + out_[v].size());
+	priority_[v] = 4 * (added - removed) + contracted_neighbours_[v] + depth_[v];
+}
+template<typename E>
+auto gdwg::detail::contractor<E>::first_among_neighbours(std::uint32_t v) const noexcept -> bool {
+	auto const key = [this](std::uint32_t id) {
+		return std::pair(priority_[id], id * std::uint32_t{2654435761U});
+	};
+	auto const before = [&](arc const& a) { return key(v) < key(a.target); };
+	return std::all_of(out_[v].begin(), out_[v].end(), before) and std::all_of(in_[v].begin(), in_[v].end(), before);
+}
+template<typename E>
+auto gdwg::detail::contractor<E>::contract(std::uint32_t v, std::vector<std::uint32_t>& touched) -> void {
+	level_[v] = next_level_++;
+	auto const detach = [&](std::vector<arc>& arcs, std::uint32_t neighbour) {
+		auto const it = std::find_if(arcs.begin(), arcs.end(), [v](arc const& a) { return a.target == v; });
+		*it = arcs.back();
+		arcs.pop_back();
+		++contracted_neighbours_[neighbour];
+		depth_[neighbour] = std::max(depth_[neighbour], depth_[v] + 1);
+		if (touched_[neighbour] == 0) {
+			touched_[neighbour] = 1;
+			touched.push_back(neighbour);
+		}
+	};
+	for (auto const& a : out_[v]) {
+		detach(in_[a.target], a.target);
+	}
+	for (auto const& a : in_[v]) {
+		detach(out_[a.target], a.target);
+	}
+}
+template<typename E>
+auto gdwg::detail::contractor<E>::add_shortcut(shortcut const& s) -> void {
+	// keeps the shorter of the arc already between the two and the shortcut
+	auto const merge = [&s](std::vector<arc>& arcs, std::uint32_t target) {
+		auto const it = std::find_if(arcs.begin(), arcs.end(), [target](arc const& a) { return a.target == target; });
+		if (it == arcs.end()) {
+			arcs.push_back(arc{target, s.middle, s.weight});
+		}
+		else if (s.weight < it->weight) {
+			it->middle = s.middle;
+			it->weight = s.weight;
+		}
+	};
+	merge(out_[s.from], s.to);
+	merge(in_[s.to], s.from);
+}
+template<typename E>
+template<typename F>
+auto gdwg::detail::contractor<E>::for_each(std::vector<std::uint32_t> const& items, F const& task) -> void {
+	auto constexpr batch = std::size_t{32};
+	auto const workers = std::min(trees_.size(), (items.size() + batch - 1) / batch);
+	auto next = std::atomic<std::size_t>(0);
+	detail::run_parallel(workers, [&](std::size_t worker) {
+		for (auto first = next.fetch_add(batch); first < items.size(); first = next.fetch_add(batch)) {
+			for (auto i = first; i < std::min(first + batch, items.size()); ++i) {
+				task(items[i], worker);
+			}
+		}
+	});
+}
+
+template<typename N, typename E>
+    requires std::is_arithmetic_v<E>
+gdwg::contraction_hierarchy<N, E>::contraction_hierarchy(graph<N, E> const& g, contraction_options<E> const& options)
+: nodes_(g.nodes()) {
+	auto const count = nodes_.size();
+	// ranks in value order become the hierarchy's ids
+	auto rank = std::vector<std::uint32_t>(g.id_bound(), no_node);
+	for (auto i = std::uint32_t{0}; i < count; ++i) {
+		rank[g.id_of(nodes_[i])] = i;
+	}
+	auto out = std::vector<std::vector<arc>>(count);
+	for (auto i = std::uint32_t{0}; i < count; ++i) {
+		for (auto const& edge : g.out_records(g.id_of(nodes_[i]))) {
+			auto const cost = edge.weight ? *edge.weight : options.unweighted_cost;
+			if constexpr (std::is_signed_v<E>) {
+				if (cost < E{}) {
+					throw std::runtime_error("Cannot call gdwg::contraction_hierarchy<N, E>::contraction_hierarchy on "
+					                         "a graph with a negative weight");
+				}
+			}
+			if (rank[edge.dst] != i) {
+				out[i].push_back(arc{rank[edge.dst], no_node, cost});
+			}
+		}
+		// only the cheapest of parallel edges can be on a shortest path
+		std::sort(out[i].begin(), out[i].end(), [](arc const& a, arc const& b) {
+			return a.target != b.target ? a.target < b.target : a.weight < b.weight;
+		});
+		auto const last = std::unique(out[i].begin(), out[i].end(), [](arc const& a, arc const& b) {
+			return a.target == b.target;
+		});
+		out[i].erase(last, out[i].end());
+	}
+	auto contracted = detail::contractor<E>(std::move(out), options);
+	contracted.run();
+	level_ = std::move(contracted.level_);
+	auto const flatten = [count](std::vector<std::vector<arc>>& lists,
+	                             std::vector<std::uint64_t>& offsets,
+	                             std::vector<arc>& arcs) {
+		offsets.assign(1, 0);
+		for (auto& list : lists) {
+			offsets.push_back(offsets.back() + list.size());
+		}
+		arcs.reserve(offsets[count]);
+		for (auto& list : lists) {
+			arcs.insert(arcs.end(), list.begin(), list.end());
+			list = std::vector<arc>();
+		}
+	};
+	flatten(contracted.out_, up_offsets_, up_);
+	flatten(contracted.in_, down_offsets_, down_);
+	auto const shortcut = [](arc const& a) { return a.middle != no_node; };
+	shortcut_count_ = static_cast<std::size_t>(std::count_if(up_.begin(), up_.end(), shortcut)
+	                                           + std::count_if(down_.begin(), down_.end(), shortcut));
+}
+template<typename N, typename E>
+    requires std::is_arithmetic_v<E>
+auto gdwg::contraction_hierarchy<N, E>::node_count() const noexcept -> std::size_t {
+	return nodes_.size();
+}
+template<typename N, typename E>
+    requires std::is_arithmetic_v<E>
+auto gdwg::contraction_hierarchy<N, E>::arc_count() const noexcept -> std::size_t {
+	return up_.size() + down_.size();
+}
+template<typename N, typename E>
+    requires std::is_arithmetic_v<E>
+auto gdwg::contraction_hierarchy<N, E>::shortcut_count() const noexcept -> std::size_t {
+	return shortcut_count_;
+}
+template<typename N, typename E>
+    requires std::is_arithmetic_v<E>
+auto gdwg::contraction_hierarchy<N, E>::id_of(N const& value) const noexcept -> std::optional<std::uint32_t> {
+	auto const it = std::lower_bound(nodes_.begin(), nodes_.end(), value);
+	if (it == nodes_.end() or value < *it) {
+		return std::nullopt;
+	}
+	return static_cast<std::uint32_t>(it - nodes_.begin());
+}
+template<typename N, typename E>
+    requires std::is_arithmetic_v<E>
+auto gdwg::contraction_hierarchy<N, E>::up(std::uint32_t id) const noexcept -> std::span<arc const> {
+	return std::span<arc const>(up_.data() + up_offsets_[id], up_.data() + up_offsets_[id + 1]);
+}
+template<typename N, typename E>
+    requires std::is_arithmetic_v<E>
+auto gdwg::contraction_hierarchy<N, E>::down(std::uint32_t id) const noexcept -> std::span<arc const> {
+	return std::span<arc const>(down_.data() + down_offsets_[id], down_.data() + down_offsets_[id + 1]);
+}
+template<typename N, typename E>
+    requires std::is_arithmetic_v<E>
+auto gdwg::contraction_hierarchy<N, E>::find_arc(std::uint32_t from, std::uint32_t to) const noexcept -> arc const* {
+	// an arc is stored with its lower end, and there is at most one between two nodes
+	auto const lower = level_[from] < level_[to];
+	auto const arcs = lower ? up(from) : down(to);
+	auto const other = lower ? to : from;
+	auto const found = std::find_if(arcs.begin(), arcs.end(), [other](arc const& x) { return x.target == other; });
+	return found == arcs.end() ? nullptr : &*found;
+}
+template<typename N, typename E>
+    requires std::is_arithmetic_v<E>
+auto gdwg::contraction_hierarchy<N, E>::unpack(std::uint32_t from, std::uint32_t to, std::vector<N>& nodes) const
+    -> void {
+	auto pending = std::vector<std::pair<std::uint32_t, std::uint32_t>>{{from, to}};
+	while (not pending.empty()) {
+		auto const [a, b] = pending.back();
+		pending.pop_back();
+		// the path came from the arcs, and load_hierarchy checks that a shortcut's two arcs exist
+		auto const& found = *find_arc(a, b);
+		if (found.middle == no_node) {
+			nodes.push_back(nodes_[b]);
+			continue;
+		}
+		pending.emplace_back(found.middle, b);
+		pending.emplace_back(a, found.middle);
+	}
+}
+
+template<typename N, typename E>
+    requires std::is_arithmetic_v<E>
+gdwg::contraction_hierarchy<N, E>::query::query(contraction_hierarchy const& hierarchy)
+: hierarchy_(&hierarchy) {}
+template<typename N, typename E>
+    requires std::is_arithmetic_v<E>
+auto gdwg::contraction_hierarchy<N, E>::query::distance(N const& src, N const& dst) -> std::optional<E> {
+	auto const s = hierarchy_->id_of(src);
+	auto const t = hierarchy_->id_of(dst);
+	if (not s or not t) {
+		throw std::runtime_error("Cannot call gdwg::contraction_hierarchy<N, E>::query::distance if src or dst node "
+		                         "don't exist in the hierarchy");
+	}
+	return search(*s, *t);
+}
+template<typename N, typename E>
+    requires std::is_arithmetic_v<E>
+auto gdwg::contraction_hierarchy<N, E>::query::path(N const& src, N const& dst)
+    -> std::optional<shortest_path_result<N, E>> {
+	auto const s = hierarchy_->id_of(src);
+	auto const t = hierarchy_->id_of(dst);
+	if (not s or not t) {
+		throw std::runtime_error("Cannot call gdwg::contraction_hierarchy<N, E>::query::path if src or dst node don't "
+		                         "exist in the hierarchy");
+	}
+	auto const distance = search(*s, *t);
+	if (not distance) {
+		return std::nullopt;
+	}
+	// the arcs of the upward search trees, s up to meet_ and down again to t
+	auto chain = std::vector<std::uint32_t>();
+	for (auto id = meet_; id != no_node; id = forward_.predecessor(id)) {
+		chain.push_back(id);
+	}
+	std::reverse(chain.begin(), chain.end());
+	for (auto id = backward_.predecessor(meet_); id != no_node; id = backward_.predecessor(id)) {
+		chain.push_back(id);
+	}
+	auto result = shortest_path_result<N, E>{*distance, {hierarchy_->nodes_[*s]}};
+	for (auto i = std::size_t{1}; i < chain.size(); ++i) {
+		hierarchy_->unpack(chain[i - 1], chain[i], result.nodes);
+	}
+	return result;
+}
+template<typename N, typename E>
+    requires std::is_arithmetic_v<E>
+auto gdwg::contraction_hierarchy<N, E>::query::settled_count() const noexcept -> std::size_t {
+	return forward_.settled_count() + backward_.settled_count();
+}
+template<typename N, typename E>
+    requires std::is_arithmetic_v<E>
+auto gdwg::contraction_hierarchy<N, E>::query::search(std::uint32_t src, std::uint32_t dst) -> std::optional<E> {
+	using search = detail::tree_search;
+	auto const& h = *hierarchy_;
+	search::start(forward_, h.nodes_.size(), src, E{});
+	search::start(backward_, h.nodes_.size(), dst, E{});
+	auto best = std::optional<E>();
+	meet_ = no_node;
+	// each direction stops once its nearest node is no nearer than the best path met
+	auto const open = [&best](shortest_path_tree<E> const& tree) {
+		return not search::empty(tree) and (not best or search::top(tree) < *best);
+	};
+	while (true) {
+		auto const forward_open = open(forward_);
+		auto const backward_open = open(backward_);
+		if (not forward_open and not backward_open) {
+			break;
+		}
+		auto const forwards =
+		    forward_open and (not backward_open or not(search::top(backward_) < search::top(forward_)));
+		auto& tree = forwards ? forward_ : backward_;
+		auto const& other = forwards ? backward_ : forward_;
+		auto const id = search::pop(tree);
+		auto const base = tree.distance(id);
+		if (other.reached(id)) {
+			auto const length = static_cast<E>(base + other.distance(id));
+			if (not best or length < *best) {
+				best = length;
+				meet_ = id;
+			}
+		}
+		// stall on demand: a node reached more cheaply from above can't lead upwards to anything
+		// more cheaply than that node does
+		auto const from_above = forwards ? h.down(id) : h.up(id);
+		auto const stalled = std::any_of(from_above.begin(), from_above.end(), [&](arc const& a) {
+			return tree.reached(a.target) and tree.distance(a.target) + a.weight < base;
+		});
+		if (stalled) {
+			continue;
+		}
+		for (auto const& a : forwards ? h.up(id) : h.down(id)) {
+			auto const distance = static_cast<E>(base + a.weight);
+			search::relax(tree, a.target, distance, id, distance);
+		}
+	}
+	return best;
+}
+
+template<typename N, typename E>
+    requires std::is_arithmetic_v<E>
+auto gdwg::save_hierarchy(contraction_hierarchy<N, E> const& hierarchy, std::string const& path) -> void {
+	using arc = detail::hierarchy_arc<E>;
+	static_assert(std::is_same_v<N, std::string> or std::is_trivially_copyable_v<N>,
+	              "save_hierarchy nodes must be trivially copyable or std::string");
+	auto const aligned = [](std::uint64_t at) {
+		return (at + detail::snapshot_alignment - 1) / detail::snapshot_alignment * detail::snapshot_alignment;
+	};
+	auto header = detail::hierarchy_header();
+	std::memset(&header, 0, sizeof(header));
+	header.magic = detail::hierarchy_magic;
+	header.version = detail::hierarchy_version;
+	header.byte_order = detail::snapshot_byte_order;
+	header.node_size = std::is_same_v<N, std::string> ? 0 : static_cast<std::uint32_t>(sizeof(N));
+	header.weight_size = static_cast<std::uint32_t>(sizeof(E));
+	header.node_count = hierarchy.nodes_.size();
+	header.up_count = hierarchy.up_.size();
+	header.down_count = hierarchy.down_.size();
+	header.shortcut_count = hierarchy.shortcut_count_;
+	header.nodes_at = aligned(sizeof(header));
+	auto names_size = std::uint64_t{0};
+	if constexpr (std::is_same_v<N, std::string>) {
+		for (auto const& value : hierarchy.nodes_) {
+			names_size += value.size();
+		}
+		header.names_at = aligned(header.nodes_at + (header.node_count + 1) * sizeof(std::uint64_t));
+		header.levels_at = aligned(header.names_at + names_size);
+	}
+	else {
+		header.levels_at = aligned(header.nodes_at + header.node_count * sizeof(N));
+	}
+	header.up_offsets_at = aligned(header.levels_at + header.node_count * sizeof(std::uint32_t));
+	header.up_at = aligned(header.up_offsets_at + (header.node_count + 1) * sizeof(std::uint64_t));
+	header.down_offsets_at = aligned(header.up_at + header.up_count * sizeof(arc));
+	header.down_at = aligned(header.down_offsets_at + (header.node_count + 1) * sizeof(std::uint64_t));
+	header.file_size = header.down_at + header.down_count * sizeof(arc);
+
+	auto out = std::ofstream(path, std::ios::binary | std::ios::trunc);
+	if (!out) {
+		throw std::runtime_error("Cannot open " + path + " for writing");
+	}
+	auto written = std::uint64_t{0};
+	auto const write = [&](void const* data, std::size_t size) {
+		out.write(static_cast<char const*>(data), static_cast<std::streamsize>(size));
+		written += size;
+	};
+	auto const pad_to = [&](std::uint64_t at) {
+		static constexpr auto zeros = std::array<char, detail::snapshot_alignment>{};
+		write(zeros.data(), static_cast<std::size_t>(at - written));
+	};
+	write(&header, sizeof(header));
+	pad_to(header.nodes_at);
+	if constexpr (std::is_same_v<N, std::string>) {
+		auto at = std::uint64_t{0};
+		write(&at, sizeof(at));
+		for (auto const& value : hierarchy.nodes_) {
+			at += value.size();
+			write(&at, sizeof(at));
+		}
+		pad_to(header.names_at);
+		for (auto const& value : hierarchy.nodes_) {
+			write(value.data(), value.size());
+		}
+	}
+	else {
+		write(hierarchy.nodes_.data(), hierarchy.nodes_.size() * sizeof(N));
+	}
+	// the remaining sections are written straight from memory
+	pad_to(header.levels_at);
+	write(hierarchy.level_.data(), hierarchy.level_.size() * sizeof(std::uint32_t));
+	pad_to(header.up_offsets_at);
+	write(hierarchy.up_offsets_.data(), hierarchy.up_offsets_.size() * sizeof(std::uint64_t));
+	pad_to(header.up_at);
+	write(hierarchy.up_.data(), hierarchy.up_.size() * sizeof(arc));
+	pad_to(header.down_offsets_at);
+	write(hierarchy.down_offsets_.data(), hierarchy.down_offsets_.size() * sizeof(std::uint64_t));
+	pad_to(header.down_at);
+	write(hierarchy.down_.data(), hierarchy.down_.size() * sizeof(arc));
+	out.close();
+	if (!out) {
+		throw std::runtime_error("Cannot write " + path);
+	}
+}
+template<typename N, typename E>
+    requires std::is_arithmetic_v<E>
+auto gdwg::load_hierarchy(std::string const& path) -> contraction_hierarchy<N, E> {
+	using arc = detail::hierarchy_arc<E>;
+	static constexpr auto string_nodes = std::is_same_v<N, std::string>;
+	static_assert(string_nodes or std::is_trivially_copyable_v<N>,
+	              "load_hierarchy nodes must be trivially copyable or std::string");
+	auto const file = detail::mapped_file(path);
+	auto const invalid = [&path] {
+		return std::runtime_error("Cannot call gdwg::load_hierarchy on " + path
+		                          + ", it isn't a contraction hierarchy of this graph type");
+	};
+	auto header = detail::hierarchy_header();
+	if (file.size() < sizeof(header)) {
+		throw invalid();
+	}
+	std::memcpy(&header, file.data(), sizeof(header));
+	auto const node_size = string_nodes ? 0 : sizeof(N);
+	if (header.magic != detail::hierarchy_magic or header.version != detail::hierarchy_version
+	    or header.byte_order != detail::snapshot_byte_order or header.node_size != node_size
+	    or header.weight_size != sizeof(E) or header.file_size != file.size()
+	    or header.node_count >= contraction_hierarchy<N, E>::no_node)
+	{
+		throw invalid();
+	}
+	// every section has to lie inside the file before anything is read from it
+	auto const fits = [&header](std::uint64_t at, std::uint64_t count, std::uint64_t size) {
+		return at % detail::snapshot_alignment == 0 and at <= header.file_size
+		       and count <= (header.file_size - at) / size;
+	};
+	auto const offsets = header.node_count + 1;
+	if (!fits(header.nodes_at, string_nodes ? offsets : header.node_count, string_nodes ? 8 : node_size)
+	    or !fits(header.levels_at, header.node_count, sizeof(std::uint32_t))
+	    or !fits(header.up_offsets_at, offsets, sizeof(std::uint64_t))
+	    or !fits(header.up_at, header.up_count, sizeof(arc))
+	    or !fits(header.down_offsets_at, offsets, sizeof(std::uint64_t))
+	    or !fits(header.down_at, header.down_count, sizeof(arc)))
+	{
+		throw invalid();
+	}
+	auto const* const base = file.data();
+	auto const section = [base](auto& into, std::uint64_t at, std::uint64_t count) {
+		using value_type = typename std::remove_reference_t<decltype(into)>::value_type;
+		auto const* const first = reinterpret_cast<value_type const*>(base + at);
+		into.assign(first, first + count);
+	};
+	auto result = contraction_hierarchy<N, E>();
+	auto const count = static_cast<std::size_t>(header.node_count);
+	if constexpr (string_nodes) {
+		auto const* const name_offsets = reinterpret_cast<std::uint64_t const*>(base + header.nodes_at);
+		if (!fits(header.names_at, name_offsets[count], 1)) {
+			throw invalid();
+		}
+		result.nodes_.reserve(count);
+		for (auto i = std::size_t{0}; i < count; ++i) {
+			if (name_offsets[i + 1] < name_offsets[i]) {
+				throw invalid();
+			}
+			result.nodes_.emplace_back(base + header.names_at + name_offsets[i],
+			                           static_cast<std::size_t>(name_offsets[i + 1] - name_offsets[i]));
+		}
+	}
+	else {
+		section(result.nodes_, header.nodes_at, count);
+	}
+	section(result.level_, header.levels_at, count);
+	section(result.up_offsets_, header.up_offsets_at, offsets);
+	section(result.up_, header.up_at, header.up_count);
+	section(result.down_offsets_, header.down_offsets_at, offsets);
+	section(result.down_, header.down_at, header.down_count);
+	// queries index with what was read, so it has to describe a hierarchy of count nodes
+	auto const valid_arcs = [count](std::vector<std::uint64_t> const& at, std::vector<arc> const& arcs) {
+		if (at.front() != 0 or at.back() != arcs.size() or not std::is_sorted(at.begin(), at.end())) {
+			return false;
+		}
+		return std::all_of(arcs.begin(), arcs.end(), [count](arc const& a) {
+			return a.target < count and (a.middle < count or a.middle == contraction_hierarchy<N, E>::no_node);
+		});
+	};
+	if (not valid_arcs(result.up_offsets_, result.up_) or not valid_arcs(result.down_offsets_, result.down_)) {
+		throw invalid();
+	}
+	// id_of searches the nodes, and unpack finds arcs by comparing levels
+	auto const out_of_order = [](N const& a, N const& b) { return !(a < b); };
+	if (std::adjacent_find(result.nodes_.begin(), result.nodes_.end(), out_of_order) != result.nodes_.end()) {
+		throw invalid();
+	}
+	auto taken = std::vector<bool>(count);
+	for (auto const level : result.level_) {
+		if (level >= count or taken[level]) {
+			throw invalid();
+		}
+		taken[level] = true;
+	}
+	// every arc leads up from the node it's stored with. A shortcut's middle is below both ends and
+	// the two arcs it stands for exist, so unpacking one always finds its parts and gets lower each time
+	auto const valid_arc = [&result](std::uint32_t from, std::uint32_t to, std::uint32_t middle) {
+		auto const& level = result.level_;
+		return middle == contraction_hierarchy<N, E>::no_node
+		       or (level[middle] < level[from] and level[middle] < level[to] and result.find_arc(from, middle)
+		           and result.find_arc(middle, to));
+	};
+	for (auto v = std::uint32_t{0}; v < count; ++v) {
+		for (auto const& a : result.up(v)) {
+			if (result.level_[a.target] <= result.level_[v] or !valid_arc(v, a.target, a.middle)) {
+				throw invalid();
+			}
+		}
+		for (auto const& a : result.down(v)) {
+			if (result.level_[a.target] <= result.level_[v] or !valid_arc(a.target, v, a.middle)) {
+				throw invalid();
+			}
+		}
+	}
+	result.shortcut_count_ = static_cast<std::size_t>(header.shortcut_count);
+	return result;
+}
+#endif // GDWG_CONTRACTION_HIERARCHY_H
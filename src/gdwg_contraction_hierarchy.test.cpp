@@ -0,0 +1,193 @@
+#include "gdwg_contraction_hierarchy.h"
+#include "gdwg_test_graphs.h"
+
+#include <catch2/catch.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace {
+	// checks every query on hierarchy against Dijkstra on g, and that each path adds up to its distance
+	auto check_queries(gdwg::graph<int, int> const& g, gdwg::contraction_hierarchy<int, int> const& hierarchy, int cost)
+	    -> void {
+		auto tree = gdwg::shortest_path_tree<int>();
+		auto query = gdwg::contraction_hierarchy<int, int>::query(hierarchy);
+		auto const nodes = g.nodes();
+		for (auto const src : nodes) {
+			gdwg::shortest_paths(g, src, tree, {.unweighted_cost = cost});
+			for (auto const dst : nodes) {
+				auto const id = g.id_of(dst);
+				auto const distance = query.distance(src, dst);
+				REQUIRE(distance.has_value() == tree.reached(id));
+				if (not distance) {
+					continue;
+				}
+				CHECK(*distance == tree.distance(id));
+				auto const path = query.path(src, dst);
+				REQUIRE(path);
+				CHECK(path->distance == *distance);
+				REQUIRE(path->nodes.front() == src);
+				REQUIRE(path->nodes.back() == dst);
+				CHECK(gdwg::test::path_cost(g, path->nodes, cost) == *distance);
+			}
+		}
+	}
+} // namespace
+
+TEST_CASE("contraction_hierarchy: queries match Dijkstra on random graphs") {
+	auto const cases = {std::tuple(30, 60, 1U), std::tuple(60, 240, 2U), std::tuple(80, 120, 3U)};
+	for (auto const& [nodes, edges, seed] : cases) {
+		auto const g = gdwg::test::random_graph(nodes, edges, 40, seed);
+		// a small witness limit keeps shortcuts a longer search would have found unnecessary
+		for (auto const limit : {std::size_t{500}, std::size_t{2}}) {
+			auto const options = gdwg::contraction_options<int>{.unweighted_cost = 5, .witness_limit = limit};
+			auto const hierarchy = gdwg::contraction_hierarchy<int, int>(g, options);
+			CHECK(hierarchy.node_count() == static_cast<std::size_t>(nodes));
+			CHECK(hierarchy.shortcut_count() <= hierarchy.arc_count());
+			check_queries(g, hierarchy, 5);
+		}
+	}
+}
+TEST_CASE("contraction_hierarchy: parallel preprocessing gives the same distances") {
+	// a 12 x 12 grid with streets both ways, contracted on several workers
+	auto g = gdwg::graph<int, int>();
+	auto rng = std::mt19937(4);
+	auto weight = std::uniform_int_distribution<int>(1, 9);
+	for (auto i = 0; i < 144; ++i) {
+		g.insert_node(i);
+	}
+	for (auto x = 0; x < 12; ++x) {
+		for (auto y = 0; y < 12; ++y) {
+			if (x + 1 < 12) {
+				g.insert_edge(x * 12 + y, (x + 1) * 12 + y, weight(rng));
+				g.insert_edge((x + 1) * 12 + y, x * 12 + y, weight(rng));
+			}
+			if (y + 1 < 12) {
+				g.insert_edge(x * 12 + y, x * 12 + y + 1, weight(rng));
+				g.insert_edge(x * 12 + y + 1, x * 12 + y, weight(rng));
+			}
+		}
+	}
+	auto const sequential = gdwg::contraction_hierarchy<int, int>(g, {.threads = 1});
+	auto const parallel = gdwg::contraction_hierarchy<int, int>(g, {.threads = 4});
+	check_queries(g, sequential, 1);
+	check_queries(g, parallel, 1);
+
+	// an upward search settles a fraction of what Dijkstra does
+	auto query = gdwg::contraction_hierarchy<int, int>::query(parallel);
+	auto tree = gdwg::shortest_path_tree<int>();
+	static_cast<void>(query.distance(0, 143));
+	static_cast<void>(gdwg::shortest_path(g, 0, 143, tree));
+	CHECK(query.settled_count() < tree.settled_count());
+}
+TEST_CASE("contraction_hierarchy: saved and loaded hierarchies answer the same queries") {
+	auto g = gdwg::graph<std::string, double>{"a", "b", "c", "d", "e"};
+	g.insert_edge("a", "b", 1.5);
+	g.insert_edge("b", "c", 2.0);
+	g.insert_edge("a", "c", 4.0);
+	g.insert_edge("c", "d");
+	g.insert_edge("d", "a", 0.5);
+	auto const built = gdwg::contraction_hierarchy<std::string, double>(g);
+	auto const path = std::string("gdwg_contraction_hierarchy_test.bin");
+	gdwg::save_hierarchy(built, path);
+	auto const loaded = gdwg::load_hierarchy<std::string, double>(path);
+	CHECK(loaded.node_count() == built.node_count());
+	CHECK(loaded.arc_count() == built.arc_count());
+	CHECK(loaded.shortcut_count() == built.shortcut_count());
+
+	auto query = gdwg::contraction_hierarchy<std::string, double>::query(loaded);
+	auto const found = query.path("a", "d");
+	REQUIRE(found);
+	CHECK(found->distance == 4.5);
+	CHECK(found->nodes == std::vector<std::string>{"a", "b", "c", "d"});
+	CHECK(query.distance("d", "c") == 4.0);
+	CHECK_FALSE(query.distance("a", "e"));
+	CHECK(query.distance("e", "e") == 0.0);
+	CHECK_THROWS_WITH(query.distance("a", "f"),
+	                  "Cannot call gdwg::contraction_hierarchy<N, E>::query::distance if src or dst node don't exist "
+	                  "in the hierarchy");
+
+	auto const load_ints = [&path] { return gdwg::load_hierarchy<int, double>(path); };
+	CHECK_THROWS_WITH(load_ints(),
+	                  "Cannot call gdwg::load_hierarchy on " + path + ", it isn't a contraction hierarchy of this "
+	                  "graph type");
+	std::ofstream(path) << "GDWGCHIE";
+	auto const load = [&path] { return gdwg::load_hierarchy<std::string, double>(path); };
+	CHECK_THROWS_WITH(load(),
+	                  "Cannot call gdwg::load_hierarchy on " + path + ", it isn't a contraction hierarchy of this "
+	                  "graph type");
+	std::remove(path.c_str());
+
+	g.insert_edge("e", "a", -1.0);
+	auto const negative = [&g] { return gdwg::contraction_hierarchy<std::string, double>(g); };
+	CHECK_THROWS_WITH(negative(),
+	                  "Cannot call gdwg::contraction_hierarchy<N, E>::contraction_hierarchy on a graph with a "
+	                  "negative weight");
+}
+TEST_CASE("contraction_hierarchy: load_hierarchy rejects hierarchies a query can't follow") {
+	auto const built = gdwg::contraction_hierarchy<int, int>(gdwg::test::random_graph(40, 120, 40, 7));
+	REQUIRE(built.shortcut_count() > 0);
+	auto const path = std::string("gdwg_contraction_hierarchy_corrupt.bin");
+	gdwg::save_hierarchy(built, path);
+	auto const bytes = [&path] {
+		auto in = std::ifstream(path, std::ios::binary);
+		return std::vector<char>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+	}();
+	auto header = gdwg::detail::hierarchy_header();
+	std::memcpy(&header, bytes.data(), sizeof(header));
+	auto const read = [&bytes](std::uint64_t at) {
+		auto value = std::uint32_t{0};
+		std::memcpy(&value, bytes.data() + at, sizeof(value));
+		return value;
+	};
+	// saves the hierarchy with the 32 bit value at byte at replaced, and tries to load it
+	auto const loads_with = [&](std::uint64_t at, std::uint32_t value) {
+		auto copy = bytes;
+		std::memcpy(copy.data() + at, &value, sizeof(value));
+		std::ofstream(path, std::ios::binary).write(copy.data(), std::ssize(copy));
+		try {
+			static_cast<void>(gdwg::load_hierarchy<int, int>(path));
+		} catch (std::runtime_error const&) {
+			return false;
+		}
+		return true;
+	};
+	CHECK(loads_with(header.nodes_at, read(header.nodes_at)));
+	// the nodes aren't sorted, or two nodes share a level
+	CHECK_FALSE(loads_with(header.nodes_at, read(header.nodes_at + 4)));
+	CHECK_FALSE(loads_with(header.levels_at + 4, read(header.levels_at)));
+
+	// an arc leads back to the node it's stored with, or a shortcut bypasses one of its own ends
+	using arc = gdwg::detail::hierarchy_arc<int>;
+	auto const offset = [&](std::uint64_t at) {
+		auto value = std::uint64_t{0};
+		std::memcpy(&value, bytes.data() + at, sizeof(value));
+		return value;
+	};
+	auto looped = false;
+	auto bypassed = false;
+	for (auto v = std::uint32_t{0}; v < header.node_count; ++v) {
+		for (auto i = offset(header.up_offsets_at + 8 * v); i < offset(header.up_offsets_at + 8 * (v + 1)); ++i) {
+			auto const at = header.up_at + i * sizeof(arc);
+			if (not looped) {
+				CHECK_FALSE(loads_with(at, v));
+				looped = true;
+			}
+			if (not bypassed and read(at + 4) != built.no_node) {
+				CHECK_FALSE(loads_with(at + 4, read(at)));
+				bypassed = true;
+			}
+		}
+	}
+	CHECK(looped);
+	CHECK(bypassed);
+	std::remove(path.c_str());
+}
@@ -0,0 +1,366 @@
+#ifndef GDWG_DELTA_STEPPING_H
+#define GDWG_DELTA_STEPPING_H
+#include "gdwg_graph.h"
+
+#include <algorithm>
+#include <atomic>
+#include <barrier>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+namespace gdwg {
+	template<typename E>
+	struct delta_stepping_options {
+		// the cost of an unweighted edge
+		E unweighted_cost = E{1};
+		// the width of a bucket, edges costing more than it are heavy. Zero picks the largest cost
+		// over the average out-degree
+		E delta = E{};
+		// worker threads, 0 for one per core
+		std::size_t threads = 0;
+	};
+
+	template<typename E>
+	class delta_stepping_workspace;
+	namespace detail {
+		template<typename N, typename E>
+		auto delta_stepping(graph<N, E> const& g,
+		                    typename graph<N, E>::node_id src,
+		                    delta_stepping_workspace<E>& workspace,
+		                    delta_stepping_options<E> const& options) -> void;
+	} // namespace detail
+
+	// Distances by node id from the last delta_stepping run with this workspace, and the buckets
+	// and per-worker lists it used, which a later run reuses.
+	template<typename E>
+	class delta_stepping_workspace {
+	 public:
+		// whether the last search reached id
+		[[nodiscard]] auto reached(std::size_t id) const noexcept -> bool;
+		// the distance of a reached id
+		[[nodiscard]] auto distance(std::size_t id) const -> E;
+
+	 private:
+		static constexpr auto unreached = std::numeric_limits<E>::max();
+
+		std::vector<E> distance_;
+		// the distance each node was last expanded at, so stale and repeated bucket entries are skipped
+		std::vector<E> expanded_;
+		// bucket i is buckets_[i % buckets_.size()] while it is less than buckets_.size() ahead of the
+		// one being emptied, entries further ahead wait in overflow_ as (bucket, id)
+		std::vector<std::vector<std::uint32_t>> buckets_;
+		std::vector<std::pair<std::size_t, std::uint32_t>> overflow_;
+		// the nodes the workers are expanding
+		std::vector<std::uint32_t> frontier_;
+		// per worker, the (bucket, id) entries of the nodes it improved and the nodes it expanded
+		// from the current bucket, whose heavy edges are relaxed once the bucket stays empty
+		std::vector<std::vector<std::pair<std::size_t, std::uint32_t>>> inserted_;
+		std::vector<std::vector<std::uint32_t>> settled_;
+
+		template<typename N, typename Edge>
+		friend auto detail::delta_stepping(graph<N, Edge> const& g,
+		                                   typename graph<N, Edge>::node_id src,
+		                                   delta_stepping_workspace<Edge>& workspace,
+		                                   delta_stepping_options<Edge> const& options) -> void;
+	};
+
+	// Parallel single source shortest paths by delta-stepping. Nodes are kept in buckets of
+	// distance width options.delta. The workers empty the lowest bucket together, relaxing light
+	// edges with atomic minimum updates until no node falls back into it, then relax the heavy edges
+	// of everything it held. Weights must be finite and not negative. Distances are exact for
+	// integral E; for floating point E they may differ from shortest_paths by rounding.
+	template<typename N, typename E>
+	    requires std::is_arithmetic_v<E>
+	auto delta_stepping(graph<N, E> const& g,
+	                    N const& src,
+	                    delta_stepping_workspace<E>& workspace,
+	                    delta_stepping_options<E> const& options = {}) -> void;
+} // namespace gdwg
+
+template<typename E>
+auto gdwg::delta_stepping_workspace<E>::reached(std::size_t id) const noexcept -> bool {
+	return id < distance_.size() and distance_[id] != unreached;
+}
+template<typename E>
+auto gdwg::delta_stepping_workspace<E>::distance(std::size_t id) const -> E {
+	if (not reached(id)) {
+		throw std::runtime_error("Cannot call gdwg::delta_stepping_workspace<E>::distance on a node the search didn't "
+		                         "reach");
+	}
+	return distance_[id];
+}
+
+template<typename N, typename E>
+auto gdwg::detail::delta_stepping(graph<N, E> const& g,
+                                  typename graph<N, E>::node_id src,
+                                  delta_stepping_workspace<E>& workspace,
+                                  delta_stepping_options<E> const& options) -> void {
+	static_assert(std::atomic_ref<E>::is_always_lock_free and std::atomic_ref<E>::required_alignment == alignof(E),
+	              "delta_stepping weights must be lock free atomics in place");
+	auto constexpr unreached = delta_stepping_workspace<E>::unreached;
+	auto constexpr chunk = std::size_t{64};
+	// floating point buckets past this one are merged rather than overflowing the index
+	auto constexpr last_bucket = std::size_t{1} << 52;
+	auto constexpr no_bucket = std::numeric_limits<std::size_t>::max();
+	if constexpr (std::is_floating_point_v<E>) {
+		if (not std::isfinite(options.delta)) {
+			throw std::runtime_error("Cannot call gdwg::delta_stepping with a delta that isn't finite");
+		}
+	}
+	auto& ws = workspace;
+	auto const ids = g.id_bound();
+	// a worker per thousand ids at most, smaller graphs aren't worth the synchronisation
+	auto const workers = std::min(detail::worker_count(options.threads), std::max(std::size_t{1}, ids / 1024));
+	auto const cost_of = [&options](auto const& edge) { return edge.weight ? *edge.weight : options.unweighted_cost; };
+
+	// resets the distances and finds the largest cost, to size the buckets
+	ws.distance_.resize(ids);
+	ws.expanded_.resize(ids);
+	auto largest = std::vector<E>(workers, E{});
+	auto edges = std::vector<std::size_t>(workers, 0);
+	detail::run_parallel(workers, [&](std::size_t w) {
+		auto const first = ids * w / workers;
+		auto const last = ids * (w + 1) / workers;
+		std::fill(ws.distance_.begin() + static_cast<std::ptrdiff_t>(first),
+		          ws.distance_.begin() + static_cast<std::ptrdiff_t>(last),
+		          unreached);
+		std::fill(ws.expanded_.begin() + static_cast<std::ptrdiff_t>(first),
+		          ws.expanded_.begin() + static_cast<std::ptrdiff_t>(last),
+		          unreached);
+		for (auto id = first; id < last; ++id) {
+			auto const records = g.out_records(static_cast<std::uint32_t>(id));
+			for (auto const& edge : records) {
+				auto const cost = cost_of(edge);
+				if constexpr (std::is_floating_point_v<E>) {
+					if (not std::isfinite(cost)) {
+						throw std::runtime_error("Cannot call gdwg::delta_stepping on a graph with an infinite or NaN "
+						                         "weight");
+					}
+				}
+				if constexpr (std::is_signed_v<E>) {
+					if (cost < E{}) {
+						throw std::runtime_error("Cannot call gdwg::delta_stepping on a graph with a negative weight");
+					}
+				}
+				largest[w] = std::max(largest[w], cost);
+			}
+			edges[w] += records.size();
+		}
+	});
+	auto const max_cost = *std::max_element(largest.begin(), largest.end());
+	auto delta = options.delta;
+	if (not(E{} < delta)) {
+		auto const edge_count = std::max(std::size_t{1}, std::accumulate(edges.begin(), edges.end(), std::size_t{0}));
+		auto const degree = std::max(std::size_t{1}, edge_count / std::max(std::size_t{1}, g.id_bound()));
+		delta = static_cast<E>(max_cost / static_cast<E>(degree));
+		if (not(E{} < delta)) {
+			delta = E{1};
+		}
+	}
+	auto const bucket_of = [delta](E distance) {
+		if constexpr (std::is_floating_point_v<E>) {
+			auto const bucket = distance / delta;
+			return bucket < static_cast<E>(last_bucket) ? static_cast<std::size_t>(bucket) : last_bucket;
+		}
+		else {
+			return static_cast<std::size_t>(distance / delta);
+		}
+	};
+	// a relaxation lands at most max_cost past the end of the current bucket, but a small delta on
+	// large weights would need a ring far bigger than the graph, so it is capped
+	auto const count = std::min(bucket_of(max_cost) + 2, 64 + ids / 64);
+	ws.buckets_.resize(count);
+	for (auto& bucket : ws.buckets_) {
+		bucket.clear();
+	}
+	ws.overflow_.clear();
+	ws.inserted_.resize(workers);
+	ws.settled_.resize(workers);
+	for (auto w = std::size_t{0}; w < workers; ++w) {
+		ws.inserted_[w].clear();
+		ws.settled_[w].clear();
+	}
+	ws.distance_[src] = E{};
+	ws.frontier_.assign(1, src);
+
+	// the state the workers share, changed by worker 0 between two barriers
+	auto current = std::size_t{0};
+	auto overflow_first = no_bucket;
+	auto light = true;
+	auto done = false;
+	auto next = std::atomic<std::size_t>(0);
+	auto errors = std::vector<std::exception_ptr>(workers);
+	auto sync = std::barrier(static_cast<std::ptrdiff_t>(workers));
+	auto const relax = [&](std::uint32_t id, E distance, std::vector<std::pair<std::size_t, std::uint32_t>>& inserted) {
+		auto label = std::atomic_ref<E>(ws.distance_[id]);
+		auto old = label.load(std::memory_order_relaxed);
+		while (distance < old) {
+			if (label.compare_exchange_weak(old, distance, std::memory_order_relaxed)) {
+				inserted.emplace_back(bucket_of(distance), id);
+				return;
+			}
+		}
+	};
+	auto const expand = [&](std::size_t w) {
+		auto& inserted = ws.inserted_[w];
+		for (auto first = next.fetch_add(chunk); first < ws.frontier_.size(); first = next.fetch_add(chunk)) {
+			for (auto i = first; i < std::min(first + chunk, ws.frontier_.size()); ++i) {
+				auto const id = ws.frontier_[i];
+				auto const distance = std::atomic_ref<E>(ws.distance_[id]).load(std::memory_order_relaxed);
+				if (light) {
+					// entries left behind when a node moved to a nearer bucket, or already expanded
+					// at this distance, are skipped
+					if (bucket_of(distance) != current
+					    or std::atomic_ref<E>(ws.expanded_[id]).exchange(distance, std::memory_order_relaxed)
+					           == distance)
+					{
+						continue;
+					}
+					ws.settled_[w].push_back(id);
+				}
+				for (auto const& edge : g.out_records(id)) {
+					auto const cost = cost_of(edge);
+					if (not(delta < cost) == light) {
+						relax(edge.dst, static_cast<E>(distance + cost), inserted);
+					}
+				}
+			}
+		}
+	};
+	// buckets are never behind current, those within the ring go to it and the rest to the overflow
+	auto const file = [&](std::size_t bucket, std::uint32_t id) {
+		if (bucket - current < count) {
+			ws.buckets_[bucket % count].push_back(id);
+		}
+		else {
+			ws.overflow_.emplace_back(bucket, id);
+			overflow_first = std::min(overflow_first, bucket);
+		}
+	};
+	// moves the overflow entries the ring reaches now that current has moved on
+	auto const refile = [&] {
+		if (overflow_first == no_bucket or overflow_first - current >= count) {
+			return;
+		}
+		auto waiting = std::vector<std::pair<std::size_t, std::uint32_t>>();
+		std::swap(waiting, ws.overflow_);
+		overflow_first = no_bucket;
+		for (auto const& [bucket, id] : waiting) {
+			file(bucket, id);
+		}
+	};
+	// files the new entries, then picks the next frontier: the current bucket again while light
+	// relaxations refill it, the heavy edges of what it held, or the next bucket in use
+	auto const step = [&] {
+		for (auto& inserted : ws.inserted_) {
+			for (auto const& [bucket, id] : inserted) {
+				file(bucket, id);
+			}
+			inserted.clear();
+		}
+		next = 0;
+		ws.frontier_.clear();
+		if (light) {
+			auto& bucket = ws.buckets_[current % count];
+			if (not bucket.empty()) {
+				std::swap(ws.frontier_, bucket);
+				return;
+			}
+			light = false;
+			for (auto& settled : ws.settled_) {
+				ws.frontier_.insert(ws.frontier_.end(), settled.begin(), settled.end());
+				settled.clear();
+			}
+			return;
+		}
+		light = true;
+		// heavy edges only lead back into the current bucket once distances over delta saturate at
+		// last_bucket, that bucket is then emptied again until it stays empty
+		if (auto& bucket = ws.buckets_[current % count]; not bucket.empty()) {
+			std::swap(ws.frontier_, bucket);
+			return;
+		}
+		auto following = overflow_first;
+		for (auto ahead = std::size_t{1}; ahead < count; ++ahead) {
+			if (not ws.buckets_[(current + ahead) % count].empty()) {
+				following = std::min(following, current + ahead);
+				break;
+			}
+		}
+		if (following == no_bucket) {
+			done = true;
+			return;
+		}
+		current = following;
+		refile();
+		std::swap(ws.frontier_, ws.buckets_[current % count]);
+	};
+	// the workers stay at the barrier until everyone is done, so an exception is kept for later
+	auto const work = [&](std::size_t w) {
+		while (true) {
+			try {
+				expand(w);
+			} catch (...) {
+				errors[w] = std::current_exception();
+			}
+			sync.arrive_and_wait();
+			if (w == 0) {
+				try {
+					auto const failed =
+					    std::any_of(errors.begin(), errors.end(), [](std::exception_ptr const& e) { return bool(e); });
+					if (failed) {
+						done = true;
+					}
+					else {
+						step();
+					}
+				} catch (...) {
+					errors[0] = std::current_exception();
+					done = true;
+				}
+			}
+			sync.arrive_and_wait();
+			if (done) {
+				return;
+			}
+		}
+	};
+	// a worker whose thread can't be started leaves the barrier before the first phase, and the
+	// others take its share of the frontier
+	auto threads = std::vector<std::jthread>();
+	threads.reserve(workers - 1);
+	for (auto w = std::size_t{1}; w < workers; ++w) {
+		try {
+			threads.emplace_back(work, w);
+		} catch (...) {
+			sync.arrive_and_drop();
+		}
+	}
+	work(0);
+	threads.clear();
+	for (auto const& error : errors) {
+		if (error) {
+			std::rethrow_exception(error);
+		}
+	}
+}
+template<typename N, typename E>
+    requires std::is_arithmetic_v<E>
+auto gdwg::delta_stepping(graph<N, E> const& g,
+                          N const& src,
+                          delta_stepping_workspace<E>& workspace,
+                          delta_stepping_options<E> const& options) -> void {
+	if (not g.is_node(src)) {
+		throw std::runtime_error("Cannot call gdwg::delta_stepping if src doesn't exist in the graph");
+	}
+	detail::delta_stepping(g, g.id_of(src), workspace, options);
+}
+#endif // GDWG_DELTA_STEPPING_H
@@ -0,0 +1,106 @@
+#include "gdwg_delta_stepping.h"
+#include "gdwg_shortest_paths.h"
+#include "gdwg_test_graphs.h"
+
+#include <catch2/catch.hpp>
+
+#include <cstddef>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace {
+	// checks every distance from src against Dijkstra
+	auto check_distances(gdwg::graph<int, int> const& g, int src, gdwg::delta_stepping_options<int> const& options)
+	    -> void {
+		auto tree = gdwg::shortest_path_tree<int>();
+		gdwg::shortest_paths(g, src, tree, {.unweighted_cost = options.unweighted_cost});
+		auto workspace = gdwg::delta_stepping_workspace<int>();
+		gdwg::delta_stepping(g, src, workspace, options);
+		for (auto id = std::size_t{0}; id < g.id_bound(); ++id) {
+			REQUIRE(workspace.reached(id) == tree.reached(id));
+			if (tree.reached(id)) {
+				REQUIRE(workspace.distance(id) == tree.distance(id));
+			}
+		}
+	}
+} // namespace
+
+TEST_CASE("delta_stepping matches Dijkstra for any delta") {
+	auto const g = gdwg::test::random_graph(300, 900, 40, 1);
+	for (auto const delta : {0, 1, 3, 17, 40, 1000}) {
+		for (auto const src : {0, 10, 598}) {
+			check_distances(g, src, {.unweighted_cost = 7, .delta = delta, .threads = 1});
+		}
+	}
+	// zero weights keep nodes in the bucket they were found from
+	auto const zeros = gdwg::test::random_graph(200, 800, 1, 2);
+	for (auto const delta : {0, 1, 2}) {
+		check_distances(zeros, 0, {.unweighted_cost = 0, .delta = delta, .threads = 1});
+	}
+	// most buckets are too far ahead for the ring and wait in the overflow
+	auto const wide = gdwg::test::random_graph(300, 900, 1'000'000, 5);
+	for (auto const delta : {1, 1000}) {
+		check_distances(wide, 0, {.delta = delta, .threads = 1});
+	}
+}
+TEST_CASE("delta_stepping matches Dijkstra on several workers") {
+	// enough ids for four workers, with a few nodes erased and unreachable parts
+	auto g = gdwg::test::random_graph(6000, 15000, 100, 3);
+	for (auto i = 0; i < 6000; i += 97) {
+		g.erase_node(i * 2);
+	}
+	for (auto const threads : {std::size_t{2}, std::size_t{4}}) {
+		for (auto const delta : {0, 5, 60}) {
+			check_distances(g, 2, {.delta = delta, .threads = threads});
+		}
+	}
+	auto const wide = gdwg::test::random_graph(5000, 12000, 1'000'000, 6);
+	check_distances(wide, 0, {.delta = 3, .threads = 4});
+
+	// a workspace is reused across graphs of different sizes
+	auto workspace = gdwg::delta_stepping_workspace<int>();
+	gdwg::delta_stepping(g, 2, workspace, {.threads = 4});
+	auto const small = gdwg::test::random_graph(10, 20, 5, 4);
+	gdwg::delta_stepping(small, 0, workspace);
+	CHECK(workspace.reached(0));
+	CHECK(workspace.distance(0) == 0);
+	CHECK_FALSE(workspace.reached(small.id_bound()));
+}
+TEST_CASE("delta_stepping checks its arguments") {
+	auto g = gdwg::graph<std::string, double>{"a", "b", "c", "d"};
+	g.insert_edge("a", "b", 1.5);
+	g.insert_edge("b", "c", 0.25);
+	g.insert_edge("a", "c");
+	auto workspace = gdwg::delta_stepping_workspace<double>();
+	auto const a = std::string("a");
+	gdwg::delta_stepping(g, a, workspace, {.delta = 0.5});
+	CHECK(workspace.distance(g.id_of("b")) == 1.5);
+	CHECK(workspace.distance(g.id_of("c")) == 1.0);
+	CHECK_FALSE(workspace.reached(g.id_of("d")));
+	CHECK_THROWS_WITH(workspace.distance(g.id_of("d")),
+	                  "Cannot call gdwg::delta_stepping_workspace<E>::distance on a node the search didn't reach");
+
+	auto const missing = std::string("e");
+	CHECK_THROWS_WITH(gdwg::delta_stepping(g, missing, workspace),
+	                  "Cannot call gdwg::delta_stepping if src doesn't exist in the graph");
+	auto const infinite = std::numeric_limits<double>::infinity();
+	CHECK_THROWS_WITH(gdwg::delta_stepping(g, a, workspace, {.delta = infinite}),
+	                  "Cannot call gdwg::delta_stepping with a delta that isn't finite");
+	g.insert_edge("c", "d", infinite);
+	CHECK_THROWS_WITH(gdwg::delta_stepping(g, a, workspace),
+	                  "Cannot call gdwg::delta_stepping on a graph with an infinite or NaN weight");
+	g.erase_edge("c", "d", infinite);
+	g.insert_edge("c", "d", -1.0);
+	CHECK_THROWS_WITH(gdwg::delta_stepping(g, a, workspace),
+	                  "Cannot call gdwg::delta_stepping on a graph with a negative weight");
+
+	// with a tiny delta the distances past 2^52 buckets share the last one, heavy edges lead back into it
+	auto far = gdwg::graph<int, double>{1, 2, 3, 4};
+	far.insert_edge(1, 2, 1e4);
+	far.insert_edge(2, 3, 1.0);
+	far.insert_edge(3, 4, 1.0);
+	gdwg::delta_stepping(far, 1, workspace, {.delta = 1e-12, .threads = 1});
+	REQUIRE(workspace.reached(far.id_of(4)));
+	CHECK(workspace.distance(far.id_of(4)) == 10002.0);
+}
@@ -0,0 +1,262 @@
+#ifndef GDWG_FROZEN_GRAPH_H
+#define GDWG_FROZEN_GRAPH_H
+#include "gdwg_graph.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+namespace gdwg {
+	// Immutable compressed sparse row snapshot of a gdwg::graph. Nodes are stored sorted, so a
+	// node's id is its rank and ordering ids orders nodes. The out-edges of node i are the
+	// entries [offsets_[i], offsets_[i + 1]) of dst_ / weights_, sorted by (dst, weight).
+	template<typename N, typename E>
+	class frozen_graph {
+	 public:
+		using node_id = std::uint32_t;
+		using edge = gdwg::edge<N, E>;
+
+		class iterator {
+		 public:
+			using value_type = typename graph<N, E>::iterator::value_type;
+			using reference = const value_type;
+			using pointer = void;
+			using difference_type = std::ptrdiff_t;
+			using iterator_category = std::bidirectional_iterator_tag;
+
+			iterator() = default;
+			auto operator*() const -> const reference;
+			auto operator++() -> iterator&;
+			auto operator++(int) -> iterator;
+			auto operator--() -> iterator&;
+			auto operator--(int) -> iterator;
+			auto operator==(iterator const& other) const -> bool;
+
+		 private:
+			const frozen_graph* g = nullptr;
+			std::size_t src = 0;
+			std::size_t pos = 0;
+			iterator(const frozen_graph* graph, std::size_t src, std::size_t pos);
+
+			friend class frozen_graph;
+		};
+
+		frozen_graph() = default;
+		explicit frozen_graph(graph<N, E> const& g);
+
+		// converts back into a mutable graph
+		[[nodiscard]] auto thaw() const -> graph<N, E>;
+
+		[[nodiscard]] auto is_node(N const& value) const noexcept -> bool;
+		[[nodiscard]] auto empty() const noexcept -> bool;
+		[[nodiscard]] auto is_connected(N const& src, N const& dst) const -> bool;
+		[[nodiscard]] auto nodes() const -> std::vector<N>;
+		[[nodiscard]] auto edges(N const& src, N const& dst) const -> std::vector<std::unique_ptr<edge>>;
+		[[nodiscard]] auto find(N const& src, N const& dst, std::optional<E> weight = std::nullopt) const -> iterator;
+		[[nodiscard]] auto connections(N const& src) const -> std::vector<N>;
+		[[nodiscard]] auto node_count() const noexcept -> std::size_t;
+		[[nodiscard]] auto edge_count() const noexcept -> std::size_t;
+
+		[[nodiscard]] auto begin() const -> iterator;
+		[[nodiscard]] auto end() const -> iterator;
+
+		[[nodiscard]] auto operator==(frozen_graph const& other) const noexcept -> bool = default;
+
+	 private:
+		std::vector<N> nodes_;
+		std::vector<std::size_t> offsets_ = std::vector<std::size_t>(1, 0);
+		std::vector<node_id> dst_;
+		std::vector<std::optional<E>> weights_;
+
+		[[nodiscard]] auto id_of(N const& value) const noexcept -> std::optional<node_id>;
+		// the [first, last) positions of the edges src -> dst
+		[[nodiscard]] auto edge_range(node_id src, node_id dst) const noexcept -> std::pair<std::size_t, std::size_t>;
+	};
+} // namespace gdwg
+template<typename N, typename E>
+auto gdwg::graph<N, E>::freeze() const -> frozen_graph<N, E> {
+	return frozen_graph<N, E>(*this);
+}
+template<typename N, typename E>
+gdwg::frozen_graph<N, E>::iterator::iterator(const frozen_graph* graph, std::size_t src, std::size_t pos)
+: g(graph)
+, src(src)
+, pos(pos) {}
+template<typename N, typename E>
+auto gdwg::frozen_graph<N, E>::iterator::operator*() const -> const reference {
+	return reference{g->nodes_[src], g->nodes_[g->dst_[pos]], g->weights_[pos]};
+}
+template<typename N, typename E>
+auto gdwg::frozen_graph<N, E>::iterator::operator++() -> iterator& {
+	++pos;
+	// skip the sources whose buckets end at or before pos
+	while (src < g->nodes_.size() and g->offsets_[src + 1] <= pos) {
+		++src;
+	}
+	return *this;
+}
+template<typename N, typename E>
+auto gdwg::frozen_graph<N, E>::iterator::operator++(int) -> iterator {
+	auto temp = *this;
+	++(*this);
+	return temp;
+}
+template<typename N, typename E>
+auto gdwg::frozen_graph<N, E>::iterator::operator--() -> iterator& {
+	--pos;
+	while (g->offsets_[src] > pos) {
+		--src;
+	}
+	return *this;
+}
+template<typename N, typename E>
+auto gdwg::frozen_graph<N, E>::iterator::operator--(int) -> iterator {
+	auto temp = *this;
+	--(*this);
+	return temp;
+}
+template<typename N, typename E>
+auto gdwg::frozen_graph<N, E>::iterator::operator==(iterator const& other) const -> bool {
+	return g == other.g and pos == other.pos;
+}
+template<typename N, typename E>
+gdwg::frozen_graph<N, E>::frozen_graph(graph<N, E> const& g)
+: nodes_(g.nodes()) {
+	if (nodes_.size() > std::numeric_limits<node_id>::max()) {
+		throw std::length_error("Cannot call gdwg::frozen_graph<N, E>::frozen_graph on a graph with more nodes than "
+		                        "node_id can address");
+	}
+	offsets_.assign(nodes_.size() + 1, 0);
+	// the graph iterates edges ordered by (src, dst, weight), which is exactly the CSR order
+	for (auto const& [from, to, weight] : g) {
+		++offsets_[*id_of(from) + 1];
+		dst_.push_back(*id_of(to));
+		weights_.push_back(weight);
+	}
+	std::partial_sum(offsets_.begin(), offsets_.end(), offsets_.begin());
+}
+template<typename N, typename E>
+auto gdwg::frozen_graph<N, E>::thaw() const -> graph<N, E> {
+	auto g = graph<N, E>(nodes_.begin(), nodes_.end());
+	g.insert_edges(begin(), end());
+	return g;
+}
+template<typename N, typename E>
+auto gdwg::frozen_graph<N, E>::id_of(N const& value) const noexcept -> std::optional<node_id> {
+	auto it = std::lower_bound(nodes_.begin(), nodes_.end(), value);
+	if (it == nodes_.end() or *it != value) {
+		return std::nullopt;
+	}
+	return static_cast<node_id>(it - nodes_.begin());
+}
+template<typename N, typename E>
+auto gdwg::frozen_graph<N, E>::edge_range(node_id src, node_id dst) const noexcept
+    -> std::pair<std::size_t, std::size_t> {
+	auto const first = dst_.begin() + static_cast<std::ptrdiff_t>(offsets_[src]);
+	auto const last = dst_.begin() + static_cast<std::ptrdiff_t>(offsets_[src + 1]);
+	auto [lo, hi] = std::equal_range(first, last, dst);
+	return {static_cast<std::size_t>(lo - dst_.begin()), static_cast<std::size_t>(hi - dst_.begin())};
+}
+template<typename N, typename E>
+auto gdwg::frozen_graph<N, E>::is_node(N const& value) const noexcept -> bool {
+	return id_of(value).has_value();
+}
+template<typename N, typename E>
+auto gdwg::frozen_graph<N, E>::empty() const noexcept -> bool {
+	return nodes_.empty();
+}
+template<typename N, typename E>
+auto gdwg::frozen_graph<N, E>::is_connected(N const& src, N const& dst) const -> bool {
+	auto src_id = id_of(src);
+	auto dst_id = id_of(dst);
+	if (!src_id or !dst_id) {
+		throw std::runtime_error("Cannot call gdwg::frozen_graph<N, E>::is_connected if src or dst node don't exist in "
+		                         "the graph");
+	}
+	auto [first, last] = edge_range(*src_id, *dst_id);
+	return first != last;
+}
+template<typename N, typename E>
+auto gdwg::frozen_graph<N, E>::nodes() const -> std::vector<N> {
+	return nodes_;
+}
+template<typename N, typename E>
+auto gdwg::frozen_graph<N, E>::edges(N const& src, N const& dst) const -> std::vector<std::unique_ptr<edge>> {
+	auto src_id = id_of(src);
+	auto dst_id = id_of(dst);
+	if (!src_id or !dst_id) {
+		throw std::runtime_error("Cannot call gdwg::frozen_graph<N, E>::edges if src or dst node don't exist in the "
+		                         "graph");
+	}
+	auto result = std::vector<std::unique_ptr<edge>>();
+	auto [first, last] = edge_range(*src_id, *dst_id);
+	for (auto i = first; i != last; ++i) {
+		if (weights_[i]) {
+			result.push_back(std::make_unique<weighted_edge<N, E>>(src, dst, *weights_[i]));
+		}
+		else {
+			result.push_back(std::make_unique<unweighted_edge<N, E>>(src, dst));
+		}
+	}
+	return result;
+}
+template<typename N, typename E>
+auto gdwg::frozen_graph<N, E>::find(N const& src, N const& dst, std::optional<E> weight) const -> iterator {
+	auto src_id = id_of(src);
+	auto dst_id = id_of(dst);
+	if (!src_id or !dst_id) {
+		return end();
+	}
+	auto [first, last] = edge_range(*src_id, *dst_id);
+	// weights within one (src, dst) run are sorted with the unweighted edge first
+	auto const lo = weights_.begin() + static_cast<std::ptrdiff_t>(first);
+	auto const hi = weights_.begin() + static_cast<std::ptrdiff_t>(last);
+	auto it = std::lower_bound(lo, hi, weight);
+	if (it == hi or *it != weight) {
+		return end();
+	}
+	return iterator(this, *src_id, static_cast<std::size_t>(it - weights_.begin()));
+}
+template<typename N, typename E>
+auto gdwg::frozen_graph<N, E>::connections(N const& src) const -> std::vector<N> {
+	auto src_id = id_of(src);
+	if (!src_id) {
+		throw std::runtime_error("Cannot call gdwg::frozen_graph<N, E>::connections if src doesn't exist in the graph");
+	}
+	auto result = std::vector<N>();
+	for (auto i = offsets_[*src_id]; i != offsets_[*src_id + 1]; ++i) {
+		if (i == offsets_[*src_id] or dst_[i] != dst_[i - 1]) {
+			result.push_back(nodes_[dst_[i]]);
+		}
+	}
+	return result;
+}
+template<typename N, typename E>
+auto gdwg::frozen_graph<N, E>::node_count() const noexcept -> std::size_t {
+	return nodes_.size();
+}
+template<typename N, typename E>
+auto gdwg::frozen_graph<N, E>::edge_count() const noexcept -> std::size_t {
+	return dst_.size();
+}
+template<typename N, typename E>
+auto gdwg::frozen_graph<N, E>::begin() const -> iterator {
+	auto it = iterator(this, 0, 0);
+	// position on the first source that owns an edge
+	while (it.src < nodes_.size() and offsets_[it.src + 1] == 0) {
+		++it.src;
+	}
+	return it;
+}
+template<typename N, typename E>
+auto gdwg::frozen_graph<N, E>::end() const -> iterator {
+	return iterator(this, nodes_.size(), dst_.size());
+}
+#endif // GDWG_FROZEN_GRAPH_H
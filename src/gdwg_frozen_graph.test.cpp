@@ -0,0 +1,111 @@
+#include "gdwg_frozen_graph.h"
+
+#include <catch2/catch.hpp>
+
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+	auto make_graph() -> gdwg::graph<std::string, int> {
+		auto g = gdwg::graph<std::string, int>{"A", "B", "C", "D"};
+		g.insert_edge("A", "B", 3);
+		g.insert_edge("A", "B");
+		g.insert_edge("A", "B", 1);
+		g.insert_edge("A", "C", 2);
+		g.insert_edge("C", "A");
+		g.insert_edge("C", "C", 5);
+		return g;
+	}
+} // namespace
+
+TEST_CASE("freeze: empty graph") {
+	auto g = gdwg::graph<int, int>{};
+	auto f = g.freeze();
+	CHECK(f.empty());
+	CHECK(f.begin() == f.end());
+	CHECK(f.node_count() == 0);
+	CHECK(f.edge_count() == 0);
+}
+TEST_CASE("freeze: nodes and queries match the source graph") {
+	auto g = make_graph();
+	auto f = g.freeze();
+	CHECK(f.nodes() == g.nodes());
+	CHECK(f.edge_count() == 6);
+	CHECK(f.is_node("D"));
+	CHECK(!f.is_node("E"));
+	CHECK(f.is_connected("A", "B"));
+	CHECK(f.is_connected("C", "C"));
+	CHECK(!f.is_connected("B", "A"));
+	CHECK_THROWS_WITH(f.is_connected("A", "E"),
+	                  "Cannot call gdwg::frozen_graph<N, E>::is_connected if src or dst node don't exist in the graph");
+	CHECK(f.connections("A") == std::vector<std::string>{"B", "C"});
+	CHECK(f.connections("D").empty());
+	CHECK_THROWS_WITH(f.connections("E"),
+	                  "Cannot call gdwg::frozen_graph<N, E>::connections if src doesn't exist in the graph");
+}
+TEST_CASE("freeze: edges between two nodes keep the unweighted edge first") {
+	auto f = make_graph().freeze();
+	auto edges = f.edges("A", "B");
+	REQUIRE(edges.size() == 3);
+	CHECK(edges[0]->print_edge() == "A -> B | U");
+	CHECK(edges[1]->print_edge() == "A -> B | W | 1");
+	CHECK(edges[2]->print_edge() == "A -> B | W | 3");
+	CHECK(f.edges("B", "A").empty());
+}
+TEST_CASE("freeze: find and iteration follow the graph's edge order") {
+	auto g = make_graph();
+	auto f = g.freeze();
+	auto it = f.find("A", "B", 1);
+	REQUIRE(it != f.end());
+	CHECK((*it).from == "A");
+	CHECK((*it).to == "B");
+	CHECK((*it).weight == 1);
+	CHECK(f.find("A", "B", 2) == f.end());
+	CHECK(f.find("A", "C") == f.end());
+	CHECK(f.find("C", "A") != f.end());
+
+	auto gi = g.begin();
+	for (auto const& [from, to, weight] : f) {
+		REQUIRE(gi != g.end());
+		CHECK(from == (*gi).from);
+		CHECK(to == (*gi).to);
+		CHECK(weight == (*gi).weight);
+		++gi;
+	}
+	CHECK(gi == g.end());
+
+	auto last = f.end();
+	--last;
+	CHECK((*last).from == "C");
+	CHECK((*last).weight == 5);
+}
+TEST_CASE("thaw: round trips back into an equal graph") {
+	auto g = make_graph();
+	auto f = g.freeze();
+	auto back = f.thaw();
+	CHECK(back == g);
+	back.insert_edge("D", "A", 9);
+	CHECK(back.freeze() != f);
+	CHECK(back.freeze().is_connected("D", "A"));
+	auto out = std::ostringstream{};
+	out << back;
+	auto const expected_output = std::string_view(R"(A (
+  A -> B | U
+  A -> B | W | 1
+  A -> B | W | 3
+  A -> C | W | 2
+)
+B (
+)
+C (
+  C -> A | U
+  C -> C | W | 5
+)
+D (
+  D -> A | W | 9
+)
+)");
+	CHECK(out.str() == expected_output);
+}
@@ -0,0 +1,1054 @@
+#include "gdwg_concurrent_graph.h"
+#include "gdwg_contraction_hierarchy.h"
+#include "gdwg_delta_stepping.h"
+#include "gdwg_graph.h"
+#include "gdwg_point_to_point.h"
+#include "gdwg_rcu_graph.h"
+#include "gdwg_shortest_paths.h"
+#include "gdwg_traversal.h"
+#include "gdwg_graph_io.h"
+#include "gdwg_journal.h"
+#include "gdwg_mapped_graph.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstddef>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory_resource>
+#include <optional>
+#include <shared_mutex>
+#include <queue>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+// Micro benchmarks for gdwg::graph. Run with no arguments to run everything, or name the
+// benchmarks to run, e.g. `gdwg_graph_bench_exe insert_edges`.
+namespace {
+	using clock_type = std::chrono::steady_clock;
+
+	template<typename F>
+	auto time_ms(F&& f) -> double {
+		auto const start = clock_type::now();
+		f();
+		return std::chrono::duration<double, std::milli>(clock_type::now() - start).count();
+	}
+
+	auto report(std::string_view name, std::string_view variant, double ms, std::size_t items) -> void {
+		std::cout << name << " / " << variant << ": " << ms << " ms";
+		if (items != 0 and ms > 0) {
+			std::cout << " (" << static_cast<double>(items) / ms * 1000.0 << " items/s)";
+		}
+		std::cout << "\n";
+	}
+
+	auto report_bytes(std::string_view name, std::string_view variant, double ms, std::size_t bytes) -> void {
+		std::cout << name << " / " << variant << ": " << ms << " ms";
+		if (ms > 0) {
+			std::cout << " (" << static_cast<double>(bytes) / ms / 1000.0 << " MB/s)";
+		}
+		std::cout << "\n";
+	}
+
+	// uniformly random (src, dst, weight) triples over [0, nodes), roughly a third unweighted
+	auto random_edges(int nodes, std::size_t count, unsigned seed)
+	    -> std::vector<std::tuple<int, int, std::optional<int>>> {
+		auto rng = std::mt19937(seed);
+		auto node = std::uniform_int_distribution<int>(0, nodes - 1);
+		auto weight = std::uniform_int_distribution<int>(-1, 100);
+		auto result = std::vector<std::tuple<int, int, std::optional<int>>>();
+		result.reserve(count);
+		for (auto i = std::size_t{0}; i < count; ++i) {
+			auto w = weight(rng);
+			result.emplace_back(node(rng), node(rng), w < 33 ? std::nullopt : std::optional<int>(w));
+		}
+		return result;
+	}
+
+	// sources drawn with a heavy skew towards low ids, so a few hubs own most of the edges
+	auto power_law_edges(int nodes, std::size_t count, unsigned seed)
+	    -> std::vector<std::tuple<int, int, std::optional<int>>> {
+		auto rng = std::mt19937(seed);
+		auto unit = std::uniform_real_distribution<double>(0.0, 1.0);
+		auto node = std::uniform_int_distribution<int>(0, nodes - 1);
+		auto weight = std::uniform_int_distribution<int>(0, 100);
+		auto result = std::vector<std::tuple<int, int, std::optional<int>>>();
+		result.reserve(count);
+		for (auto i = std::size_t{0}; i < count; ++i) {
+			auto const u = unit(rng);
+			auto const src = static_cast<int>(static_cast<double>(nodes) * u * u * u * u);
+			result.emplace_back(src, node(rng), weight(rng));
+		}
+		return result;
+	}
+
+	// a road-like side x side grid, node x * side + y, with two way streets costing min_cost to 100
+	auto street_grid(int side, int min_cost, unsigned seed) -> std::vector<std::tuple<int, int, std::optional<int>>> {
+		auto rng = std::mt19937(seed);
+		auto cost = std::uniform_int_distribution<int>(min_cost, 100);
+		auto result = std::vector<std::tuple<int, int, std::optional<int>>>();
+		for (auto x = 0; x < side; ++x) {
+			for (auto y = 0; y < side; ++y) {
+				auto const here = x * side + y;
+				for (auto const there : {x + 1 < side ? here + side : -1, y + 1 < side ? here + 1 : -1}) {
+					if (there >= 0) {
+						result.emplace_back(here, there, cost(rng));
+						result.emplace_back(there, here, cost(rng));
+					}
+				}
+			}
+		}
+		return result;
+	}
+
+	auto node_range(int nodes) -> std::vector<int> {
+		auto result = std::vector<int>();
+		for (auto i = 0; i < nodes; ++i) {
+			result.push_back(i);
+		}
+		return result;
+	}
+
+	auto bench_insert_edges() -> void {
+		auto constexpr nodes = 500;
+		auto constexpr count = std::size_t{32'000};
+		auto const ids = node_range(nodes);
+		auto const edges = random_edges(nodes, count, 1);
+
+		auto looped = gdwg::graph<int, int>(ids.begin(), ids.end());
+		report("insert_edges", "insert_edge loop", time_ms([&] {
+			       for (auto const& [src, dst, weight] : edges) {
+				       looped.insert_edge(src, dst, weight);
+			       }
+		       }),
+		       count);
+
+		auto bulk = gdwg::graph<int, int>(ids.begin(), ids.end());
+		report("insert_edges", "insert_edges", time_ms([&] { bulk.insert_edges(edges.begin(), edges.end()); }), count);
+
+		if (!(looped == bulk)) {
+			std::cout << "insert_edges: results differ\n";
+		}
+	}
+
+	auto bench_copy() -> void {
+		auto constexpr nodes = 10'000;
+		auto constexpr count = std::size_t{200'000};
+		auto const ids = node_range(nodes);
+		auto const edges = random_edges(nodes, count, 2);
+		auto g = gdwg::graph<int, int>(ids.begin(), ids.end());
+		g.insert_edges(edges.begin(), edges.end());
+
+		auto copies = std::vector<gdwg::graph<int, int>>();
+		report("copy", "copy constructor x10", time_ms([&] {
+			       for (auto i = 0; i < 10; ++i) {
+				       copies.push_back(g);
+			       }
+		       }),
+		       10 * count);
+		// buckets are shared, so a write after the copy only clones the buckets it touches
+		report("copy", "insert_edge into 100 buckets of each copy", time_ms([&] {
+			       for (auto& copy : copies) {
+				       for (auto src = 0; src < 100; ++src) {
+					       copy.insert_edge(src, src, -1);
+				       }
+			       }
+		       }),
+		       10 * 100);
+		report("copy", "destructor x10", time_ms([&] { copies.clear(); }), 10 * count);
+		report("copy", "deep copy into another resource x10", time_ms([&] {
+			       auto resource = std::pmr::unsynchronized_pool_resource();
+			       for (auto i = 0; i < 10; ++i) {
+				       copies.emplace_back(g, &resource);
+			       }
+			       copies.clear();
+		       }),
+		       10 * count);
+	}
+
+	auto bench_parallel_copy() -> void {
+		auto constexpr nodes = 1'000'000;
+		auto constexpr count = std::size_t{4'000'000};
+		auto const ids = node_range(nodes);
+		auto const edges = random_edges(nodes, count, 18);
+		auto g = gdwg::graph<int, int>(ids.begin(), ids.end());
+		g.insert_edges(edges.begin(), edges.end());
+
+		// warm the allocator so the first run doesn't pay for fresh pages
+		static_cast<void>(gdwg::graph<int, int>(g));
+		auto const previous = gdwg::get_parallel_options();
+		auto counts = std::vector<std::size_t>{1, 2, 4};
+		if (auto const hardware = gdwg::detail::worker_count(0); hardware > counts.back()) {
+			counts.push_back(hardware);
+		}
+		for (auto const threads : counts) {
+			gdwg::set_parallel_options({.threads = threads, .threshold = threads == 1 ? std::size_t{nodes} + 1 : 1});
+			auto const label = std::to_string(threads) + " threads";
+			auto copy = gdwg::graph<int, int>();
+			report("parallel_copy", "copy constructor, " + label, time_ms([&] { copy = g; }), count);
+			report("parallel_copy", "clear, " + label, time_ms([&] { copy.clear(); }), count);
+			// cloned buckets are owned by the copy alone, so destroying it frees them
+			auto resource = std::pmr::synchronized_pool_resource();
+			auto deep = std::optional<gdwg::graph<int, int>>();
+			report("parallel_copy",
+			       "deep copy into another resource, " + label,
+			       time_ms([&] { deep.emplace(g, &resource); }),
+			       count);
+			report("parallel_copy", "destructor of the deep copy, " + label, time_ms([&] { deep.reset(); }), count);
+		}
+		gdwg::set_parallel_options(previous);
+	}
+
+	auto bench_erase_node() -> void {
+		auto constexpr nodes = 20'000;
+		auto constexpr count = std::size_t{200'000};
+		auto constexpr erased = 500;
+		auto const ids = node_range(nodes);
+		auto const edges = random_edges(nodes, count, 3);
+		for (auto tracked : {false, true}) {
+			auto g = gdwg::graph<int, int>(ids.begin(), ids.end());
+			g.insert_edges(edges.begin(), edges.end());
+			g.track_in_edges(tracked);
+			report("erase_node",
+			       tracked ? "incoming index" : "full scan",
+			       time_ms([&] {
+				       for (auto i = 0; i < erased; ++i) {
+					       g.erase_node(i * (nodes / erased));
+				       }
+			       }),
+			       erased);
+		}
+	}
+
+	auto bench_lookup() -> void {
+		auto constexpr nodes = 50'000;
+		auto constexpr count = std::size_t{500'000};
+		auto constexpr queries = std::size_t{20'000};
+		auto const ids = node_range(nodes);
+		auto g = gdwg::graph<int, int>(ids.begin(), ids.end());
+		auto const edges = power_law_edges(nodes, count, 4);
+		g.insert_edges(edges.begin(), edges.end());
+		// queries follow the same skew as the edges, so hubs are hit most often
+		auto const probes = power_law_edges(nodes, queries, 5);
+
+		auto hits = std::size_t{0};
+		report("lookup", "is_connected (linear scan of out_edges)", time_ms([&] {
+			       for (auto const& [src, dst, weight] : probes) {
+				       for (auto const& e : g.out_edges(src)) {
+					       if (e.to == dst) {
+						       ++hits;
+						       break;
+					       }
+				       }
+			       }
+		       }),
+		       queries);
+		report("lookup", "is_connected (equal_range)", time_ms([&] {
+			       for (auto const& [src, dst, weight] : probes) {
+				       hits += g.is_connected(src, dst) ? 1U : 0U;
+			       }
+		       }),
+		       queries);
+		report("lookup", "find (lower_bound)", time_ms([&] {
+			       for (auto const& [src, dst, weight] : probes) {
+				       hits += g.find(src, dst, weight) != g.end() ? 1U : 0U;
+			       }
+		       }),
+		       queries);
+		report("lookup", "edges_between", time_ms([&] {
+			       for (auto const& [src, dst, weight] : probes) {
+				       hits += g.edges_between(src, dst).size();
+			       }
+		       }),
+		       queries);
+		std::cout << "lookup: " << hits << " hits\n";
+	}
+
+	auto bench_arena() -> void {
+		auto constexpr graphs = 500;
+		auto constexpr nodes = 200;
+		auto constexpr count = std::size_t{2'000};
+		auto const ids = node_range(nodes);
+		auto const edges = random_edges(nodes, count, 6);
+		auto const build = [&](gdwg::graph<int, int>::allocator_type alloc) {
+			auto g = gdwg::graph<int, int>(ids.begin(), ids.end(), alloc);
+			for (auto const& [src, dst, weight] : edges) {
+				g.insert_edge(src, dst, weight);
+			}
+			return g.id_bound();
+		};
+
+		auto total = std::size_t{0};
+		report("arena", "global heap", time_ms([&] {
+			       for (auto i = 0; i < graphs; ++i) {
+				       total += build({});
+			       }
+		       }),
+		       graphs * count);
+		// one arena reused for every short-lived graph, released in one go after each
+		auto buffer = std::vector<std::byte>(std::size_t{1} << 20);
+		auto arena = std::pmr::monotonic_buffer_resource(buffer.data(), buffer.size());
+		report("arena", "monotonic_buffer_resource", time_ms([&] {
+			       for (auto i = 0; i < graphs; ++i) {
+				       total += build(&arena);
+				       arena.release();
+			       }
+		       }),
+		       graphs * count);
+		std::cout << "arena: " << total << " ids\n";
+	}
+
+	auto bench_equality() -> void {
+		auto constexpr nodes = 10'000;
+		auto constexpr count = std::size_t{200'000};
+		auto constexpr rounds = 20;
+		auto const ids = node_range(nodes);
+		auto const edges = random_edges(nodes, count, 7);
+		auto g = gdwg::graph<int, int>(ids.begin(), ids.end());
+		g.insert_edges(edges.begin(), edges.end());
+		// built separately so nothing is shared with g
+		auto same = gdwg::graph<int, int>(ids.begin(), ids.end());
+		same.insert_edges(edges.rbegin(), edges.rend());
+		auto changed = same;
+		changed.insert_edge(nodes - 1, 0, -1);
+
+		auto equal = 0;
+		report("equality", "equal graphs", time_ms([&] {
+			       for (auto i = 0; i < rounds; ++i) {
+				       equal += g == same ? 1 : 0;
+			       }
+		       }),
+		       rounds * count);
+		report("equality", "graphs differing in the last edge", time_ms([&] {
+			       for (auto i = 0; i < rounds; ++i) {
+				       equal += g == changed ? 1 : 0;
+			       }
+		       }),
+		       rounds * count);
+		g.track_fingerprint(true);
+		changed.track_fingerprint(true);
+		report("equality", "differing graphs with fingerprints", time_ms([&] {
+			       for (auto i = 0; i < rounds; ++i) {
+				       equal += g == changed ? 1 : 0;
+			       }
+		       }),
+		       rounds * count);
+		std::cout << "equality: " << equal << " equal\n";
+	}
+
+	auto bench_write_text() -> void {
+		auto constexpr nodes = 100'000;
+		auto constexpr count = std::size_t{2'000'000};
+		auto const ids = node_range(nodes);
+		auto const edges = random_edges(nodes, count, 8);
+		auto g = gdwg::graph<int, int>(ids.begin(), ids.end());
+		g.insert_edges(edges.begin(), edges.end());
+
+		auto os = std::ostringstream();
+		auto const streamed_ms = time_ms([&] { os << g; });
+		auto const streamed = std::move(os).str();
+		report_bytes("write_text", "operator<<", streamed_ms, streamed.size());
+
+		auto written = std::string();
+		written.reserve(streamed.size());
+		auto const written_ms = time_ms([&] {
+			gdwg::write_text(g, [&written](std::string_view chunk) { written += chunk; });
+		});
+		report_bytes("write_text", "write_text", written_ms, written.size());
+		if (written != streamed) {
+			std::cout << "write_text: output differs from operator<<\n";
+		}
+	}
+
+	auto bench_read_text() -> void {
+		auto constexpr nodes = 100'000;
+		auto constexpr count = std::size_t{2'000'000};
+		auto const ids = node_range(nodes);
+		auto const edges = random_edges(nodes, count, 9);
+		auto g = gdwg::graph<int, int>(ids.begin(), ids.end());
+		g.insert_edges(edges.begin(), edges.end());
+		auto text = std::string();
+		gdwg::write_text(g, [&text](std::string_view chunk) { text += chunk; });
+
+		auto parsed = gdwg::graph<int, int>();
+		report_bytes("read_text", "read_text from memory", time_ms([&] {
+			             parsed = gdwg::read_text<int, int>(text);
+		             }),
+		             text.size());
+		auto const path = std::string("gdwg_graph_bench_read_text.txt");
+		std::ofstream(path) << text;
+		auto loaded = gdwg::graph<int, int>();
+		report_bytes("read_text", "load_text from a mapped file", time_ms([&] {
+			             loaded = gdwg::load_text<int, int>(path);
+		             }),
+		             text.size());
+		std::remove(path.c_str());
+		if (!(parsed == g) or !(loaded == g)) {
+			std::cout << "read_text: parsed graph differs\n";
+		}
+	}
+
+	auto bench_binary() -> void {
+		auto constexpr nodes = 100'000;
+		auto constexpr count = std::size_t{2'000'000};
+		auto const ids = node_range(nodes);
+		auto const edges = random_edges(nodes, count, 10);
+		auto g = gdwg::graph<int, int>(ids.begin(), ids.end());
+		g.insert_edges(edges.begin(), edges.end());
+
+		auto const path = std::string("gdwg_graph_bench_binary.bin");
+		report("binary", "save_binary", time_ms([&] { gdwg::save_binary(g, path); }), count);
+		auto loaded = gdwg::graph<int, int>();
+		report("binary", "write_text + read_text round trip", time_ms([&] {
+			       auto text = std::string();
+			       gdwg::write_text(g, [&text](std::string_view chunk) { text += chunk; });
+			       loaded = gdwg::read_text<int, int>(text);
+		       }),
+		       count);
+		auto m = std::optional<gdwg::mapped_graph<int, int>>();
+		report("binary", "load_binary", time_ms([&] { m.emplace(gdwg::load_binary<int, int>(path)); }), 0);
+
+		auto found = std::size_t{0};
+		report("binary", "find on graph", time_ms([&] {
+			       for (auto const& [src, dst, weight] : edges) {
+				       found += g.find(src, dst, weight) != g.end() ? 1U : 0U;
+			       }
+		       }),
+		       edges.size());
+		report("binary", "find on mapped_graph", time_ms([&] {
+			       for (auto const& [src, dst, weight] : edges) {
+				       found += m->find(src, dst, weight) != m->end() ? 1U : 0U;
+			       }
+		       }),
+		       edges.size());
+		report("binary", "thaw", time_ms([&] { loaded = m->thaw(); }), count);
+		std::remove(path.c_str());
+		if (found != 2 * edges.size() or !(loaded == g)) {
+			std::cout << "binary: mapped graph differs\n";
+		}
+	}
+
+	auto bench_import() -> void {
+		auto constexpr nodes = 200'000;
+		auto constexpr count = std::size_t{4'000'000};
+		auto const edges = random_edges(nodes, count, 11);
+		auto csv = std::string();
+		for (auto const& [src, dst, weight] : edges) {
+			csv += std::to_string(src);
+			csv += ',';
+			csv += std::to_string(dst);
+			if (weight) {
+				csv += ',';
+				csv += std::to_string(*weight);
+			}
+			csv += '\n';
+		}
+		csv += "not,an edge\n";
+
+		// the path the importer replaces: parse each line and call insert_edge
+		auto looped = gdwg::graph<int, int>();
+		report("import", "getline + insert_edge loop", time_ms([&] {
+			       auto is = std::istringstream(csv);
+			       auto line = std::string();
+			       while (std::getline(is, line)) {
+				       auto fields = std::istringstream(line);
+				       auto src = 0;
+				       auto dst = 0;
+				       auto weight = 0;
+				       auto comma = ',';
+				       if (!(fields >> src >> comma >> dst)) {
+					       continue;
+				       }
+				       auto const weighted = static_cast<bool>(fields >> comma >> weight);
+				       looped.insert_node(src);
+				       looped.insert_node(dst);
+				       looped.insert_edge(src, dst, weighted ? std::optional<int>(weight) : std::nullopt);
+			       }
+		       }),
+		       count);
+		for (auto const threads : {std::size_t{1}, std::size_t{2}, std::size_t{4}, gdwg::detail::worker_count(0)}) {
+			auto g = gdwg::graph<int, int>();
+			auto const stats = gdwg::import_edges(g, csv, {.threads = threads});
+			std::cout << "import / import_edges with " << threads << " threads: " << stats.seconds * 1000.0
+			          << " ms (" << stats.rows_per_second() << " rows/s, " << stats.malformed << " malformed)\n";
+			if (!(g == looped)) {
+				std::cout << "import: imported graph differs\n";
+			}
+		}
+	}
+
+	auto bench_journal() -> void {
+		auto constexpr nodes = 10'000;
+		auto constexpr count = std::size_t{200'000};
+		auto const ids = node_range(nodes);
+		auto const edges = random_edges(nodes, count, 12);
+		auto const insert_all = [&](auto& g) {
+			for (auto const id : ids) {
+				g.insert_node(id);
+			}
+			for (auto const& [src, dst, weight] : edges) {
+				g.insert_edge(src, dst, weight);
+			}
+		};
+
+		auto plain = gdwg::graph<int, int>();
+		report("journal", "no journal", time_ms([&] { insert_all(plain); }), count);
+		auto const dir = std::string("gdwg_graph_bench_journal");
+		struct variant {
+			std::string_view name;
+			gdwg::journal_options options;
+		};
+		for (auto const& [name, options] : {
+		         variant{"group of 256, synced", {.group_size = 256, .sync = true, .checkpoint_bytes = 0}},
+		         variant{"group of 4096, synced", {.group_size = 4096, .sync = true, .checkpoint_bytes = 0}},
+		         variant{"group of 256, unsynced", {.group_size = 256, .sync = false, .checkpoint_bytes = 0}},
+		         variant{"group of 4096, checkpoint every 1 MB",
+		                 {.group_size = 4096, .sync = true, .checkpoint_bytes = std::size_t{1} << 20U}},
+		     })
+		{
+			std::filesystem::remove_all(dir);
+			auto ms = 0.0;
+			{
+				auto j = gdwg::journaled_graph<int, int>(dir, options);
+				ms = time_ms([&] {
+					insert_all(j);
+					j.commit();
+				});
+			}
+			report("journal", name, ms, count);
+			auto recovered = std::optional<gdwg::journaled_graph<int, int>>();
+			report("journal", "recovery", time_ms([&] { recovered.emplace(dir, options); }), 0);
+			if (!(recovered->get() == plain)) {
+				std::cout << "journal: recovered graph differs\n";
+			}
+		}
+		std::filesystem::remove_all(dir);
+	}
+
+	auto bench_batch() -> void {
+		auto constexpr nodes = 20'000;
+		auto constexpr count = std::size_t{200'000};
+		auto const ids = node_range(nodes);
+		auto const edges = power_law_edges(nodes, count, 13);
+		auto base = gdwg::graph<int, int>(ids.begin(), ids.end());
+		base.insert_edges(edges.begin(), edges.end());
+		// a burst of inserts into the hubs, erasures of existing edges and a few node erasures
+		auto const burst = power_law_edges(nodes, 50'000, 14);
+		auto const erased_nodes = std::vector<int>{nodes - 1, nodes - 2, nodes - 3, nodes - 4, nodes - 5};
+
+		auto looped = base;
+		report("batch", "one call per operation", time_ms([&] {
+			       for (auto i = std::size_t{0}; i < burst.size(); ++i) {
+				       auto const& [src, dst, weight] = burst[i];
+				       looped.insert_edge(src, dst, weight);
+				       auto const& [old_src, old_dst, old_weight] = edges[i];
+				       looped.erase_edge(old_src, old_dst, old_weight);
+			       }
+			       for (auto const n : erased_nodes) {
+				       looped.erase_node(n);
+			       }
+		       }),
+		       2 * burst.size() + erased_nodes.size());
+
+		auto batched = base;
+		report("batch", "batch() and commit", time_ms([&] {
+			       auto tx = batched.batch();
+			       for (auto i = std::size_t{0}; i < burst.size(); ++i) {
+				       auto const& [src, dst, weight] = burst[i];
+				       tx.insert_edge(src, dst, weight);
+				       auto const& [old_src, old_dst, old_weight] = edges[i];
+				       tx.erase_edge(old_src, old_dst, old_weight);
+			       }
+			       for (auto const n : erased_nodes) {
+				       tx.erase_node(n);
+			       }
+			       tx.commit();
+		       }),
+		       2 * burst.size() + erased_nodes.size());
+		if (!(looped == batched)) {
+			std::cout << "batch: results differ\n";
+		}
+	}
+
+	auto bench_concurrent() -> void {
+		auto constexpr nodes = 100'000;
+		auto constexpr count = std::size_t{1'000'000};
+		auto constexpr ops = 200'000;
+		auto const ids = node_range(nodes);
+		auto const edges = random_edges(nodes, count, 15);
+
+		auto locked = gdwg::graph<int, int>(ids.begin(), ids.end());
+		locked.insert_edges(edges.begin(), edges.end());
+		auto mutex = std::shared_mutex();
+		auto striped = gdwg::concurrent_graph<int, int>();
+		for (auto const id : ids) {
+			striped.insert_node(id);
+		}
+		for (auto const& [src, dst, weight] : edges) {
+			striped.insert_edge(src, dst, weight);
+		}
+
+		// every thread runs ops operations, one in ten a write, over its own slice of the edge list
+		auto const run = [&](std::size_t threads, auto const& read, auto const& write) {
+			return time_ms([&] {
+				auto workers = std::vector<std::thread>();
+				for (auto t = std::size_t{0}; t < threads; ++t) {
+					workers.emplace_back([&, t] {
+						for (auto i = std::size_t{0}; i < ops; ++i) {
+							auto const& [src, dst, weight] = edges[(t * ops + i) % count];
+							if (i % 10 == 0) {
+								write(src, dst, weight, i % 20 == 0);
+							}
+							else {
+								read(src, dst, weight);
+							}
+						}
+					});
+				}
+				for (auto& w : workers) {
+					w.join();
+				}
+			});
+		};
+		auto hits = std::size_t{0};
+		auto counts = std::vector<std::size_t>{1, 2, 4, 8};
+		if (auto const hardware = gdwg::detail::worker_count(0); hardware > counts.back()) {
+			counts.push_back(hardware);
+		}
+		for (auto const threads : counts) {
+			auto const label = std::to_string(threads) + " threads";
+			report("concurrent",
+			       "graph behind one shared_mutex, " + label,
+			       run(
+			           threads,
+			           [&](int src, int dst, std::optional<int> const& weight) {
+				           auto lock = std::shared_lock(mutex);
+				           hits += locked.find(src, dst, weight) != locked.end() ? 1U : 0U;
+			           },
+			           [&](int src, int dst, std::optional<int> const& weight, bool erase) {
+				           auto lock = std::unique_lock(mutex);
+				           erase ? locked.erase_edge(src, dst, weight) : locked.insert_edge(src, dst, weight);
+			           }),
+			       threads * ops);
+			report("concurrent",
+			       "concurrent_graph, " + label,
+			       run(
+			           threads,
+			           [&](int src, int dst, std::optional<int> const& weight) {
+				           hits += striped.find(src, dst, weight) ? 1U : 0U;
+			           },
+			           [&](int src, int dst, std::optional<int> const& weight, bool erase) {
+				           erase ? striped.erase_edge(src, dst, weight) : striped.insert_edge(src, dst, weight);
+			           }),
+			       threads * ops);
+		}
+		if (!(striped.snapshot() == locked)) {
+			std::cout << "concurrent: graphs differ\n";
+		}
+	}
+
+	auto bench_rcu() -> void {
+		auto constexpr nodes = 100'000;
+		auto constexpr readers = std::size_t{2};
+		auto const ids = node_range(nodes);
+		auto const initial = random_edges(nodes, 500'000, 16);
+		auto const load = random_edges(nodes, 200'000, 17);
+
+		// per-read latencies while one writer runs a bulk insert_edge load
+		auto const run = [&](std::string_view variant, auto& g, auto const& read) {
+			auto done = std::atomic<bool>(false);
+			auto samples = std::vector<std::vector<double>>(readers);
+			auto threads = std::vector<std::thread>();
+			for (auto t = std::size_t{0}; t < readers; ++t) {
+				threads.emplace_back([&, t] {
+					auto hits = std::size_t{0};
+					for (auto i = t; not done.load(std::memory_order_relaxed); i += readers) {
+						auto const& [src, dst, weight] = initial[i % initial.size()];
+						auto const start = clock_type::now();
+						hits += read(src, dst, weight) ? 1U : 0U;
+						auto const elapsed = clock_type::now() - start;
+						samples[t].push_back(std::chrono::duration<double, std::micro>(elapsed).count());
+					}
+					static_cast<void>(hits);
+				});
+			}
+			auto const ms = time_ms([&] {
+				for (auto const& [src, dst, weight] : load) {
+					g.insert_edge(src, dst, weight);
+				}
+			});
+			done = true;
+			for (auto& t : threads) {
+				t.join();
+			}
+			auto all = std::vector<double>();
+			for (auto const& s : samples) {
+				all.insert(all.end(), s.begin(), s.end());
+			}
+			std::sort(all.begin(), all.end());
+			auto const at = [&all](double q) {
+				return all[static_cast<std::size_t>(q * static_cast<double>(all.size() - 1))];
+			};
+			report("rcu", std::string(variant) + ", writer", ms, load.size());
+			std::cout << "rcu / " << variant << ", " << all.size() << " reads: p50 " << at(0.5) << " us, p99 "
+			          << at(0.99) << " us, p99.9 " << at(0.999) << " us, max " << all.back() << " us\n";
+		};
+
+		auto striped = gdwg::concurrent_graph<int, int>();
+		for (auto const id : ids) {
+			striped.insert_node(id);
+		}
+		for (auto const& [src, dst, weight] : initial) {
+			striped.insert_edge(src, dst, weight);
+		}
+		run("concurrent_graph", striped, [&](int src, int dst, std::optional<int> const& weight) {
+			return striped.find(src, dst, weight);
+		});
+
+		auto source = gdwg::graph<int, int>(ids.begin(), ids.end());
+		source.insert_edges(initial.begin(), initial.end());
+		auto published = gdwg::rcu_graph<int, int>(source);
+		run("rcu_graph", published, [&](int src, int dst, std::optional<int> const& weight) {
+			auto const view = published.read();
+			return view.find(src, dst, weight) != view.end();
+		});
+	}
+
+	auto bench_traversal() -> void {
+		auto constexpr nodes = 1'000'000;
+		auto constexpr count = std::size_t{4'000'000};
+		auto const ids = node_range(nodes);
+		auto const edges = random_edges(nodes, count, 19);
+		auto g = gdwg::graph<int, int>(ids.begin(), ids.end());
+		g.insert_edges(edges.begin(), edges.end());
+
+		// what callers wrote before: a queue of values and connections() per hop
+		auto reached = std::size_t{0};
+		report("traversal", "bfs with connections() per hop", time_ms([&] {
+			       auto visited = std::vector<bool>(nodes);
+			       auto queue = std::vector<int>{0};
+			       visited[0] = true;
+			       for (auto head = std::size_t{0}; head < queue.size(); ++head) {
+				       for (auto const next : g.connections(queue[head])) {
+					       if (not visited[static_cast<std::size_t>(next)]) {
+						       visited[static_cast<std::size_t>(next)] = true;
+						       queue.push_back(next);
+					       }
+				       }
+			       }
+			       reached = queue.size();
+		       }),
+		       count);
+
+		struct counter {
+			std::size_t discovered = 0;
+			auto discover(gdwg::graph<int, int>::node_id) -> void {
+				++discovered;
+			}
+		};
+		auto workspace = gdwg::traversal_workspace();
+		// the first traversal sizes the workspace, later ones reuse it
+		for (auto const* run : {"first", "reused workspace"}) {
+			auto bfs = counter();
+			report("traversal",
+			       std::string("breadth_first_search, ") + run,
+			       time_ms([&] { gdwg::breadth_first_search(g, 0, workspace, bfs); }),
+			       count);
+			auto dfs = counter();
+			report("traversal",
+			       std::string("depth_first_search, ") + run,
+			       time_ms([&] { gdwg::depth_first_search(g, 0, workspace, dfs); }),
+			       count);
+			if (bfs.discovered != reached or dfs.discovered != reached) {
+				std::cout << "traversal: reached " << reached << " but visited " << bfs.discovered << " and "
+				          << dfs.discovered << "\n";
+			}
+		}
+	}
+
+	auto bench_shortest_paths() -> void {
+		auto constexpr nodes = 1'000'000;
+		auto constexpr count = std::size_t{4'000'000};
+		auto const ids = node_range(nodes);
+		auto const edges = random_edges(nodes, count, 20);
+		auto g = gdwg::graph<int, int>(ids.begin(), ids.end());
+		g.insert_edges(edges.begin(), edges.end());
+		auto constexpr sources = 3;
+
+		// a textbook search over the public interface: lazy deletion from a binary heap, distances in a map
+		auto expected = std::size_t{0};
+		report("shortest_paths", "std::priority_queue and out_edges, x3", time_ms([&] {
+			       for (auto src = 0; src < sources; ++src) {
+				       auto distance = std::unordered_map<int, int>{{src, 0}};
+				       auto queue = std::priority_queue<std::pair<int, int>,
+				                                        std::vector<std::pair<int, int>>,
+				                                        std::greater<>>();
+				       queue.emplace(0, src);
+				       while (not queue.empty()) {
+					       auto const [d, u] = queue.top();
+					       queue.pop();
+					       if (d != distance[u]) {
+						       continue;
+					       }
+					       for (auto const& [from, to, weight] : g.out_edges(u)) {
+						       auto const next = d + weight.value_or(1);
+						       auto it = distance.find(to);
+						       if (it == distance.end() or next < it->second) {
+							       distance[to] = next;
+							       queue.emplace(next, to);
+						       }
+					       }
+				       }
+				       expected += distance.size();
+			       }
+		       }),
+		       sources * count);
+
+		auto tree = gdwg::shortest_path_tree<int>();
+		auto reached = std::size_t{0};
+		for (auto const* run : {"first", "reused tree"}) {
+			report("shortest_paths", std::string("shortest_paths x3, ") + run, time_ms([&] {
+				       reached = 0;
+				       for (auto src = 0; src < sources; ++src) {
+					       gdwg::shortest_paths(g, src, tree);
+					       for (auto id = std::size_t{0}; id < g.id_bound(); ++id) {
+						       reached += tree.reached(id) ? 1U : 0U;
+					       }
+				       }
+			       }),
+			       sources * count);
+		}
+		if (reached != expected) {
+			std::cout << "shortest_paths: reached " << reached << " nodes, expected " << expected << "\n";
+		}
+		auto rng = std::mt19937(21);
+		auto node = std::uniform_int_distribution<int>(0, nodes - 1);
+		auto constexpr queries = 20;
+		report("shortest_paths", "shortest_path between random pairs x20", time_ms([&] {
+			       for (auto i = 0; i < queries; ++i) {
+				       static_cast<void>(gdwg::shortest_path(g, node(rng), node(rng), tree));
+			       }
+		       }),
+		       queries);
+	}
+
+	auto bench_point_to_point() -> void {
+		auto constexpr side = 300;
+		auto constexpr min_cost = 10;
+		auto const ids = node_range(side * side);
+		auto const streets = street_grid(side, min_cost, 23);
+		auto g = gdwg::graph<int, int>(ids.begin(), ids.end());
+		g.track_in_edges(true);
+		g.insert_edges(streets.begin(), streets.end());
+		auto rng = std::mt19937(23);
+		auto tables = std::optional<gdwg::landmarks<int, int>>();
+		report("point_to_point", "8 landmarks", time_ms([&] { tables.emplace(g, 8); }), 0);
+
+		auto constexpr queries = 200;
+		auto node = std::uniform_int_distribution<int>(0, side * side - 1);
+		auto pairs = std::vector<std::pair<int, int>>();
+		for (auto i = 0; i < queries; ++i) {
+			pairs.emplace_back(node(rng), node(rng));
+		}
+		auto forward = gdwg::shortest_path_tree<int>();
+		auto backward = gdwg::shortest_path_tree<int>();
+		// per-query latencies and settled nodes, counting the backward tree's for the bidirectional
+		// search, and checking each distance against Dijkstra's
+		auto expected = std::vector<int>();
+		auto const run = [&](std::string_view variant, bool bidirectional, auto const& query) {
+			auto latencies = std::vector<double>();
+			auto settled = std::size_t{0};
+			auto wrong = 0;
+			for (auto i = std::size_t{0}; i < pairs.size(); ++i) {
+				auto found = std::optional<gdwg::shortest_path_result<int, int>>();
+				latencies.push_back(time_ms([&] { found = query(pairs[i].first, pairs[i].second); }));
+				settled += forward.settled_count() + (bidirectional ? backward.settled_count() : 0U);
+				if (expected.size() < pairs.size()) {
+					expected.push_back(found->distance);
+				}
+				wrong += found->distance == expected[i] ? 0 : 1;
+			}
+			std::sort(latencies.begin(), latencies.end());
+			auto const at = [&latencies](double q) {
+				return latencies[static_cast<std::size_t>(q * static_cast<double>(latencies.size() - 1))];
+			};
+			std::cout << "point_to_point / " << variant << ", " << queries << " queries: " << settled / pairs.size()
+			          << " settled per query, p50 " << at(0.5) << " ms, p99 " << at(0.99) << " ms\n";
+			if (wrong != 0) {
+				std::cout << "point_to_point: " << wrong << " distances differ from Dijkstra's\n";
+			}
+		};
+		run("Dijkstra", false, [&](int src, int dst) { return gdwg::shortest_path(g, src, dst, forward); });
+		run("bidirectional Dijkstra", true, [&](int src, int dst) {
+			return gdwg::bidirectional_shortest_path(g, src, dst, forward, backward);
+		});
+		// a straight line estimate: every street costs at least min_cost per block
+		run("A*, manhattan distance", false, [&](int src, int dst) {
+			auto const manhattan = [&](int id) {
+				return min_cost * (std::abs(id / side - dst / side) + std::abs(id % side - dst % side));
+			};
+			return gdwg::astar_shortest_path(g, src, dst, manhattan, forward);
+		});
+		run("ALT, 8 landmarks", false, [&](int src, int dst) {
+			return gdwg::alt_shortest_path(g, src, dst, *tables, forward);
+		});
+	}
+
+	auto bench_contraction_hierarchy() -> void {
+		auto constexpr side = 300;
+		auto const ids = node_range(side * side);
+		auto const streets = street_grid(side, 10, 23);
+		auto g = gdwg::graph<int, int>(ids.begin(), ids.end());
+		g.insert_edges(streets.begin(), streets.end());
+
+		auto hierarchy = std::optional<gdwg::contraction_hierarchy<int, int>>();
+		auto const threads = gdwg::detail::worker_count(0);
+		for (auto const workers : {std::size_t{1}, threads}) {
+			report("contraction_hierarchy",
+			       "preprocessing, " + std::to_string(workers) + (workers == 1 ? " thread" : " threads"),
+			       time_ms([&] { hierarchy.emplace(g, gdwg::contraction_options<int>{.threads = workers}); }),
+			       ids.size());
+			if (threads == 1) {
+				break;
+			}
+		}
+		std::cout << "contraction_hierarchy / " << hierarchy->arc_count() << " arcs, " << hierarchy->shortcut_count()
+		          << " shortcuts for " << streets.size() << " edges\n";
+		auto const path = std::string("gdwg_bench_hierarchy.bin");
+		report("contraction_hierarchy", "save_hierarchy", time_ms([&] { gdwg::save_hierarchy(*hierarchy, path); }), 0);
+		report("contraction_hierarchy",
+		       "load_hierarchy",
+		       time_ms([&] { hierarchy.emplace(gdwg::load_hierarchy<int, int>(path)); }),
+		       0);
+		std::remove(path.c_str());
+
+		auto rng = std::mt19937(24);
+		auto node = std::uniform_int_distribution<int>(0, side * side - 1);
+		auto constexpr queries = 1000;
+		auto query = gdwg::contraction_hierarchy<int, int>::query(*hierarchy);
+		auto tree = gdwg::shortest_path_tree<int>();
+		auto latencies = std::vector<double>();
+		auto settled = std::size_t{0};
+		auto wrong = 0;
+		for (auto i = 0; i < queries; ++i) {
+			auto const src = node(rng);
+			auto const dst = node(rng);
+			auto distance = std::optional<int>();
+			latencies.push_back(time_ms([&] { distance = query.distance(src, dst); }) * 1000.0);
+			settled += query.settled_count();
+			// checking against Dijkstra is slow, a sample will do
+			if (i % 20 == 0) {
+				wrong += distance == gdwg::shortest_path(g, src, dst, tree)->distance ? 0 : 1;
+			}
+		}
+		std::sort(latencies.begin(), latencies.end());
+		auto const at = [&latencies](double q) {
+			return latencies[static_cast<std::size_t>(q * static_cast<double>(latencies.size() - 1))];
+		};
+		std::cout << "contraction_hierarchy / " << queries << " distance queries: " << settled / queries
+		          << " settled per query, p50 " << at(0.5) << " us, p99 " << at(0.99) << " us\n";
+		if (wrong != 0) {
+			std::cout << "contraction_hierarchy: " << wrong << " distances differ from Dijkstra's\n";
+		}
+		report("contraction_hierarchy", "path queries", time_ms([&] {
+			       for (auto i = 0; i < queries; ++i) {
+				       static_cast<void>(query.path(node(rng), node(rng)));
+			       }
+		       }),
+		       queries);
+	}
+
+	auto bench_delta_stepping() -> void {
+		auto constexpr nodes = 1'000'000;
+		auto constexpr count = std::size_t{4'000'000};
+		auto const ids = node_range(nodes);
+		auto const edges = random_edges(nodes, count, 20);
+		auto g = gdwg::graph<int, int>(ids.begin(), ids.end());
+		g.insert_edges(edges.begin(), edges.end());
+		auto constexpr sources = 3;
+
+		auto expected = std::vector<gdwg::shortest_path_tree<int>>(sources);
+		report("delta_stepping", "shortest_paths x3", time_ms([&] {
+			       for (auto src = 0; src < sources; ++src) {
+				       gdwg::shortest_paths(g, src, expected[static_cast<std::size_t>(src)]);
+			       }
+		       }),
+		       sources * count);
+		auto workspace = gdwg::delta_stepping_workspace<int>();
+		auto const run = [&](std::string const& variant, gdwg::delta_stepping_options<int> const& options) {
+			auto wrong = std::size_t{0};
+			auto ms = 0.0;
+			for (auto src = 0; src < sources; ++src) {
+				ms += time_ms([&] { gdwg::delta_stepping(g, src, workspace, options); });
+				auto const& tree = expected[static_cast<std::size_t>(src)];
+				for (auto id = std::size_t{0}; id < g.id_bound(); ++id) {
+					auto const same = workspace.reached(id) == tree.reached(id)
+					                  and (not tree.reached(id) or workspace.distance(id) == tree.distance(id));
+					wrong += same ? 0U : 1U;
+				}
+			}
+			report("delta_stepping", variant + " x3", ms, sources * count);
+			if (wrong != 0) {
+				std::cout << "delta_stepping: " << wrong << " distances differ from Dijkstra's\n";
+			}
+		};
+		// doubling the workers up to one per core
+		auto const threads = gdwg::detail::worker_count(0);
+		auto const label = [](std::size_t n) { return std::to_string(n) + (n == 1 ? " thread" : " threads"); };
+		for (auto workers = std::size_t{1}; workers < threads * 2; workers *= 2) {
+			auto const used = std::min(workers, threads);
+			run(label(used), {.threads = used});
+		}
+		for (auto const delta : {1, 10, 30, 100}) {
+			run("delta " + std::to_string(delta) + ", " + label(threads), {.delta = delta, .threads = threads});
+		}
+	}
+
+	struct benchmark {
+		std::string_view name;
+		std::function<void()> run;
+	};
+
+	auto const benchmarks = std::vector<benchmark>{
+	    {"insert_edges", bench_insert_edges},
+	    {"copy", bench_copy},
+	    {"parallel_copy", bench_parallel_copy},
+	    {"erase_node", bench_erase_node},
+	    {"lookup", bench_lookup},
+	    {"arena", bench_arena},
+	    {"equality", bench_equality},
+	    {"write_text", bench_write_text},
+	    {"read_text", bench_read_text},
+	    {"binary", bench_binary},
+	    {"import", bench_import},
+	    {"journal", bench_journal},
+	    {"batch", bench_batch},
+	    {"concurrent", bench_concurrent},
+	    {"rcu", bench_rcu},
+	    {"traversal", bench_traversal},
+	    {"shortest_paths", bench_shortest_paths},
+	    {"point_to_point", bench_point_to_point},
+	    {"contraction_hierarchy", bench_contraction_hierarchy},
+	    {"delta_stepping", bench_delta_stepping},
+	};
+} // namespace
+
+auto main(int argc, char* argv[]) -> int {
+	auto const selected = std::vector<std::string_view>(argv + 1, argv + argc);
+	for (auto const& b : benchmarks) {
+		if (selected.empty() or std::find(selected.begin(), selected.end(), b.name) != selected.end()) {
+			b.run();
+		}
+	}
+}
@@ -1,9 +1,12 @@
 #ifndef GDWG_GRAPH_H
 #define GDWG_GRAPH_H
+#include <cstdint>
 #include <initializer_list>
 #include <type_traits>
 #include <unordered_map>
 #include <algorithm>
+#include <atomic>
+#include <cstddef>
 #include <exception>
 #include <functional>
 #include <iomanip>
@@ -11,11 +14,15 @@
 #include <iterator>
 #include <map>
 #include <memory>
+#include <memory_resource>
 #include <optional>
 #include <set>
+#include <span>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <tuple>
 #include <utility>
 #include <vector>
@@ -24,6 +31,34 @@ namespace gdwg {
 	class TestHelper;
 	template<typename N, typename E>
 	class graph;
+	template<typename N, typename E>
+	class frozen_graph;
+	struct import_options;
+	struct import_stats;
+
+	// Copying, clearing or destroying a graph with at least threshold node ids splits its buckets
+	// across up to threads workers, 0 meaning one per core. Buckets are only allocated or freed on
+	// several threads when the graph's memory resource is thread safe.
+	struct parallel_options {
+		std::size_t threads = 0;
+		std::size_t threshold = std::size_t{1} << 16;
+	};
+	auto set_parallel_options(parallel_options const& options) noexcept -> void;
+	[[nodiscard]] auto get_parallel_options() noexcept -> parallel_options;
+
+	namespace detail {
+		inline auto parallel_threads = std::atomic<std::size_t>(parallel_options().threads);
+		inline auto parallel_threshold = std::atomic<std::size_t>(parallel_options().threshold);
+
+		// threads to use when asked for requested, 0 meaning one per core
+		auto worker_count(std::size_t requested) noexcept -> std::size_t;
+		// runs task(0) .. task(count - 1) on count threads, the calling thread included, and rethrows
+		// the first exception a task threw once all of them have finished
+		template<typename F>
+		auto run_parallel(std::size_t count, F const& task) -> void;
+		// whether resource may be allocated from and freed to on several threads at once
+		auto thread_safe(std::pmr::memory_resource* resource) noexcept -> bool;
+	} // namespace detail
 
 	template<typename N, typename E>
 	class edge {
@@ -52,12 +87,74 @@ namespace gdwg {
 		friend class graph;
 	};
 
+	// Copies share edge buckets until one side writes to them. A graph and its copies may each be used
+	// on a different thread, but one graph must not be used from two threads at once.
 	template<typename N, typename E>
 	class graph {
 	 public:
 		using edge = gdwg::edge<N, E>;
-		// using iterator = typename std::vector<std::unique_ptr<edge>>::const_iterator;
-		// using const_iterator = typename std::vector<std::unique_ptr<edge>>::const_iterator;
+		// dense id of an interned node, valid until the node is erased (ids are then reused)
+		using node_id = std::uint32_t;
+		// an out-edge stored inline in its source's bucket, the source is the bucket's index
+		struct edge_record {
+			node_id dst;
+			std::optional<E> weight;
+			friend auto operator==(edge_record const& a, edge_record const& b) -> bool = default;
+		};
+		using bucket = std::pmr::vector<edge_record>;
+		// N -> id interning table
+		using node_map = std::pmr::map<N, node_id>;
+		// every container of the graph, including its indices, allocates from this allocator's resource
+		using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+		// an edge borrowed from the graph, valid until the graph is next modified
+		struct edge_ref {
+			N const& from;
+			N const& to;
+			std::optional<E> const& weight;
+		};
+		// allocation-free range over a run of one source's stored edges
+		class edge_view {
+		 public:
+			class iterator {
+			 public:
+				using value_type = edge_ref;
+				using reference = edge_ref;
+				using pointer = void;
+				using difference_type = std::ptrdiff_t;
+				using iterator_category = std::bidirectional_iterator_tag;
+
+				iterator() = default;
+				auto operator*() const -> reference;
+				auto operator++() -> iterator&;
+				auto operator++(int) -> iterator;
+				auto operator--() -> iterator&;
+				auto operator--(int) -> iterator;
+				auto operator==(iterator const& other) const -> bool = default;
+
+			 private:
+				N const* from = nullptr;
+				N const* const* values = nullptr;
+				edge_record const* record = nullptr;
+				iterator(N const* from, N const* const* values, edge_record const* record);
+
+				friend class edge_view;
+			};
+
+			edge_view() = default;
+			[[nodiscard]] auto begin() const -> iterator;
+			[[nodiscard]] auto end() const -> iterator;
+			[[nodiscard]] auto size() const noexcept -> std::size_t;
+			[[nodiscard]] auto empty() const noexcept -> bool;
+
+		 private:
+			N const* from_ = nullptr;
+			N const* const* values_ = nullptr;
+			edge_record const* first_ = nullptr;
+			edge_record const* last_ = nullptr;
+			edge_view(N const* from, N const* const* values, edge_record const* first, edge_record const* last);
+
+			friend class graph;
+		};
 		class iterator {
 		 public:
 			using value_type = struct {
@@ -82,43 +179,85 @@ namespace gdwg {
 			auto operator==(iterator const& other) const -> bool;
 
 		 private:
-			typename std::map<N, std::vector<std::unique_ptr<edge>>>::const_iterator map_it;
-			typename std::vector<std::unique_ptr<edge>>::const_iterator vec_it;
+			typename node_map::const_iterator map_it;
+			typename bucket::const_iterator vec_it;
 			const graph* g;
+			// id -> value table, kept apart from g so dereferencing survives a move of the graph
+			N const* const* values;
 			iterator(const graph* graph, bool end = false);
 			iterator(const graph* graph,
-			         typename std::map<N, std::vector<std::unique_ptr<edge>>>::const_iterator map_it,
-			         typename std::vector<std::unique_ptr<edge>>::const_iterator vec_it);
+			         typename node_map::const_iterator map_it,
+			         typename bucket::const_iterator vec_it);
+
+			friend class graph;
+		};
+
+		// mutations recorded by batch() and applied together by commit()
+		class transaction {
+		 public:
+			auto insert_node(N const& value) -> void;
+			auto insert_edge(N const& src, N const& dst, std::optional<E> weight = std::nullopt) -> void;
+			auto erase_edge(N const& src, N const& dst, std::optional<E> weight = std::nullopt) -> void;
+			auto erase_node(N const& value) -> void;
+			// applies the recorded operations as if they had been called on the graph in order. They are
+			// all checked first, so if one would throw, commit throws its error and the graph is left as
+			// it was. The same holds if an allocation, N or E throws while they are applied. The
+			// transaction is empty afterwards either way
+			auto commit() -> void;
+			[[nodiscard]] auto size() const noexcept -> std::size_t;
+
+		 private:
+			enum class kind : unsigned char { insert_node, insert_edge, erase_edge, erase_node };
+			struct operation {
+				kind op;
+				N src;
+				// src again for the node operations
+				N dst;
+				std::optional<E> weight;
+			};
+			graph* g_;
+			std::vector<operation> ops_;
+			explicit transaction(graph& g);
 
 			friend class graph;
 		};
 
 		graph();
+		explicit graph(allocator_type alloc);
 		// Your member functions go here
 		template<typename InputIt>
-		graph(InputIt first, InputIt last);
+		graph(InputIt first, InputIt last, allocator_type alloc = {});
 
-		graph(std::initializer_list<N> il)
-		: graph(il.begin(), il.end()) { // delegate to range constructor
+		graph(std::initializer_list<N> il, allocator_type alloc = {})
+		: graph(il.begin(), il.end(), alloc) { // delegate to range constructor
 		}
 
 		graph(graph&& other) noexcept;
-		// move assignment opeartor=
+		// move assignment opeartor=, takes other's resource along with its storage so that nothing is
+		// copied, even when *this used a different resource before
 		auto operator=(graph&& other) noexcept -> graph&;
-		// copy constructor
+		// copy constructor, like the std::pmr containers the copy uses the default resource
 		graph(graph const& other);
+		// copy into the given resource
+		graph(graph const& other, allocator_type alloc);
 		// copy assignment operator=
 		auto operator=(graph const& other) -> graph&;
+		~graph();
 		// modifiers
 		auto insert_node(N const& val) -> bool;
 		// accessors is_node in graph
 		[[nodiscard]] auto is_node(N const& value) const noexcept -> bool;
 
 		auto insert_edge(N const& src, N const& dst, std::optional<E> weight = std::nullopt) -> bool;
+		// bulk insert of (src, dst, weight) triples, returns the number of edges that were new
+		template<typename InputIt>
+		auto insert_edges(InputIt first, InputIt last) -> std::size_t;
 		// replace_node()
 		auto replace_node(N const& old_data, N const& new_data) -> bool;
 		// replace_edge()
 		auto merge_replace_node(N const& old_data, N const& new_data) -> void;
+		// applies the merges in order, but rewrites each affected bucket only once
+		auto merge_replace_nodes(std::vector<std::pair<N, N>> const& pairs) -> void;
 
 		[[nodiscard]] auto empty() -> bool;
 
@@ -140,21 +279,137 @@ namespace gdwg {
 		[[nodiscard]] auto end() const -> iterator;
 
 		[[nodiscard]] auto operator==(graph const& other) const noexcept -> bool;
-		auto erase_edge(iterator i) noexcept -> iterator;
+		[[nodiscard]] auto get_allocator() const noexcept -> allocator_type;
+		// not noexcept, the bucket is copied first when a copy of the graph shares it
+		auto erase_edge(iterator i) -> iterator;
 
-		auto erase_edge(iterator i, iterator s) noexcept -> iterator;
+		auto erase_edge(iterator i, iterator s) -> iterator;
 
 		auto clear() noexcept -> void;
 
+		// Records node and edge insertions and erasures to apply on commit(). Each bucket is then
+		// rewritten once however many of its edges change, and without an in-edge index the edges
+		// into erased nodes are removed in one scan. An uncommitted transaction changes nothing
+		[[nodiscard]] auto batch() -> transaction;
+
+		// immutable CSR snapshot, defined in gdwg_frozen_graph.h
+		[[nodiscard]] auto freeze() const -> frozen_graph<N, E>;
+
+		// interning table, lets algorithms work on dense integer ids instead of N
+		[[nodiscard]] auto id_of(N const& value) const -> node_id;
+		[[nodiscard]] auto node_at(node_id id) const -> N const&;
+		// one past the largest id in use, for sizing id-indexed arrays
+		[[nodiscard]] auto id_bound() const noexcept -> std::size_t;
+		// the stored out-edges of id in (dst value, weight) order, empty for a free id; id must be
+		// below id_bound(). Valid until the graph is next modified
+		[[nodiscard]] auto out_records(node_id id) const noexcept -> std::span<edge_record const>;
+
+		// optionally maintained incoming-edge index, makes erase_node O(in + out degree)
+		// and lets the in-edge queries below avoid a scan of every bucket
+		auto track_in_edges(bool enabled) -> void;
+		[[nodiscard]] auto tracks_in_edges() const noexcept -> bool;
+		// the reverse adjacency: the stored in-edges of id as records whose dst holds the source id,
+		// in (source id, weight) order. Empty unless in-edges are tracked, otherwise as out_records
+		[[nodiscard]] auto in_records(node_id id) const noexcept -> std::span<edge_record const>;
+		// edges into dst, ordered by (src, weight)
+		[[nodiscard]] auto in_edges(N const& dst) const -> std::vector<std::unique_ptr<edge>>;
+		[[nodiscard]] auto in_degree(N const& dst) const -> std::size_t;
+		[[nodiscard]] auto predecessors(N const& dst) const -> std::vector<N>;
+
+		// optionally maintained order-independent 64-bit hash of the nodes and edges, updated by every
+		// mutation. Equal graphs have equal fingerprints, so operator== rejects most unequal ones in O(1)
+		auto track_fingerprint(bool enabled) -> void;
+		[[nodiscard]] auto fingerprint() const noexcept -> std::optional<std::uint64_t>;
+
+		// zero-copy views of the stored edges, in (dst, weight) order
+		[[nodiscard]] auto out_edges(N const& src) const -> edge_view;
+		[[nodiscard]] auto edges_between(N const& src, N const& dst) const -> edge_view;
+
 		template<typename Node, typename Edge>
 		friend auto operator<<(std::ostream& os, graph<Node, Edge> const& g) -> std::ostream&;
+		// buffered writer of the operator<< format, defined in gdwg_graph_io.h
+		template<typename Node, typename Edge, typename Sink>
+		friend auto write_text(graph<Node, Edge> const& g, Sink&& sink) -> void;
+		template<typename Node, typename Edge>
+		friend auto read_text(std::string_view text) -> graph<Node, Edge>;
+		// parallel edge list importer, defined in gdwg_graph_io.h
+		template<typename Node, typename Edge>
+		friend auto import_edges(graph<Node, Edge>& g, std::string_view text, import_options const& options)
+		    -> import_stats;
+		// binary snapshot writer, defined in gdwg_mapped_graph.h
+		template<typename Node, typename Edge>
+		friend auto save_binary(graph<Node, Edge> const& g, std::string const& path) -> void;
 
 	 private:
-		std::set<N> nodes_;
-		std::map<N, std::vector<std::unique_ptr<edge>>> edges_;
-		struct edge_hash;
-		friend struct edge_hash;
-		[[nodiscard]] auto edges(N const& src) const -> std::vector<std::unique_ptr<edge>>;
+		// N -> id, ordered by N so nodes and edges iterate in value order
+		node_map nodes_;
+		// id -> N, points at the keys of nodes_, nullptr for a free id
+		std::pmr::vector<N const*> values_;
+		std::pmr::vector<node_id> free_ids_;
+		// buckets are shared between copies of the graph until one of them writes to it. Copies may be
+		// read and destroyed on other threads while this graph writes, see owns()
+		using shared_bucket = std::shared_ptr<bucket>;
+		// out-edges of each id, sorted by (dst value, weight) with the unweighted edge first
+		std::pmr::vector<shared_bucket> edges_;
+		// in-edges of each id when track_in_, records hold the source id, sorted by (src id, weight)
+		std::pmr::vector<shared_bucket> in_;
+		bool track_in_ = false;
+		// sum of the node and edge terms below when tracked
+		std::optional<std::uint64_t> fingerprint_;
+		static constexpr bool hashable = requires(N const& n, E const& e) {
+			std::hash<N>{}(n);
+			std::hash<E>{}(e);
+		};
+		[[nodiscard]] auto find_id(N const& value) const noexcept -> std::optional<node_id>;
+		// the bucket order, compares destinations by value so iteration follows N's ordering
+		[[nodiscard]] auto record_less(edge_record const& a, edge_record const& b) const noexcept -> bool;
+		auto sort_bucket(bucket& edges) -> void;
+		// re-sorts the buckets holding an edge into id, needed after the value at id changed
+		auto resort_predecessors(node_id id) -> void;
+		auto relink_values() -> void;
+		// a bucket in this graph's resource holding a copy of from
+		[[nodiscard]] auto make_bucket(bucket const& from = bucket()) const -> shared_bucket;
+		// whether no other graph shares b, so it may be written in place
+		[[nodiscard]] static auto owns(shared_bucket const& b) noexcept -> bool;
+		// the bucket for writing, cloned first if another graph still shares it
+		auto unshare(shared_bucket& b) -> bucket&;
+		// empties the bucket without cloning a shared one
+		auto reset_bucket(shared_bucket& b) -> void;
+		// copies other's nodes and buckets into this empty graph. Buckets are shared when both graphs
+		// use the same resource and cloned otherwise, in parallel for large graphs
+		auto copy_from(graph const& other) -> void;
+		// empties the graph, releasing the buckets in parallel for large graphs
+		auto release() noexcept -> void;
+		// the workers for a pass over count buckets, 1 below the threshold or when the pass allocates
+		// or frees and the resource isn't thread safe
+		[[nodiscard]] auto parallel_workers(std::size_t count, bool allocates) const noexcept -> std::size_t;
+		// the run of a sorted bucket whose destination is dst
+		template<typename Bucket>
+		[[nodiscard]] auto dst_range(Bucket& edges, node_id dst) const noexcept;
+		// first position not ordered before record, i.e. where it is or would be inserted
+		template<typename Bucket>
+		[[nodiscard]] auto record_position(Bucket& edges, edge_record const& record) const noexcept;
+		static auto in_less(edge_record const& a, edge_record const& b) noexcept -> bool;
+		auto link_in(node_id src, edge_record const& e) -> void;
+		auto unlink_in(node_id src, edge_record const& e) -> void;
+		auto rebuild_in_edges() -> void;
+		// sorts and dedupes records, then merges them into src's bucket, returns how many were new
+		auto merge_records(node_id src, bucket& records) -> std::size_t;
+		// applies changes, sorted in bucket order with one entry per record, to src's bucket in one pass;
+		// true entries insert their record and false ones erase it
+		auto edit_bucket(node_id src, std::vector<std::pair<edge_record, bool>> const& changes) -> void;
+		// erase_node for each of ids, which are distinct and live
+		auto erase_ids(std::vector<node_id> const& ids) -> void;
+		// merges every key of remap into its (live) value, touching only the buckets involved
+		auto merge_ids(std::unordered_map<node_id, node_id> const& remap) -> void;
+		// fingerprint terms, summed with wraparound so they can be added and removed in any order
+		[[nodiscard]] static auto mix(std::uint64_t x) noexcept -> std::uint64_t;
+		[[nodiscard]] auto node_term(N const& value) const noexcept -> std::uint64_t;
+		[[nodiscard]] auto edge_term(node_id src, edge_record const& e) const noexcept -> std::uint64_t;
+		// the node's own term plus the terms of every edge into or out of it
+		[[nodiscard]] auto node_fingerprint(node_id id) const -> std::uint64_t;
+		// builds the polymorphic edge handed out by edges()
+		static auto make_edge(N const& src, N const& dst, std::optional<E> const& weight) -> std::unique_ptr<edge>;
 	};
 	template<typename N, typename E>
 	class weighted_edge : public edge<N, E> {
@@ -221,42 +476,60 @@ template<typename N, typename E>
 gdwg::graph<N, E>::iterator::iterator()
 : map_it()
 , vec_it()
-, g(nullptr) {}
+, g(nullptr)
+, values(nullptr) {}
 
 template<typename N, typename E>
 gdwg::graph<N, E>::iterator::iterator(const graph* graph, bool end)
-: g(graph) {
+: g(graph)
+, values(graph->values_.data()) {
 	if (end) {
-		map_it = g->edges_.end();
+		map_it = g->nodes_.end();
 	}
 	else {
-		map_it = g->edges_.begin();
-		if (map_it != g->edges_.end()) {
-			vec_it = map_it->second.begin();
+		map_it = g->nodes_.begin();
+		// skip nodes without out-edges
+		while (map_it != g->nodes_.end() and g->edges_[map_it->second]->empty()) {
+			++map_it;
+		}
+		if (map_it != g->nodes_.end()) {
+			vec_it = g->edges_[map_it->second]->begin();
 		}
 	}
 }
 template<typename N, typename E>
 gdwg::graph<N, E>::iterator::iterator(const graph* graph,
-                                      typename std::map<N, std::vector<std::unique_ptr<edge>>>::const_iterator map_it,
-                                      typename std::vector<std::unique_ptr<edge>>::const_iterator vec_it)
+                                      typename node_map::const_iterator map_it,
+                                      typename bucket::const_iterator vec_it)
 : map_it(map_it)
 , vec_it(vec_it)
-, g(graph) {}
+, g(graph)
+, values(graph->values_.data()) {}
 template<typename N, typename E>
 auto gdwg::graph<N, E>::iterator::operator*() const -> const reference {
-	return reference{map_it->first, (*vec_it)->get_nodes().second, (*vec_it)->get_weight()};
+	return reference{map_it->first, *values[vec_it->dst], vec_it->weight};
 }
 template<typename N, typename E>
 gdwg::graph<N, E>::graph()
 : nodes_()
-, edges_() {
+, values_()
+, free_ids_()
+, edges_()
+, in_() {
 	// Constructor
 }
+template<typename N, typename E>
+gdwg::graph<N, E>::graph(allocator_type alloc)
+: nodes_(alloc)
+, values_(alloc)
+, free_ids_(alloc)
+, edges_(alloc)
+, in_(alloc) {}
 
 template<typename N, typename E>
 template<typename InputIt>
-gdwg::graph<N, E>::graph(InputIt first, InputIt last) {
+gdwg::graph<N, E>::graph(InputIt first, InputIt last, allocator_type alloc)
+: graph(alloc) {
 	static_assert(
 	    std::is_base_of<std::input_iterator_tag, typename std::iterator_traits<InputIt>::iterator_category>::value,
 	    "InputIt must be an input iterator");
@@ -273,52 +546,168 @@ template<typename N, typename E>
 gdwg::graph<N, E>::graph(graph&& other) noexcept
 : nodes_(std::exchange(other.nodes_, {}))
 , // using std::exchange to set other.nodes_ to empty
-edges_(std::exchange(other.edges_, {})) // using std::exchange to set other.edges_ to empty
-{}
+values_(std::exchange(other.values_, {}))
+, free_ids_(std::exchange(other.free_ids_, {}))
+, edges_(std::exchange(other.edges_, {})) // using std::exchange to set other.edges_ to empty
+, in_(std::exchange(other.in_, {}))
+, track_in_(std::exchange(other.track_in_, false))
+, fingerprint_(std::exchange(other.fingerprint_, std::nullopt)) {}
 template<typename N, typename E>
 auto gdwg::graph<N, E>::operator=(graph&& other) noexcept -> graph& {
 	if (this != &other) {
-		nodes_ = std::exchange(other.nodes_, {});
-		edges_ = std::exchange(other.edges_, {});
+		// a pmr container can't change its resource, so the old graph is destroyed and the new one is
+		// move constructed in its place. Moving a std::map keeps its nodes, so values_ still points at
+		// the right keys
+		std::destroy_at(this);
+		std::construct_at(this, std::move(other));
 	}
 	return *this;
 }
 template<typename N, typename E>
-gdwg::graph<N, E>::graph(graph const& other) {
-	nodes_ = other.nodes_;
-	// might modify for insert edge
-	for (const auto& [src, edges] : other.edges_) {
-		for (const auto& e : edges) {
-			if (auto we = dynamic_cast<weighted_edge<N, E>*>(e.get())) {
-				edges_[src].push_back(std::make_unique<weighted_edge<N, E>>(*we));
-			}
-			else if (auto ue = dynamic_cast<unweighted_edge<N, E>*>(e.get())) {
-				edges_[src].push_back(std::make_unique<unweighted_edge<N, E>>(*ue));
-			}
-		}
-	}
+gdwg::graph<N, E>::graph(graph const& other)
+: graph(other, allocator_type()) {}
+template<typename N, typename E>
+gdwg::graph<N, E>::graph(graph const& other, allocator_type alloc)
+: nodes_(alloc)
+, values_(alloc)
+, free_ids_(other.free_ids_, alloc)
+, edges_(alloc)
+, in_(alloc)
+, track_in_(other.track_in_)
+, fingerprint_(other.fingerprint_) {
+	copy_from(other);
+}
+template<typename N, typename E>
+gdwg::graph<N, E>::~graph() {
+	release();
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::get_allocator() const noexcept -> allocator_type {
+	return allocator_type(nodes_.get_allocator().resource());
 }
 template<typename N, typename E>
 auto gdwg::graph<N, E>::operator=(graph const& other) -> graph& {
 	if (this != &other) {
-		// clear the current nodes and edges
-		nodes_.clear();
-		edges_.clear();
-		// deep copy nodes
+		// the copy is built aside in this graph's resource, so if it throws *this is left as it was.
+		// Edges are stored by value in shared buckets, each side clones a bucket before writing it
+		*this = graph(other, get_allocator());
+	}
+	return *this;
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::copy_from(graph const& other) -> void {
+	// a shared bucket must not outlive its resource, so only buckets of the same resource are shared
+	auto const share = get_allocator() == other.get_allocator();
+	edges_.resize(other.edges_.size());
+	in_.resize(other.in_.size());
+	auto const copy = [this, &other, share](std::pmr::vector<shared_bucket>& to,
+	                                       std::pmr::vector<shared_bucket> const& from,
+	                                       std::size_t first,
+	                                       std::size_t last) {
+		for (auto i = first; i < std::min(last, from.size()); ++i) {
+			to[i] = share ? from[i] : make_bucket(*from[i]);
+		}
+	};
+	auto const workers = parallel_workers(edges_.size(), not share);
+	if (workers == 1) {
 		nodes_ = other.nodes_;
-		// deep copy edges
-		for (const auto& [src, edges] : other.edges_) {
-			for (const auto& e : edges) {
-				if (auto we = dynamic_cast<weighted_edge<N, E>*>(e.get())) {
-					edges_[src].push_back(std::make_unique<weighted_edge<N, E>>(*we));
+		copy(edges_, other.edges_, 0, edges_.size());
+		copy(in_, other.in_, 0, in_.size());
+		relink_values();
+		return;
+	}
+	// one worker copies the node map while the others take a slice of the buckets each
+	auto const slices = workers - 1;
+	detail::run_parallel(workers, [&](std::size_t w) {
+		if (w == 0) {
+			nodes_ = other.nodes_;
+			relink_values();
+			return;
+		}
+		auto const first = edges_.size() * (w - 1) / slices;
+		auto const last = edges_.size() * w / slices;
+		copy(edges_, other.edges_, first, last);
+		copy(in_, other.in_, first, last);
+	});
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::release() noexcept -> void {
+	auto const workers = parallel_workers(edges_.size(), true);
+	if (workers > 1) {
+		auto const slices = workers - 1;
+		try {
+			detail::run_parallel(workers, [this, slices](std::size_t w) {
+				if (w == 0) {
+					nodes_.clear();
+					return;
 				}
-				else if (auto ue = dynamic_cast<unweighted_edge<N, E>*>(e.get())) {
-					edges_[src].push_back(std::make_unique<unweighted_edge<N, E>>(*ue));
+				auto const first = edges_.size() * (w - 1) / slices;
+				auto const last = edges_.size() * w / slices;
+				for (auto i = first; i < last; ++i) {
+					edges_[i].reset();
 				}
-			}
+				for (auto i = first; i < std::min(last, in_.size()); ++i) {
+					in_[i].reset();
+				}
+			});
+		} catch (...) {
+			// not every thread could be started, whatever is left is released below
 		}
 	}
-	return *this;
+	nodes_.clear();
+	values_.clear();
+	free_ids_.clear();
+	edges_.clear();
+	in_.clear();
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::parallel_workers(std::size_t count, bool allocates) const noexcept -> std::size_t {
+	if (count < detail::parallel_threshold.load(std::memory_order_relaxed)
+	    or (allocates and not detail::thread_safe(get_allocator().resource())))
+	{
+		return 1;
+	}
+	return std::min(detail::worker_count(detail::parallel_threads.load(std::memory_order_relaxed)), count);
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::relink_values() -> void {
+	values_.assign(edges_.size(), nullptr);
+	for (auto const& [value, id] : nodes_) {
+		values_[id] = &value;
+	}
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::make_bucket(bucket const& from) const -> shared_bucket {
+	return std::allocate_shared<bucket>(std::pmr::polymorphic_allocator<bucket>(get_allocator()), from);
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::owns(shared_bucket const& b) noexcept -> bool {
+	if (b.use_count() > 1) {
+		return false;
+	}
+	// use_count() is a relaxed load, so it doesn't order the last other owner's reads of the bucket
+	// before our writes. Taking a reference reads the count with a read-modify-write, which sees that
+	// owner's release decrement, and the fence makes the read an acquire. Only this graph can hand out
+	// references to b, so nobody can start sharing it in between
+	auto const probe = b;
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return probe.use_count() == 2;
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::unshare(shared_bucket& b) -> bucket& {
+	if (not owns(b)) {
+		b = make_bucket(*b);
+	}
+	return *b;
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::reset_bucket(shared_bucket& b) -> void {
+	if (not owns(b)) {
+		b = make_bucket();
+	}
+	else {
+		b->clear();
+	}
 }
 template<typename N, typename E>
 auto gdwg::weighted_edge<N, E>::get_weight() const noexcept -> std::optional<E> {
@@ -354,57 +743,324 @@ auto gdwg::unweighted_edge<N, E>::print_edge() const noexcept -> std::string {
 }
 template<typename N, typename E>
 auto gdwg::graph<N, E>::insert_node(N const& value) -> bool {
-	auto result = nodes_.insert(value);
-	return result.second;
+	auto [it, inserted] = nodes_.emplace(value, node_id{0});
+	if (!inserted) {
+		return false;
+	}
+	// reuse an erased id before growing the id space
+	if (free_ids_.empty()) {
+		it->second = static_cast<node_id>(values_.size());
+		values_.push_back(&it->first);
+		edges_.push_back(make_bucket());
+		if (track_in_) {
+			in_.push_back(make_bucket());
+		}
+	}
+	else {
+		it->second = free_ids_.back();
+		free_ids_.pop_back();
+		values_[it->second] = &it->first;
+	}
+	if (fingerprint_) {
+		*fingerprint_ += node_term(value);
+	}
+	return true;
 }
 template<typename N, typename E>
 [[nodiscard]] auto gdwg::graph<N, E>::is_node(N const& value) const noexcept -> bool {
 	return nodes_.find(value) != nodes_.end();
 }
 template<typename N, typename E>
+auto gdwg::graph<N, E>::find_id(N const& value) const noexcept -> std::optional<node_id> {
+	auto it = nodes_.find(value);
+	if (it == nodes_.end()) {
+		return std::nullopt;
+	}
+	return it->second;
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::id_of(N const& value) const -> node_id {
+	auto id = find_id(value);
+	if (!id) {
+		throw std::runtime_error("Cannot call gdwg::graph<N, E>::id_of on a node that doesn't exist");
+	}
+	return *id;
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::node_at(node_id id) const -> N const& {
+	if (id >= values_.size() or values_[id] == nullptr) {
+		throw std::runtime_error("Cannot call gdwg::graph<N, E>::node_at on an id that doesn't name a node");
+	}
+	return *values_[id];
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::id_bound() const noexcept -> std::size_t {
+	return values_.size();
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::out_records(node_id id) const noexcept -> std::span<edge_record const> {
+	return std::span<edge_record const>(edges_[id]->data(), edges_[id]->size());
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::record_less(edge_record const& a, edge_record const& b) const noexcept -> bool {
+	if (a.dst != b.dst) {
+		return *values_[a.dst] < *values_[b.dst];
+	}
+	// unweighted edges precede weighted ones, as std::nullopt orders first
+	return a.weight < b.weight;
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::sort_bucket(bucket& edges) -> void {
+	std::sort(edges.begin(), edges.end(), [this](auto const& a, auto const& b) { return record_less(a, b); });
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::resort_predecessors(node_id id) -> void {
+	if (track_in_) {
+		// in_ is sorted by source id, so each predecessor is visited once
+		auto const& in = *in_[id];
+		for (auto it = in.begin(); it != in.end(); ++it) {
+			if (it == in.begin() or it->dst != std::prev(it)->dst) {
+				sort_bucket(unshare(edges_[it->dst]));
+			}
+		}
+		return;
+	}
+	for (auto& edges : edges_) {
+		if (std::any_of(edges->begin(), edges->end(), [id](auto const& e) { return e.dst == id; })) {
+			sort_bucket(unshare(edges));
+		}
+	}
+}
+template<typename N, typename E>
+template<typename Bucket>
+auto gdwg::graph<N, E>::dst_range(Bucket& edges, node_id dst) const noexcept {
+	auto const& value = *values_[dst];
+	return std::equal_range(edges.begin(), edges.end(), value, [this](auto const& a, auto const& b) {
+		if constexpr (std::is_same_v<std::decay_t<decltype(a)>, edge_record>) {
+			return *values_[a.dst] < b;
+		}
+		else {
+			return a < *values_[b.dst];
+		}
+	});
+}
+template<typename N, typename E>
+template<typename Bucket>
+auto gdwg::graph<N, E>::record_position(Bucket& edges, edge_record const& record) const noexcept {
+	return std::lower_bound(edges.begin(), edges.end(), record, [this](auto const& a, auto const& b) {
+		return record_less(a, b);
+	});
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::in_less(edge_record const& a, edge_record const& b) noexcept -> bool {
+	return std::tie(a.dst, a.weight) < std::tie(b.dst, b.weight);
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::link_in(node_id src, edge_record const& e) -> void {
+	auto& in = unshare(in_[e.dst]);
+	auto const record = edge_record{src, e.weight};
+	in.insert(std::upper_bound(in.begin(), in.end(), record, in_less), record);
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::unlink_in(node_id src, edge_record const& e) -> void {
+	auto const& in = *in_[e.dst];
+	auto const record = edge_record{src, e.weight};
+	auto it = std::lower_bound(in.begin(), in.end(), record, in_less);
+	if (it != in.end() and *it == record) {
+		auto const pos = it - in.begin();
+		auto& owned = unshare(in_[e.dst]);
+		owned.erase(owned.begin() + pos);
+	}
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::rebuild_in_edges() -> void {
+	in_.clear();
+	in_.reserve(edges_.size());
+	std::generate_n(std::back_inserter(in_), edges_.size(), [this] { return make_bucket(); });
+	// visiting sources in id order leaves every in-bucket sorted by source id
+	for (auto src = node_id{0}; src < edges_.size(); ++src) {
+		for (auto const& e : *edges_[src]) {
+			in_[e.dst]->push_back(edge_record{src, e.weight});
+		}
+	}
+	for (auto& in : in_) {
+		std::sort(in->begin(), in->end(), in_less);
+	}
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::track_in_edges(bool enabled) -> void {
+	if (enabled and !track_in_) {
+		rebuild_in_edges();
+	}
+	else if (!enabled) {
+		in_.clear();
+		in_.shrink_to_fit();
+	}
+	track_in_ = enabled;
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::tracks_in_edges() const noexcept -> bool {
+	return track_in_;
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::in_records(node_id id) const noexcept -> std::span<edge_record const> {
+	if (not track_in_) {
+		return {};
+	}
+	return std::span<edge_record const>(in_[id]->data(), in_[id]->size());
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::in_edges(N const& dst) const -> std::vector<std::unique_ptr<edge>> {
+	auto dst_id = find_id(dst);
+	if (!dst_id) {
+		throw std::runtime_error("Cannot call gdwg::graph<N, E>::in_edges if dst doesn't exist in the graph");
+	}
+	auto result = std::vector<std::unique_ptr<edge>>();
+	if (track_in_) {
+		auto in = bucket(*in_[*dst_id], get_allocator());
+		// in_ is ordered by source id, hand the edges out ordered by source value
+		std::sort(in.begin(), in.end(), [this](auto const& a, auto const& b) { return record_less(a, b); });
+		for (auto const& e : in) {
+			result.push_back(make_edge(*values_[e.dst], dst, e.weight));
+		}
+		return result;
+	}
+	for (auto const& [value, id] : nodes_) {
+		auto [first, last] = dst_range(*edges_[id], *dst_id);
+		for (auto it = first; it != last; ++it) {
+			result.push_back(make_edge(value, dst, it->weight));
+		}
+	}
+	return result;
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::in_degree(N const& dst) const -> std::size_t {
+	auto dst_id = find_id(dst);
+	if (!dst_id) {
+		throw std::runtime_error("Cannot call gdwg::graph<N, E>::in_degree if dst doesn't exist in the graph");
+	}
+	if (track_in_) {
+		return in_[*dst_id]->size();
+	}
+	auto degree = std::size_t{0};
+	for (auto const& edges : edges_) {
+		auto [first, last] = dst_range(*edges, *dst_id);
+		degree += static_cast<std::size_t>(std::distance(first, last));
+	}
+	return degree;
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::predecessors(N const& dst) const -> std::vector<N> {
+	auto dst_id = find_id(dst);
+	if (!dst_id) {
+		throw std::runtime_error("Cannot call gdwg::graph<N, E>::predecessors if dst doesn't exist in the graph");
+	}
+	auto result = std::vector<N>();
+	if (track_in_) {
+		auto const& in = *in_[*dst_id];
+		for (auto it = in.begin(); it != in.end(); ++it) {
+			if (it == in.begin() or it->dst != std::prev(it)->dst) {
+				result.push_back(*values_[it->dst]);
+			}
+		}
+		std::sort(result.begin(), result.end());
+		return result;
+	}
+	for (auto const& [value, id] : nodes_) {
+		auto [first, last] = dst_range(*edges_[id], *dst_id);
+		if (first != last) {
+			result.push_back(value);
+		}
+	}
+	return result;
+}
+template<typename N, typename E>
 auto gdwg::graph<N, E>::insert_edge(N const& src, N const& dst, std::optional<E> weight) -> bool {
 	if (!is_node(src) or !is_node(dst)) {
 		throw std::runtime_error("Cannot call gdwg::graph<N, E>::insert_edge when either src or dst node does not "
 		                         "exist");
 	}
-	// no same weight in edge
-	for (const auto& e : edges_[src]) {
-		if (e->get_nodes() == std::make_pair(src, dst)) {
-			if (weight and e->get_weight() == weight) {
-				return false;
-			}
-			else if (!weight and e->get_weight() == std::nullopt) {
-				return false;
-			}
+	auto const src_id = nodes_.find(src)->second;
+	auto const& edges = *edges_[src_id];
+	auto const record = edge_record{nodes_.find(dst)->second, weight};
+	// no same weight in edge, the bucket stays sorted by inserting at the search position
+	auto pos = record_position(edges, record);
+	if (pos != edges.end() and *pos == record) {
+		return false;
+	}
+	auto const index = pos - edges.begin();
+	auto& owned = unshare(edges_[src_id]);
+	owned.insert(owned.begin() + index, record);
+	if (track_in_) {
+		link_in(src_id, record);
+	}
+	if (fingerprint_) {
+		*fingerprint_ += edge_term(src_id, record);
+	}
+	return true;
+}
+template<typename N, typename E>
+template<typename InputIt>
+auto gdwg::graph<N, E>::insert_edges(InputIt first, InputIt last) -> std::size_t {
+	// bucket by source first so that every bucket is sorted and deduplicated once
+	auto pending = std::pmr::map<node_id, bucket>(get_allocator());
+	for (auto it = first; it != last; ++it) {
+		auto const& [src, dst, weight] = *it;
+		auto src_id = find_id(src);
+		auto dst_id = find_id(dst);
+		if (!src_id or !dst_id) {
+			throw std::runtime_error("Cannot call gdwg::graph<N, E>::insert_edge when either src or dst node does not "
+			                         "exist");
 		}
+		pending[*src_id].push_back(edge_record{*dst_id, std::optional<E>(weight)});
 	}
-	if (weight) {
-		edges_[src].push_back(std::make_unique<weighted_edge<N, E>>(src, dst, *weight));
+	auto added = std::size_t{0};
+	for (auto& [src, records] : pending) {
+		added += merge_records(src, records);
 	}
-	else {
-		edges_[src].push_back(std::make_unique<unweighted_edge<N, E>>(src, dst));
+	return added;
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::merge_records(node_id src, bucket& records) -> std::size_t {
+	// batches read back from a dump arrive in order already, checking is cheaper than sorting
+	auto const less = [this](auto const& a, auto const& b) { return record_less(a, b); };
+	if (!std::is_sorted(records.begin(), records.end(), less)) {
+		sort_bucket(records);
 	}
-	// Sort edges after insertion
-	std::sort(edges_[src].begin(), edges_[src].end(), [](const std::unique_ptr<edge>& a, const std::unique_ptr<edge>& b) {
-		auto a_nodes = a->get_nodes();
-		auto b_nodes = b->get_nodes();
-		if (a_nodes.first != b_nodes.first) {
-			return a_nodes.first < b_nodes.first;
+	records.erase(std::unique(records.begin(), records.end()), records.end());
+	// merge the sorted batch into the already sorted bucket, skipping duplicates
+	auto& stored = unshare(edges_[src]);
+	auto merged = bucket(stored.get_allocator());
+	merged.reserve(stored.size() + records.size());
+	auto added = std::size_t{0};
+	auto s = stored.begin();
+	for (auto& record : records) {
+		while (s != stored.end() and record_less(*s, record)) {
+			merged.push_back(std::move(*s++));
 		}
-		if (a_nodes.second != b_nodes.second) {
-			return a_nodes.second < b_nodes.second;
+		if (s != stored.end() and *s == record) {
+			continue;
 		}
-		auto weighted_a = dynamic_cast<weighted_edge<N, E>*>(a.get());
-		auto weighted_b = dynamic_cast<weighted_edge<N, E>*>(b.get());
-		if (!weighted_a) {
-			return true;
+		if (track_in_) {
+			link_in(src, record);
 		}
-		if (!weighted_b) {
-			return false;
+		if (fingerprint_) {
+			*fingerprint_ += edge_term(src, record);
 		}
-		return *weighted_a->get_weight() < *weighted_b->get_weight();
-	});
-	return true;
+		merged.push_back(std::move(record));
+		++added;
+	}
+	std::move(s, stored.end(), std::back_inserter(merged));
+	stored = std::move(merged);
+	return added;
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::make_edge(N const& src, N const& dst, std::optional<E> const& weight)
+    -> std::unique_ptr<edge> {
+	if (weight) {
+		return std::make_unique<weighted_edge<N, E>>(src, dst, *weight);
+	}
+	return std::make_unique<unweighted_edge<N, E>>(src, dst);
 }
 template<typename N, typename E>
 auto gdwg::graph<N, E>::replace_node(N const& old_data, N const& new_data) -> bool {
@@ -414,10 +1070,18 @@ auto gdwg::graph<N, E>::replace_node(N const& old_data, N const& new_data) -> bo
 	if (is_node(new_data)) {
 		return false;
 	}
-	// Replace the node
+	// Replace the node, keeping its id so the edges follow it
+	auto id = nodes_.find(old_data)->second;
+	if (fingerprint_) {
+		*fingerprint_ -= node_fingerprint(id);
+	}
 	nodes_.erase(old_data);
-	nodes_.insert(new_data);
-	// no need to update the edges, since only the node data is changed
+	values_[id] = &nodes_.emplace(new_data, id).first->first;
+	// the new value may sort differently among its predecessors' destinations
+	resort_predecessors(id);
+	if (fingerprint_) {
+		*fingerprint_ += node_fingerprint(id);
+	}
 	return true;
 }
 template<typename N, typename E>
@@ -426,33 +1090,109 @@ auto gdwg::graph<N, E>::merge_replace_node(N const& old_data, N const& new_data)
 		throw std::runtime_error("Cannot call gdwg::graph<N, E>::merge_replace_node on old or new data if they don't "
 		                         "exist in the graph");
 	}
-	auto new_edges = std::map<N, std::vector<std::unique_ptr<edge>>>{};
-	// Iterate through current edges and replace old_data with new_data
-	for (auto& [src, edges] : edges_) {
-		for (const auto& e : edges) {
-			auto nodes = e->get_nodes();
-			N new_src = (nodes.first == old_data) ? new_data : nodes.first;
-			N new_dst = (nodes.second == old_data) ? new_data : nodes.second;
-			bool duplicate = false;
-			for (const auto& edge : new_edges[new_src]) {
-				if (edge->get_nodes() == std::make_pair(new_src, new_dst) && edge->get_weight() == e->get_weight()) {
-					duplicate = true;
-					break;
-				}
+	if (old_data == new_data) {
+		return;
+	}
+	merge_ids({{nodes_.find(old_data)->second, nodes_.find(new_data)->second}});
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::merge_replace_nodes(std::vector<std::pair<N, N>> const& pairs) -> void {
+	// validate against the graph as it would be after each earlier merge, before touching anything
+	auto remap = std::unordered_map<node_id, node_id>{};
+	for (auto const& [old_data, new_data] : pairs) {
+		auto old_id = find_id(old_data);
+		auto new_id = find_id(new_data);
+		if (!old_id or !new_id or remap.contains(*old_id) or remap.contains(*new_id)) {
+			throw std::runtime_error("Cannot call gdwg::graph<N, E>::merge_replace_nodes on old or new data if they "
+			                         "don't exist in the graph");
+		}
+		if (*old_id != *new_id) {
+			remap.emplace(*old_id, *new_id);
+		}
+	}
+	// follow chains such as a -> b, b -> c so every merged id points at a surviving node
+	for (auto& [old_id, new_id] : remap) {
+		for (auto it = remap.find(new_id); it != remap.end(); it = remap.find(new_id)) {
+			new_id = it->second;
+		}
+	}
+	if (!remap.empty()) {
+		merge_ids(remap);
+	}
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::merge_ids(std::unordered_map<node_id, node_id> const& remap) -> void {
+	auto const target = [&remap](node_id id) {
+		auto it = remap.find(id);
+		return it == remap.end() ? id : it->second;
+	};
+	// records each surviving bucket gains, with destinations already remapped
+	auto pending = std::pmr::map<node_id, bucket>(get_allocator());
+	// out-edges of merged nodes move to their target
+	for (auto const& [old_id, new_id] : remap) {
+		if (fingerprint_) {
+			*fingerprint_ -= node_term(*values_[old_id]);
+		}
+		for (auto const& e : *edges_[old_id]) {
+			if (track_in_ and !remap.contains(e.dst)) {
+				unlink_in(old_id, e);
 			}
-			if (!duplicate) {
-				if (auto we = dynamic_cast<weighted_edge<N, E>*>(e.get())) {
-					new_edges[new_src].push_back(
-					    std::make_unique<weighted_edge<N, E>>(new_src, new_dst, *we->get_weight()));
-				}
-				else if (auto ue = dynamic_cast<unweighted_edge<N, E>*>(e.get())) {
-					new_edges[new_src].push_back(std::make_unique<unweighted_edge<N, E>>(new_src, new_dst));
+			// the merged edges are added back by merge_records, unless they turn out duplicates
+			if (fingerprint_) {
+				*fingerprint_ -= edge_term(old_id, e);
+			}
+			pending[new_id].push_back(edge_record{target(e.dst), e.weight});
+		}
+	}
+	// in-edges of merged nodes are pulled out of their predecessors' buckets
+	auto const extract = [&](node_id src) {
+		auto const points_at_merged = [&](auto const& e) { return remap.contains(e.dst); };
+		if (std::none_of(edges_[src]->begin(), edges_[src]->end(), points_at_merged)) {
+			return;
+		}
+		auto& edges = unshare(edges_[src]);
+		auto keep = std::stable_partition(edges.begin(), edges.end(), [&](auto const& e) {
+			return !remap.contains(e.dst);
+		});
+		for (auto it = keep; it != edges.end(); ++it) {
+			if (fingerprint_) {
+				*fingerprint_ -= edge_term(src, *it);
+			}
+			pending[src].push_back(edge_record{target(it->dst), it->weight});
+		}
+		edges.erase(keep, edges.end());
+	};
+	if (track_in_) {
+		auto preds = std::set<node_id>();
+		for (auto const& [old_id, new_id] : remap) {
+			for (auto const& e : *in_[old_id]) {
+				if (!remap.contains(e.dst)) {
+					preds.insert(e.dst);
 				}
 			}
 		}
+		std::for_each(preds.begin(), preds.end(), extract);
+	}
+	else {
+		for (auto const& [value, id] : nodes_) {
+			if (!remap.contains(id)) {
+				extract(id);
+			}
+		}
+	}
+	// each touched bucket gets one sort of its new records and one sorted merge
+	for (auto& [src, records] : pending) {
+		merge_records(src, records);
+	}
+	for (auto const& [old_id, new_id] : remap) {
+		reset_bucket(edges_[old_id]);
+		if (track_in_) {
+			reset_bucket(in_[old_id]);
+		}
+		nodes_.erase(*values_[old_id]);
+		values_[old_id] = nullptr;
+		free_ids_.push_back(old_id);
 	}
-	edges_ = std::move(new_edges);
-	nodes_.erase(old_data);
 }
 template<typename N, typename E>
 [[nodiscard]] auto gdwg::graph<N, E>::empty() -> bool {
@@ -463,16 +1203,44 @@ auto gdwg::graph<N, E>::erase_node(N const& value) -> bool {
 	if (!is_node(value)) {
 		return false;
 	}
+	auto const id = nodes_.find(value)->second;
+	if (fingerprint_) {
+		*fingerprint_ -= node_fingerprint(id);
+	}
 	// first remove the edge that contains the node might src or dest
-	for (auto& [src, edges] : edges_) {
-		edges.erase(std::remove_if(
-		                edges.begin(),
-		                edges.end(),
-		                [&](auto const& e) { return e->get_nodes().first == value or e->get_nodes().second == value; }),
-		            edges.end());
-	}
-	// remove the node
+	if (track_in_) {
+		// only the node's successors and predecessors are touched
+		for (auto const& e : *edges_[id]) {
+			if (e.dst != id) {
+				unlink_in(id, e);
+			}
+		}
+		auto const& in = *in_[id];
+		for (auto it = in.begin(); it != in.end(); ++it) {
+			if (it->dst != id and (it == in.begin() or it->dst != std::prev(it)->dst)) {
+				auto& edges = unshare(edges_[it->dst]);
+				auto [first, last] = dst_range(edges, id);
+				edges.erase(first, last);
+			}
+		}
+		reset_bucket(in_[id]);
+		reset_bucket(edges_[id]);
+	}
+	else {
+		reset_bucket(edges_[id]);
+		auto const points_at_id = [id](auto const& e) { return e.dst == id; };
+		for (auto& shared : edges_) {
+			// only buckets that lose an edge are cloned away from other copies
+			if (std::any_of(shared->begin(), shared->end(), points_at_id)) {
+				auto& edges = unshare(shared);
+				edges.erase(std::remove_if(edges.begin(), edges.end(), points_at_id), edges.end());
+			}
+		}
+	}
+	// remove the node and release its id
 	nodes_.erase(value);
+	values_[id] = nullptr;
+	free_ids_.push_back(id);
 	return true;
 }
 
@@ -496,15 +1264,8 @@ template<typename N, typename E>
 		throw std::runtime_error("Cannot call gdwg::graph<N, E>::is_connected if src or dst node don't exist in the "
 		                         "graph");
 	}
-	auto it = edges_.find(src);
-	if (it != edges_.end()) {
-		for (const auto& e : it->second) {
-			if (e->get_nodes() == std::make_pair(src, dst)) {
-				return true;
-			}
-		}
-	}
-	return false;
+	auto [first, last] = dst_range(*edges_[nodes_.find(src)->second], nodes_.find(dst)->second);
+	return first != last;
 }
 template<typename N, typename E>
 auto gdwg::graph<N, E>::erase_edge(N const& src, N const& dst, std::optional<E> weight) -> bool {
@@ -512,28 +1273,32 @@ auto gdwg::graph<N, E>::erase_edge(N const& src, N const& dst, std::optional<E>
 		throw std::runtime_error("Cannot call gdwg::graph<N, E>::erase_edge on src or dst if they don't exist in the "
 		                         "graph");
 	}
-	auto it = std::remove_if(edges_[src].begin(), edges_[src].end(), [&](const std::unique_ptr<edge>& e) {
-		auto nodes = e->get_nodes();
-		if (nodes.first == src and nodes.second == dst) {
-			if (weight and e->is_weighted()) {
-				return e->get_weight() == weight;
-			}
-			else if (!weight and !e->is_weighted()) {
-				return true;
-			}
+	auto const src_id = nodes_.find(src)->second;
+	auto const& edges = *edges_[src_id];
+	auto const record = edge_record{nodes_.find(dst)->second, weight};
+	auto it = record_position(edges, record);
+	if (it != edges.end() and *it == record) {
+		auto const pos = it - edges.begin();
+		auto& owned = unshare(edges_[src_id]);
+		owned.erase(owned.begin() + pos);
+		if (track_in_) {
+			unlink_in(src_id, record);
+		}
+		if (fingerprint_) {
+			*fingerprint_ -= edge_term(src_id, record);
 		}
-		return false;
-	});
-	if (it != edges_[src].end()) {
-		edges_[src].erase(it, edges_[src].end());
 		return true;
 	}
 	return false;
 }
 template<typename N, typename E>
 [[nodiscard]] auto gdwg::graph<N, E>::nodes() const noexcept -> std::vector<N> {
-	auto result = std::vector<N>(nodes_.begin(), nodes_.end());
-	std::sort(result.begin(), result.end());
+	// nodes_ is ordered by value already
+	auto result = std::vector<N>();
+	result.reserve(nodes_.size());
+	for (auto const& [value, id] : nodes_) {
+		result.push_back(value);
+	}
 	return result;
 }
 template<typename N, typename E>
@@ -543,55 +1308,22 @@ auto gdwg::graph<N, E>::edges(N const& src, N const& dst) const -> std::vector<s
 	}
 	// return copy of the edges
 	auto result = std::vector<std::unique_ptr<edge>>();
-	auto it = edges_.find(src);
-	if (it != edges_.end()) {
-		for (const auto& e : it->second) {
-			if (e->get_nodes() == std::make_pair(src, dst)) {
-				if (auto we = dynamic_cast<weighted_edge<N, E>*>(e.get())) {
-					result.push_back(std::make_unique<weighted_edge<N, E>>(*we));
-				}
-				else if (auto ue = dynamic_cast<unweighted_edge<N, E>*>(e.get())) {
-					result.push_back(std::make_unique<unweighted_edge<N, E>>(*ue));
-				}
-			}
-		}
+	// the bucket is sorted, so edges come out unweighted first then by ascending weight
+	auto [first, last] = dst_range(*edges_[nodes_.find(src)->second], nodes_.find(dst)->second);
+	for (auto it = first; it != last; ++it) {
+		result.push_back(make_edge(src, dst, it->weight));
 	}
-	// first unweighted edge then weighted edge in acsedning order
-	std::sort(result.begin(), result.end(), [](const std::unique_ptr<edge>& a, const std::unique_ptr<edge>& b) {
-		auto a_nodes = a->get_nodes();
-		auto b_nodes = b->get_nodes();
-		if (a_nodes.first != b_nodes.first) {
-			return a_nodes.first < b_nodes.first;
-		}
-		if (a_nodes.second != b_nodes.second) {
-			return a_nodes.second < b_nodes.second;
-		}
-		auto weighted_a = dynamic_cast<weighted_edge<N, E>*>(a.get());
-		auto weighted_b = dynamic_cast<weighted_edge<N, E>*>(b.get());
-		if (!weighted_a) {
-			return true;
-		}
-		if (!weighted_b) {
-			return false;
-		}
-		return *weighted_a->get_weight() < *weighted_b->get_weight();
-	});
 	return result;
 }
 template<typename N, typename E>
 [[nodiscard]] auto gdwg::graph<N, E>::find(N const& src, N const& dst, std::optional<E> weight) const -> iterator {
-	auto it = edges_.find(src);
-	if (it != edges_.end()) {
-		auto edge_it = std::find_if(it->second.begin(), it->second.end(), [&](auto const& e) {
-			if (e->get_nodes() != std::make_pair(src, dst)) {
-				return false;
-			}
-			if (weight.has_value()) {
-				return e->get_weight() == weight;
-			}
-			return !e->get_weight().has_value();
-		});
-		if (edge_it != it->second.end()) {
+	auto it = nodes_.find(src);
+	auto dst_id = find_id(dst);
+	if (it != nodes_.end() and dst_id) {
+		auto const& edges = *edges_[it->second];
+		auto const record = edge_record{*dst_id, weight};
+		auto edge_it = record_position(edges, record);
+		if (edge_it != edges.end() and *edge_it == record) {
 			return iterator(this, it, edge_it);
 		}
 	}
@@ -602,30 +1334,30 @@ template<typename N, typename E>
 	if (!is_node(src)) {
 		throw std::runtime_error("Cannot call gdwg::graph<N, E>::connections if src doesn't exist in the graph");
 	}
-	auto it = edges_.find(src);
-	if (it == edges_.end()) {
-		return {};
-	}
-	auto connected_nodes = std::set<N>();
-	for (const auto& e : it->second) {
-		connected_nodes.insert(e->get_nodes().second);
+	// the bucket is ordered by destination, so each one is a single run
+	auto result = std::vector<N>();
+	auto const& edges = *edges_[nodes_.find(src)->second];
+	for (auto it = edges.begin(); it != edges.end(); ++it) {
+		if (it == edges.begin() or it->dst != std::prev(it)->dst) {
+			result.push_back(*values_[it->dst]);
+		}
 	}
-	return std::vector<N>(connected_nodes.begin(), connected_nodes.end());
+	return result;
 }
 template<typename N, typename E>
 auto gdwg::graph<N, E>::iterator::operator++() -> iterator& {
-	if (g == nullptr or map_it == g->edges_.end()) {
+	if (g == nullptr or map_it == g->nodes_.end()) {
 		return *this;
 	}
 	++vec_it;
-	while (map_it != g->edges_.end() && vec_it == map_it->second.end()) {
+	while (map_it != g->nodes_.end() && vec_it == g->edges_[map_it->second]->end()) {
 		++map_it;
-		if (map_it != g->edges_.end()) {
-			vec_it = map_it->second.begin();
+		if (map_it != g->nodes_.end()) {
+			vec_it = g->edges_[map_it->second]->begin();
 		}
 		else {
 			// We have reached the end of the map, set vec_it to a default value
-			vec_it = typename std::vector<std::unique_ptr<edge>>::const_iterator();
+			vec_it = typename bucket::const_iterator();
 			return *this;
 		}
 	}
@@ -642,17 +1374,18 @@ auto gdwg::graph<N, E>::iterator::operator--() -> iterator& {
 	if (g == nullptr) {
 		return *this;
 	}
-	if (map_it == g->edges_.end() and vec_it == typename std::vector<std::unique_ptr<edge>>::const_iterator()) {
+	if (map_it == g->nodes_.end() and vec_it == typename bucket::const_iterator()) {
 		--map_it;
-		vec_it = map_it->second.end();
+		vec_it = g->edges_[map_it->second]->end();
 	}
-	if (vec_it == map_it->second.begin()) {
-		if (map_it == g->edges_.begin()) {
+	// step back over nodes without out-edges
+	while (vec_it == g->edges_[map_it->second]->begin()) {
+		if (map_it == g->nodes_.begin()) {
 			*this = iterator(g);
 			return *this;
 		}
 		--map_it;
-		vec_it = map_it->second.end();
+		vec_it = g->edges_[map_it->second]->end();
 	}
 	--vec_it;
 	return *this;
@@ -677,77 +1410,133 @@ auto gdwg::graph<N, E>::end() const -> iterator {
 	return iterator(this, true);
 }
 template<typename N, typename E>
-struct gdwg::graph<N, E>::edge_hash {
-	size_t operator()(const std::tuple<N, N, std::optional<E>>& t) const {
-		size_t h1 = std::hash<N>{}(std::get<0>(t));
-		size_t h2 = std::hash<N>{}(std::get<1>(t));
-		size_t h3 = 0;
-		if (std::get<2>(t).has_value()) {
-			h3 = std::hash<E>{}(*(std::get<2>(t)));
+auto gdwg::graph<N, E>::operator==(graph const& other) const noexcept -> bool {
+	if (fingerprint_ and other.fingerprint_ and *fingerprint_ != *other.fingerprint_) {
+		return false;
+	}
+	if (nodes_.size() != other.nodes_.size()) {
+		return false;
+	}
+	// ids are private to each graph, so compare through the values. Both graphs keep their nodes and
+	// each bucket in value order, so equal graphs line up element by element
+	auto const same_record = [this, &other](edge_record const& a, edge_record const& b) {
+		return a.weight == b.weight and *values_[a.dst] == *other.values_[b.dst];
+	};
+	for (auto it = nodes_.begin(), o = other.nodes_.begin(); it != nodes_.end(); ++it, ++o) {
+		if (!(it->first == o->first)) {
+			return false;
+		}
+		auto const& edges = *edges_[it->second];
+		auto const& other_edges = *other.edges_[o->second];
+		if (!std::equal(edges.begin(), edges.end(), other_edges.begin(), other_edges.end(), same_record)) {
+			return false;
 		}
-		return h1 ^ (h2 << 1) ^ (h3 << 2);
 	}
-};
+	return true;
+}
 template<typename N, typename E>
-auto gdwg::graph<N, E>::operator==(graph const& other) const noexcept -> bool {
-	if (nodes_ != other.nodes_ or edges_.size() != other.edges_.size()) {
-		return false;
+auto gdwg::graph<N, E>::mix(std::uint64_t x) noexcept -> std::uint64_t {
+	// splitmix64 finalizer
+	x += std::uint64_t{0x9e3779b97f4a7c15};
+	x = (x ^ (x >> 30U)) * std::uint64_t{0xbf58476d1ce4e5b9};
+	x = (x ^ (x >> 27U)) * std::uint64_t{0x94d049bb133111eb};
+	return x ^ (x >> 31U);
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::node_term(N const& value) const noexcept -> std::uint64_t {
+	if constexpr (hashable) {
+		return mix(std::hash<N>{}(value));
 	}
-	// Create maps to store edges for each graph
-	std::unordered_map<N, std::unordered_map<std::tuple<N, N, std::optional<E>>, bool, edge_hash>> edges_map;
-	std::unordered_map<N, std::unordered_map<std::tuple<N, N, std::optional<E>>, bool, edge_hash>> other_edges_map;
-
-	// Populate the edges map for this graph
-	for (const auto& [node, edges] : edges_) {
-		for (const auto& edge : edges) {
-			edges_map[node][std::make_tuple(edge->get_nodes().first, edge->get_nodes().second, edge->get_weight())] =
-			    true;
+	return 0;
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::edge_term(node_id src, edge_record const& e) const noexcept -> std::uint64_t {
+	if constexpr (hashable) {
+		auto const weight = e.weight ? mix(std::hash<E>{}(*e.weight)) : std::uint64_t{0x5bd1e9955bd1e995};
+		// nested so that the term depends on which end is which
+		return mix(mix(mix(std::hash<N>{}(*values_[src])) + std::hash<N>{}(*values_[e.dst])) + weight);
+	}
+	return 0;
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::node_fingerprint(node_id id) const -> std::uint64_t {
+	auto sum = node_term(*values_[id]);
+	for (auto const& e : *edges_[id]) {
+		sum += edge_term(id, e);
+	}
+	// self loops were counted with the out-edges
+	if (track_in_) {
+		for (auto const& e : *in_[id]) {
+			if (e.dst != id) {
+				sum += edge_term(e.dst, edge_record{id, e.weight});
+			}
 		}
+		return sum;
 	}
-	// Populate the edges map for the other graph
-	for (const auto& [node, edges] : other.edges_) {
-		for (const auto& edge : edges) {
-			other_edges_map[node][std::make_tuple(edge->get_nodes().first, edge->get_nodes().second, edge->get_weight())] =
-			    true;
+	for (auto src = node_id{0}; src < edges_.size(); ++src) {
+		if (src != id) {
+			auto [first, last] = dst_range(*edges_[src], id);
+			for (auto it = first; it != last; ++it) {
+				sum += edge_term(src, *it);
+			}
 		}
 	}
-	// Compare the edges maps
-	return edges_map == other_edges_map;
+	return sum;
 }
 template<typename N, typename E>
-auto gdwg::graph<N, E>::erase_edge(iterator i) noexcept -> iterator {
+auto gdwg::graph<N, E>::track_fingerprint(bool enabled) -> void {
+	static_assert(hashable, "fingerprints need std::hash<N> and std::hash<E>");
+	if (enabled and !fingerprint_) {
+		auto sum = std::uint64_t{0};
+		for (auto const& [value, id] : nodes_) {
+			sum += node_term(value);
+			for (auto const& e : *edges_[id]) {
+				sum += edge_term(id, e);
+			}
+		}
+		fingerprint_ = sum;
+	}
+	else if (!enabled) {
+		fingerprint_.reset();
+	}
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::fingerprint() const noexcept -> std::optional<std::uint64_t> {
+	return fingerprint_;
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::erase_edge(iterator i) -> iterator {
 	if (i == end()) {
 		return end();
 	}
-	auto map_it = edges_.find(i.map_it->first);
-	if (map_it == edges_.end()) {
+	auto map_it = i.map_it;
+	auto const& current = *edges_[map_it->second];
+	if (current.empty()) {
 		return end();
 	}
-	auto vec_it = map_it->second.begin();
-	std::advance(vec_it, std::distance(i.map_it->second.cbegin(), i.vec_it));
-	vec_it = map_it->second.erase(vec_it);
-	if (map_it->second.empty()) {
-		map_it = edges_.erase(map_it);
-		if (map_it == edges_.end()) {
-			return end();
-		}
-		else {
-			vec_it = map_it->second.begin();
-		}
+	// an iterator left past its bucket's end by an earlier erase refers to the bucket's last edge
+	auto const pos = std::min(std::distance(current.cbegin(), i.vec_it), std::ssize(current) - 1);
+	// copying shared buckets may throw, so both are done before anything changes
+	auto& edges = unshare(edges_[map_it->second]);
+	if (track_in_) {
+		unlink_in(map_it->second, edges[static_cast<std::size_t>(pos)]);
 	}
-	else if (vec_it == map_it->second.end()) {
+	if (fingerprint_) {
+		*fingerprint_ -= edge_term(map_it->second, edges[static_cast<std::size_t>(pos)]);
+	}
+	typename bucket::const_iterator vec_it = edges.erase(edges.begin() + pos);
+	// move on to the next node that has out-edges
+	while (vec_it == edges_[map_it->second]->end()) {
 		++map_it;
-		if (map_it != edges_.end()) {
-			vec_it = map_it->second.begin();
-		}
-		else {
+		if (map_it == nodes_.end()) {
 			return end();
 		}
+		vec_it = edges_[map_it->second]->begin();
 	}
 	return iterator(this, map_it, vec_it);
 }
 template<typename N, typename E>
-auto gdwg::graph<N, E>::erase_edge(iterator i, iterator s) noexcept -> iterator {
+auto gdwg::graph<N, E>::erase_edge(iterator i, iterator s) -> iterator {
 	while (i != s and i != end()) {
 		i = erase_edge(i);
 	}
@@ -755,50 +1544,315 @@ auto gdwg::graph<N, E>::erase_edge(iterator i, iterator s) noexcept -> iterator
 }
 template<typename N, typename E>
 auto gdwg::graph<N, E>::clear() noexcept -> void {
-	nodes_.clear();
-	edges_.clear();
+	release();
+	if (fingerprint_) {
+		fingerprint_ = 0;
+	}
 }
 template<typename N, typename E>
-[[nodiscard]] auto gdwg::graph<N, E>::edges(N const& src) const -> std::vector<std::unique_ptr<edge>> {
-	if (!is_node(src)) {
-		throw std::runtime_error("Cannot call gdwg::graph<N, E>::edges if src node doesn't exist in the graph");
+auto gdwg::graph<N, E>::batch() -> transaction {
+	return transaction(*this);
+}
+template<typename N, typename E>
+gdwg::graph<N, E>::transaction::transaction(graph& g)
+: g_(&g) {}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::transaction::insert_node(N const& value) -> void {
+	ops_.push_back(operation{kind::insert_node, value, value, std::nullopt});
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::transaction::insert_edge(N const& src, N const& dst, std::optional<E> weight) -> void {
+	ops_.push_back(operation{kind::insert_edge, src, dst, std::move(weight)});
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::transaction::erase_edge(N const& src, N const& dst, std::optional<E> weight) -> void {
+	ops_.push_back(operation{kind::erase_edge, src, dst, std::move(weight)});
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::transaction::erase_node(N const& value) -> void {
+	ops_.push_back(operation{kind::erase_node, value, value, std::nullopt});
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::transaction::size() const noexcept -> std::size_t {
+	return ops_.size();
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::transaction::commit() -> void {
+	auto const ops = std::exchange(ops_, {});
+	// check every operation against the nodes it would see, before anything is applied
+	auto added = std::set<N>();
+	auto removed = std::set<N>();
+	auto const exists = [&](N const& value) {
+		return added.contains(value) or (!removed.contains(value) and g_->is_node(value));
+	};
+	// Within a segment nodes are inserted first, then edges are edited, then nodes are erased. That
+	// matches the call order unless a node is inserted again after being erased, which starts a new
+	// segment; an edge of an erased node can only be named again after that insert
+	auto segments = std::vector<std::size_t>{0};
+	auto erased = std::set<N>();
+	// erase_node of a node that doesn't exist at that point is a no-op, even if it's inserted later
+	auto erases = std::vector<bool>(ops.size());
+	for (auto i = std::size_t{0}; i < ops.size(); ++i) {
+		auto const& o = ops[i];
+		switch (o.op) {
+		case kind::insert_node:
+			if (!exists(o.src)) {
+				if (erased.contains(o.src)) {
+					segments.push_back(i);
+					erased.clear();
+				}
+				added.insert(o.src);
+				removed.erase(o.src);
+			}
+			break;
+		case kind::erase_node:
+			if (exists(o.src)) {
+				added.erase(o.src);
+				removed.insert(o.src);
+				erased.insert(o.src);
+				erases[i] = true;
+			}
+			break;
+		case kind::insert_edge:
+			if (!exists(o.src) or !exists(o.dst)) {
+				throw std::runtime_error("Cannot call gdwg::graph<N, E>::insert_edge when either src or dst node does "
+				                         "not exist");
+			}
+			break;
+		case kind::erase_edge:
+			if (!exists(o.src) or !exists(o.dst)) {
+				throw std::runtime_error("Cannot call gdwg::graph<N, E>::erase_edge on src or dst if they don't "
+				                         "exist in the graph");
+			}
+			break;
+		}
 	}
-	auto result = std::vector<std::unique_ptr<edge>>();
-	auto it = edges_.find(src);
-	if (it != edges_.end()) {
-		for (const auto& e : it->second) {
-			if (auto we = dynamic_cast<weighted_edge<N, E>*>(e.get())) {
-				result.push_back(std::make_unique<weighted_edge<N, E>>(*we));
+	segments.push_back(ops.size());
+
+	// the operations are applied to a copy, which shares every bucket until it writes to one. The copy
+	// only replaces the graph once all of them went through
+	auto g = graph(*g_, g_->get_allocator());
+	for (auto s = std::size_t{0}; s + 1 < segments.size(); ++s) {
+		auto const first = ops.begin() + static_cast<std::ptrdiff_t>(segments[s]);
+		auto const last = ops.begin() + static_cast<std::ptrdiff_t>(segments[s + 1]);
+		for (auto it = first; it != last; ++it) {
+			if (it->op == kind::insert_node) {
+				g.insert_node(it->src);
 			}
-			else if (auto ue = dynamic_cast<unweighted_edge<N, E>*>(e.get())) {
-				result.push_back(std::make_unique<unweighted_edge<N, E>>(*ue));
+		}
+		// (src, record, insert) in call order; a stable sort keeps the calls on one record in order
+		// so only the last of them decides whether it ends up in the bucket
+		auto edits = std::vector<std::tuple<node_id, edge_record, bool>>();
+		for (auto it = first; it != last; ++it) {
+			if (it->op == kind::insert_edge or it->op == kind::erase_edge) {
+				edits.emplace_back(*g.find_id(it->src),
+				                   edge_record{*g.find_id(it->dst), it->weight},
+				                   it->op == kind::insert_edge);
+			}
+		}
+		std::stable_sort(edits.begin(), edits.end(), [&g](auto const& a, auto const& b) {
+			return std::get<0>(a) != std::get<0>(b) ? std::get<0>(a) < std::get<0>(b)
+			                                        : g.record_less(std::get<1>(a), std::get<1>(b));
+		});
+		auto changes = std::vector<std::pair<edge_record, bool>>();
+		for (auto it = edits.begin(); it != edits.end();) {
+			auto const src = std::get<0>(*it);
+			changes.clear();
+			for (; it != edits.end() and std::get<0>(*it) == src; ++it) {
+				if (!changes.empty() and changes.back().first == std::get<1>(*it)) {
+					changes.back().second = std::get<2>(*it);
+				}
+				else {
+					changes.emplace_back(std::get<1>(*it), std::get<2>(*it));
+				}
+			}
+			g.edit_bucket(src, changes);
+		}
+		auto ids = std::vector<node_id>();
+		for (auto i = segments[s]; i < segments[s + 1]; ++i) {
+			if (erases[i]) {
+				ids.push_back(*g.find_id(ops[i].src));
 			}
 		}
+		g.erase_ids(ids);
 	}
-	return result;
+	*g_ = std::move(g);
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::edit_bucket(node_id src, std::vector<std::pair<edge_record, bool>> const& changes) -> void {
+	auto const& stored = *edges_[src];
+	auto merged = bucket(stored.get_allocator());
+	merged.reserve(stored.size() + changes.size());
+	auto changed = false;
+	auto s = stored.begin();
+	for (auto const& [record, insert] : changes) {
+		while (s != stored.end() and record_less(*s, record)) {
+			merged.push_back(*s++);
+		}
+		auto const present = s != stored.end() and *s == record;
+		if (present) {
+			++s;
+		}
+		if (present == insert) {
+			if (insert) {
+				merged.push_back(record);
+			}
+			continue;
+		}
+		changed = true;
+		if (insert) {
+			merged.push_back(record);
+			if (track_in_) {
+				link_in(src, record);
+			}
+			if (fingerprint_) {
+				*fingerprint_ += edge_term(src, record);
+			}
+		}
+		else {
+			if (track_in_) {
+				unlink_in(src, record);
+			}
+			if (fingerprint_) {
+				*fingerprint_ -= edge_term(src, record);
+			}
+		}
+	}
+	if (!changed) {
+		return;
+	}
+	std::copy(s, stored.end(), std::back_inserter(merged));
+	// the old bucket is replaced outright, so a shared one isn't cloned first
+	reset_bucket(edges_[src]);
+	*edges_[src] = std::move(merged);
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::erase_ids(std::vector<node_id> const& ids) -> void {
+	// with the in-edge index each erase already touches only its neighbours
+	if (track_in_ or ids.size() == 1) {
+		for (auto const id : ids) {
+			auto const value = *values_[id];
+			erase_node(value);
+		}
+		return;
+	}
+	auto erased = std::vector<bool>(values_.size());
+	for (auto const id : ids) {
+		erased[id] = true;
+		if (fingerprint_) {
+			*fingerprint_ -= node_term(*values_[id]);
+			for (auto const& e : *edges_[id]) {
+				*fingerprint_ -= edge_term(id, e);
+			}
+		}
+		reset_bucket(edges_[id]);
+	}
+	auto const points_at_erased = [&erased](auto const& e) { return erased[e.dst]; };
+	for (auto src = std::size_t{0}; src < edges_.size(); ++src) {
+		if (std::any_of(edges_[src]->begin(), edges_[src]->end(), points_at_erased)) {
+			auto& edges = unshare(edges_[src]);
+			if (fingerprint_) {
+				for (auto const& e : edges) {
+					if (erased[e.dst]) {
+						*fingerprint_ -= edge_term(static_cast<node_id>(src), e);
+					}
+				}
+			}
+			edges.erase(std::remove_if(edges.begin(), edges.end(), points_at_erased), edges.end());
+		}
+	}
+	for (auto const id : ids) {
+		nodes_.erase(nodes_.find(*values_[id]));
+		values_[id] = nullptr;
+		free_ids_.push_back(id);
+	}
+}
+template<typename N, typename E>
+gdwg::graph<N, E>::edge_view::iterator::iterator(N const* from, N const* const* values, edge_record const* record)
+: from(from)
+, values(values)
+, record(record) {}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::edge_view::iterator::operator*() const -> reference {
+	return reference{*from, *values[record->dst], record->weight};
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::edge_view::iterator::operator++() -> iterator& {
+	++record;
+	return *this;
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::edge_view::iterator::operator++(int) -> iterator {
+	auto temp = *this;
+	++record;
+	return temp;
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::edge_view::iterator::operator--() -> iterator& {
+	--record;
+	return *this;
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::edge_view::iterator::operator--(int) -> iterator {
+	auto temp = *this;
+	--record;
+	return temp;
+}
+template<typename N, typename E>
+gdwg::graph<N, E>::edge_view::edge_view(N const* from,
+                                        N const* const* values,
+                                        edge_record const* first,
+                                        edge_record const* last)
+: from_(from)
+, values_(values)
+, first_(first)
+, last_(last) {}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::edge_view::begin() const -> iterator {
+	return iterator(from_, values_, first_);
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::edge_view::end() const -> iterator {
+	return iterator(from_, values_, last_);
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::edge_view::size() const noexcept -> std::size_t {
+	return static_cast<std::size_t>(last_ - first_);
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::edge_view::empty() const noexcept -> bool {
+	return first_ == last_;
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::out_edges(N const& src) const -> edge_view {
+	auto it = nodes_.find(src);
+	if (it == nodes_.end()) {
+		throw std::runtime_error("Cannot call gdwg::graph<N, E>::out_edges if src doesn't exist in the graph");
+	}
+	auto const& edges = *edges_[it->second];
+	return edge_view(&it->first, values_.data(), edges.data(), edges.data() + edges.size());
+}
+template<typename N, typename E>
+auto gdwg::graph<N, E>::edges_between(N const& src, N const& dst) const -> edge_view {
+	auto it = nodes_.find(src);
+	auto dst_id = find_id(dst);
+	if (it == nodes_.end() or !dst_id) {
+		throw std::runtime_error("Cannot call gdwg::graph<N, E>::edges_between if src or dst node don't exist in the "
+		                         "graph");
+	}
+	auto [first, last] = dst_range(*edges_[it->second], *dst_id);
+	return edge_view(&it->first, values_.data(), std::to_address(first), std::to_address(last));
 }
 namespace gdwg {
 	template<typename N, typename E>
 	auto operator<<(std::ostream& os, gdwg::graph<N, E> const& g) -> std::ostream& {
-		for (const auto& node : g.nodes()) {
+		for (const auto& [node, id] : g.nodes_) {
 			os << node << " (\n";
-			auto edges = g.edges(node);
-			std::sort(edges.begin(), edges.end(), [](const auto& a, const auto& b) {
-				if (a->get_nodes().second != b->get_nodes().second) {
-					return a->get_nodes().second < b->get_nodes().second;
-				}
-				if (!a->is_weighted() && b->is_weighted()) {
-					return true;
-				}
-				if (a->is_weighted() && !b->is_weighted()) {
-					return false;
-				}
-				return a->get_weight() < b->get_weight();
-			});
-			for (const auto& edge : edges) {
-				os << "  " << edge->get_nodes().first << " -> " << edge->get_nodes().second;
-				if (edge->is_weighted()) {
-					os << " | W | " << *edge->get_weight();
+			// buckets are stored in output order, print them straight from the view
+			for (const auto& [from, to, weight] : g.out_edges(node)) {
+				os << "  " << from << " -> " << to;
+				if (weight) {
+					os << " | W | " << *weight;
 				}
 				else {
 					os << " | U";
@@ -810,4 +1864,56 @@ namespace gdwg {
 		return os;
 	}
 } // namespace gdwg
+inline auto gdwg::set_parallel_options(parallel_options const& options) noexcept -> void {
+	detail::parallel_threads.store(options.threads, std::memory_order_relaxed);
+	detail::parallel_threshold.store(options.threshold, std::memory_order_relaxed);
+}
+inline auto gdwg::get_parallel_options() noexcept -> parallel_options {
+	return parallel_options{detail::parallel_threads.load(std::memory_order_relaxed),
+	                        detail::parallel_threshold.load(std::memory_order_relaxed)};
+}
+inline auto gdwg::detail::worker_count(std::size_t requested) noexcept -> std::size_t {
+	if (requested != 0) {
+		return requested;
+	}
+	return std::max(std::size_t{1}, std::size_t{std::thread::hardware_concurrency()});
+}
+template<typename F>
+auto gdwg::detail::run_parallel(std::size_t count, F const& task) -> void {
+	auto errors = std::vector<std::exception_ptr>(count);
+	auto const guarded = [&task, &errors](std::size_t i) {
+		try {
+			task(i);
+		} catch (...) {
+			errors[i] = std::current_exception();
+		}
+	};
+	auto threads = std::vector<std::thread>();
+	threads.reserve(count);
+	try {
+		for (auto i = std::size_t{1}; i < count; ++i) {
+			threads.emplace_back(guarded, i);
+		}
+	} catch (...) {
+		for (auto& thread : threads) {
+			thread.join();
+		}
+		throw;
+	}
+	if (count != 0) {
+		guarded(0);
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	for (auto const& error : errors) {
+		if (error) {
+			std::rethrow_exception(error);
+		}
+	}
+}
+inline auto gdwg::detail::thread_safe(std::pmr::memory_resource* resource) noexcept -> bool {
+	return resource == std::pmr::new_delete_resource()
+	       or dynamic_cast<std::pmr::synchronized_pool_resource*>(resource) != nullptr;
+}
 #endif // GDWG_GRAPH_H
@@ -2,6 +2,8 @@
 
 #include <catch2/catch.hpp>
 
+#include <thread>
+
 TEST_CASE("basic test") {
 	auto g = gdwg::graph<int, std::string>{};
 	auto n = 5;
@@ -1500,4 +1502,666 @@ TEST_CASE("Graph output: formatted output") {
 )
 )");
 	CHECK(out.str() == expected_output);
-}
\ No newline at end of file
+}
+TEST_CASE("insert_edges: bulk load reports new edges and keeps order") {
+	auto g = gdwg::graph<int, int>{1, 2, 3};
+	g.insert_edge(1, 3, 7);
+	auto const v = std::vector<std::tuple<int, int, std::optional<int>>>{
+	    {1, 3, 7},
+	    {2, 1, std::nullopt},
+	    {1, 3, std::nullopt},
+	    {1, 2, 4},
+	    {2, 1, std::nullopt},
+	    {1, 2, 1},
+	};
+	CHECK(g.insert_edges(v.begin(), v.end()) == 4);
+	auto out = std::ostringstream{};
+	out << g;
+	auto const expected_output = std::string_view(R"(1 (
+  1 -> 2 | W | 1
+  1 -> 2 | W | 4
+  1 -> 3 | U
+  1 -> 3 | W | 7
+)
+2 (
+  2 -> 1 | U
+)
+3 (
+)
+)");
+	CHECK(out.str() == expected_output);
+	CHECK(g.insert_edge(1, 2, 4) == false);
+	CHECK(g.insert_edges(v.begin(), v.end()) == 0);
+}
+TEST_CASE("insert_edges: missing node throws and leaves the graph untouched") {
+	auto g = gdwg::graph<std::string, int>{"A", "B"};
+	auto const v = std::vector<std::tuple<std::string, std::string, std::optional<int>>>{
+	    {"A", "B", 1},
+	    {"A", "C", 2},
+	};
+	CHECK_THROWS_WITH(g.insert_edges(v.begin(), v.end()),
+	                  "Cannot call gdwg::graph<N, E>::insert_edge when either src or dst node does not exist");
+	CHECK(g.begin() == g.end());
+}
+TEST_CASE("insert_edges: accepts the graph's own iterator range") {
+	auto g1 = gdwg::graph<int, int>{1, 2, 3};
+	g1.insert_edge(1, 2, 5);
+	g1.insert_edge(2, 3);
+	g1.insert_edge(3, 1, 2);
+	auto g2 = gdwg::graph<int, int>{1, 2, 3};
+	CHECK(g2.insert_edges(g1.begin(), g1.end()) == 3);
+	CHECK(g1 == g2);
+}
+TEST_CASE("id_of and node_at: interned ids are dense and reused after erase") {
+	auto g = gdwg::graph<std::string, int>{"A", "B", "C"};
+	CHECK(g.id_bound() == 3);
+	for (auto const& n : g.nodes()) {
+		CHECK(g.node_at(g.id_of(n)) == n);
+		CHECK(g.id_of(n) < g.id_bound());
+	}
+	auto const b = g.id_of("B");
+	g.erase_node("B");
+	CHECK_THROWS_WITH(g.id_of("B"), "Cannot call gdwg::graph<N, E>::id_of on a node that doesn't exist");
+	CHECK_THROWS_WITH(g.node_at(b), "Cannot call gdwg::graph<N, E>::node_at on an id that doesn't name a node");
+	g.insert_node("D");
+	CHECK(g.id_of("D") == b);
+	CHECK(g.id_bound() == 3);
+}
+TEST_CASE("replace_node: edges follow the node and stay ordered by value") {
+	auto g = gdwg::graph<std::string, int>{"A", "B", "C"};
+	g.insert_edge("A", "B", 1);
+	g.insert_edge("A", "C", 2);
+	g.insert_edge("B", "A");
+	auto const id = g.id_of("B");
+	CHECK(g.replace_node("B", "Z"));
+	CHECK(g.id_of("Z") == id);
+	CHECK(g.is_connected("A", "Z"));
+	CHECK(g.is_connected("Z", "A"));
+	auto out = std::ostringstream{};
+	out << g;
+	CHECK(out.str() == "A (\n  A -> C | W | 2\n  A -> Z | W | 1\n)\nC (\n)\nZ (\n  Z -> A | U\n)\n");
+}
+TEST_CASE("in_edges, in_degree and predecessors with and without the incoming index") {
+	auto g = gdwg::graph<std::string, int>{"A", "B", "C", "D"};
+	g.insert_edge("C", "B", 2);
+	g.insert_edge("A", "B", 5);
+	g.insert_edge("A", "B");
+	g.insert_edge("B", "B", 1);
+	g.insert_edge("A", "C", 3);
+	for (auto tracked : {false, true}) {
+		g.track_in_edges(tracked);
+		CHECK(g.tracks_in_edges() == tracked);
+		auto in = g.in_edges("B");
+		REQUIRE(in.size() == 4);
+		CHECK(in[0]->print_edge() == "A -> B | U");
+		CHECK(in[1]->print_edge() == "A -> B | W | 5");
+		CHECK(in[2]->print_edge() == "B -> B | W | 1");
+		CHECK(in[3]->print_edge() == "C -> B | W | 2");
+		CHECK(g.in_degree("B") == 4);
+		CHECK(g.in_degree("D") == 0);
+		CHECK(g.predecessors("B") == std::vector<std::string>{"A", "B", "C"});
+		CHECK(g.predecessors("A").empty());
+		CHECK_THROWS_WITH(g.in_edges("E"), "Cannot call gdwg::graph<N, E>::in_edges if dst doesn't exist in the graph");
+	}
+}
+TEST_CASE("incoming index stays consistent through mutations") {
+	auto g = gdwg::graph<int, int>{1, 2, 3, 4};
+	g.track_in_edges(true);
+	g.insert_edge(1, 2, 1);
+	g.insert_edge(3, 2);
+	g.insert_edge(2, 2, 4);
+	auto const v = std::vector<std::tuple<int, int, std::optional<int>>>{{4, 2, 7}, {1, 3, std::nullopt}};
+	g.insert_edges(v.begin(), v.end());
+	CHECK(g.in_degree(2) == 4);
+	CHECK(g.erase_edge(3, 2));
+	CHECK(g.in_degree(2) == 3);
+	g.erase_edge(g.find(4, 2, 7));
+	CHECK(g.predecessors(2) == std::vector<int>{1, 2});
+
+	auto copy = g;
+	CHECK(copy.tracks_in_edges());
+	CHECK(g.erase_node(2));
+	CHECK(g.in_degree(3) == 1);
+	CHECK(g.begin() != g.end());
+	CHECK((*g.begin()).to == 3);
+	CHECK(copy.in_degree(2) == 2);
+
+	copy.merge_replace_node(2, 3);
+	CHECK(copy.predecessors(3) == std::vector<int>{1, 3});
+	CHECK(copy.in_degree(3) == 3);
+	copy.replace_node(1, 9);
+	CHECK(copy.predecessors(3) == std::vector<int>{3, 9});
+	copy.clear();
+	copy.insert_node(5);
+	CHECK(copy.in_degree(5) == 0);
+}
+TEST_CASE("merge_replace_node: incoming, outgoing and duplicate edges with the incoming index") {
+	for (auto tracked : {false, true}) {
+		auto g = gdwg::graph<std::string, int>{"A", "B", "C", "D"};
+		g.track_in_edges(tracked);
+		g.insert_edge("A", "B", 1);
+		g.insert_edge("A", "C", 1);
+		g.insert_edge("B", "B");
+		g.insert_edge("B", "D", 2);
+		g.insert_edge("C", "D", 2);
+		g.insert_edge("D", "B", 3);
+		g.merge_replace_node("B", "C");
+		auto out = std::ostringstream{};
+		out << g;
+		auto const expected_output = std::string_view(R"(A (
+  A -> C | W | 1
+)
+C (
+  C -> C | U
+  C -> D | W | 2
+)
+D (
+  D -> C | W | 3
+)
+)");
+		CHECK(out.str() == expected_output);
+		if (tracked) {
+			CHECK(g.predecessors("C") == std::vector<std::string>{"A", "C", "D"});
+			CHECK(g.in_degree("D") == 1);
+		}
+		g.merge_replace_node("C", "C");
+		CHECK(g.is_node("C"));
+	}
+}
+TEST_CASE("merge_replace_nodes: applies chained merges in one pass") {
+	auto g = gdwg::graph<int, int>{1, 2, 3, 4, 5};
+	g.insert_edge(1, 2, 1);
+	g.insert_edge(2, 3, 1);
+	g.insert_edge(3, 4, 1);
+	g.insert_edge(5, 1);
+	auto expected = g;
+	expected.merge_replace_node(1, 2);
+	expected.merge_replace_node(2, 4);
+	expected.merge_replace_node(5, 3);
+	g.merge_replace_nodes({{1, 2}, {2, 4}, {5, 3}});
+	CHECK(g == expected);
+	CHECK(g.nodes() == std::vector<int>{3, 4});
+	CHECK(g.find(3, 4, 1) != g.end());
+	CHECK(g.find(4, 4, 1) != g.end());
+	CHECK(g.find(3, 4) != g.end());
+}
+TEST_CASE("merge_replace_nodes: an invalid pair throws before any merge is applied") {
+	auto g = gdwg::graph<int, int>{1, 2, 3};
+	g.insert_edge(1, 2, 1);
+	auto const before = g;
+	CHECK_THROWS_WITH(g.merge_replace_nodes({{1, 2}, {1, 3}}),
+	                  "Cannot call gdwg::graph<N, E>::merge_replace_nodes on old or new data if they don't exist in "
+	                  "the graph");
+	CHECK_THROWS_AS(g.merge_replace_nodes({{2, 9}}), std::runtime_error);
+	CHECK(g == before);
+}
+TEST_CASE("out_edges and edges_between borrow the stored edges in order") {
+	auto g = gdwg::graph<std::string, int>{"A", "B", "C"};
+	g.insert_edge("A", "C", 4);
+	g.insert_edge("A", "B", 2);
+	g.insert_edge("A", "B");
+	g.insert_edge("A", "B", 1);
+	auto out = g.out_edges("A");
+	REQUIRE(out.size() == 4);
+	auto it = out.begin();
+	CHECK((*it).to == "B");
+	CHECK(!(*it).weight);
+	++it;
+	CHECK((*it).weight == 1);
+	auto last = out.end();
+	--last;
+	CHECK((*last).to == "C");
+	CHECK((*last).weight == 4);
+	CHECK(&(*it).from == &(*last).from);
+
+	auto between = g.edges_between("A", "B");
+	auto weights = std::vector<std::optional<int>>();
+	for (auto const& [from, to, weight] : between) {
+		CHECK(from == "A");
+		CHECK(to == "B");
+		weights.push_back(weight);
+	}
+	CHECK(weights == std::vector<std::optional<int>>{std::nullopt, 1, 2});
+	CHECK(g.edges_between("B", "A").empty());
+	CHECK(g.out_edges("C").empty());
+	CHECK_THROWS_WITH(g.out_edges("D"), "Cannot call gdwg::graph<N, E>::out_edges if src doesn't exist in the graph");
+	CHECK_THROWS_WITH(g.edges_between("A", "D"),
+	                  "Cannot call gdwg::graph<N, E>::edges_between if src or dst node don't exist in the graph");
+}
+TEST_CASE("insert_edge keeps a high-degree bucket sorted for binary search") {
+	auto g = gdwg::graph<int, int>{};
+	for (auto i = 0; i < 200; ++i) {
+		g.insert_node(i);
+	}
+	for (auto i = 199; i >= 0; --i) {
+		CHECK(g.insert_edge(0, i, i % 7));
+		CHECK(g.insert_edge(0, i));
+	}
+	CHECK_FALSE(g.insert_edge(0, 42, 0));
+	CHECK(g.connections(0).size() == 200);
+	auto previous = std::optional<std::pair<int, std::optional<int>>>();
+	for (auto const& [from, to, weight] : g) {
+		auto const current = std::make_pair(to, weight);
+		if (previous) {
+			CHECK(*previous < current);
+		}
+		previous = current;
+	}
+	CHECK(g.is_connected(0, 150));
+	CHECK_FALSE(g.is_connected(150, 0));
+	CHECK(g.find(0, 150, 150 % 7) != g.end());
+	CHECK(g.find(0, 150, 99) == g.end());
+	CHECK(g.edges(0, 150).size() == 2);
+	CHECK(g.erase_edge(0, 150));
+	CHECK(g.edges(0, 150).size() == 1);
+}
+namespace {
+	// forwards to new/delete and counts what is still allocated through it, allocations past the
+	// limit throw
+	class counting_resource : public std::pmr::memory_resource {
+	 public:
+		std::size_t allocations = 0;
+		std::size_t live = 0;
+		std::size_t limit = std::numeric_limits<std::size_t>::max();
+
+	 private:
+		auto do_allocate(std::size_t bytes, std::size_t alignment) -> void* override {
+			if (allocations == limit) {
+				throw std::bad_alloc();
+			}
+			++allocations;
+			++live;
+			return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+		}
+		auto do_deallocate(void* p, std::size_t bytes, std::size_t alignment) -> void override {
+			--live;
+			std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+		}
+		auto do_is_equal(std::pmr::memory_resource const& other) const noexcept -> bool override {
+			return this == &other;
+		}
+	};
+} // namespace
+TEST_CASE("graph allocates its nodes, edges and indices from the given resource") {
+	auto resource = counting_resource();
+	auto fallback = counting_resource();
+	auto* const previous = std::pmr::set_default_resource(&fallback);
+	{
+		auto g = gdwg::graph<int, int>({1, 2, 3, 4}, &resource);
+		g.track_in_edges(true);
+		auto const edges = std::vector<std::tuple<int, int, int>>{{1, 2, 5}, {1, 3, 1}, {2, 4, 2}, {4, 1, 7}};
+		g.insert_edges(edges.begin(), edges.end());
+		g.insert_edge(3, 4);
+		g.merge_replace_node(2, 3);
+		g.erase_node(4);
+		CHECK(g.get_allocator().resource() == &resource);
+		CHECK(resource.allocations > 0);
+		CHECK(fallback.allocations == 0);
+		CHECK(g.in_degree(3) == 2);
+	}
+	CHECK(resource.live == 0);
+	std::pmr::set_default_resource(previous);
+}
+TEST_CASE("graph copies into a different resource") {
+	auto source = counting_resource();
+	auto target = counting_resource();
+	auto g = gdwg::graph<std::string, int>({"a", "b", "c"}, &source);
+	g.track_in_edges(true);
+	g.insert_edge("a", "b", 1);
+	g.insert_edge("b", "c");
+	auto const before = source.allocations;
+
+	auto copy = gdwg::graph<std::string, int>(g, &target);
+	CHECK(copy == g);
+	CHECK(copy.get_allocator().resource() == &target);
+	CHECK(copy.in_degree("c") == 1);
+	CHECK(source.allocations == before);
+	CHECK(target.allocations > 0);
+
+	// move assignment takes the source's storage and resource instead of copying into the target's
+	auto moved = gdwg::graph<std::string, int>({"d"}, &target);
+	auto const stolen = source.allocations;
+	moved = std::move(g);
+	CHECK(source.allocations == stolen);
+	CHECK(moved.get_allocator().resource() == &source);
+	CHECK(g.empty());
+	CHECK(moved == copy);
+	CHECK(moved.find("a", "b", 1) != moved.end());
+	CHECK(gdwg::graph<std::string, int>(moved).get_allocator() == std::pmr::polymorphic_allocator<std::byte>());
+	CHECK(std::is_nothrow_move_assignable_v<gdwg::graph<std::string, int>>);
+}
+TEST_CASE("a copy assignment that runs out of memory leaves the target as it was") {
+	auto resource = counting_resource();
+	auto target = gdwg::graph<std::string, int>({"x", "y"}, &resource);
+	target.insert_edge("x", "y", 1);
+	auto const before = gdwg::graph<std::string, int>(target);
+	auto source = gdwg::graph<std::string, int>{"a", "b", "c"};
+	source.track_in_edges(true);
+	source.insert_edge("a", "b", 2);
+	source.insert_edge("b", "c");
+	for (auto budget = std::size_t{0};; ++budget) {
+		resource.limit = resource.allocations + budget;
+		try {
+			target = source;
+		} catch (std::bad_alloc const&) {
+			CHECK(target == before);
+			CHECK(target.in_degree("y") == 1);
+			continue;
+		}
+		resource.limit = std::numeric_limits<std::size_t>::max();
+		CHECK(budget > 0);
+		CHECK(target == source);
+		CHECK(target.get_allocator().resource() == &resource);
+		CHECK(target.insert_edge("c", "a", 3));
+		break;
+	}
+}
+TEST_CASE("copies share buckets until one side writes") {
+	auto g = gdwg::graph<int, int>{1, 2, 3, 4};
+	g.track_in_edges(true);
+	g.insert_edge(1, 2, 1);
+	g.insert_edge(1, 3, 2);
+	g.insert_edge(2, 3, 3);
+	g.insert_edge(3, 1);
+	auto const snapshot = g;
+
+	auto copy = g;
+	copy.insert_edge(1, 4, 5);
+	copy.erase_edge(2, 3, 3);
+	copy.replace_node(3, 5);
+	CHECK(g == snapshot);
+	CHECK(g.in_degree(3) == 2);
+	CHECK(copy.in_degree(5) == 1);
+	CHECK(copy.in_degree(4) == 1);
+
+	g.merge_replace_node(2, 1);
+	g.erase_node(4);
+	CHECK(copy.is_node(4));
+	CHECK(copy.edges(1, 2).size() == 1);
+	CHECK(copy.is_connected(1, 4));
+	CHECK(snapshot.find(2, 3, 3) != snapshot.end());
+
+	auto it = copy.find(1, 2, 1);
+	auto erased = gdwg::graph<int, int>(copy);
+	auto const next = erased.erase_edge(erased.find(1, 2, 1));
+	CHECK(next == erased.find(1, 4, 5));
+	CHECK(copy.find(1, 2, 1) == it);
+	CHECK_FALSE(erased.is_connected(1, 2));
+	// erasing may clone a shared bucket, which can throw
+	CHECK_FALSE(noexcept(erased.erase_edge(erased.begin())));
+}
+TEST_CASE("copies are read and destroyed on another thread while the original writes") {
+	auto g = gdwg::graph<int, int>{1, 2, 3};
+	g.track_in_edges(true);
+	g.insert_edge(1, 2, 1);
+	g.insert_edge(2, 3, 2);
+	for (auto round = 0; round < 50; ++round) {
+		auto copy = std::make_unique<gdwg::graph<int, int>>(g);
+		auto degree = std::size_t{0};
+		auto reader = std::thread([&copy, &degree] {
+			degree = copy->in_degree(2);
+			copy.reset();
+		});
+		g.insert_edge(1, 2, round + 10);
+		g.erase_edge(g.find(1, 2, round + 10));
+		reader.join();
+		CHECK(degree == 1);
+	}
+	CHECK(g.in_degree(2) == 1);
+}
+TEST_CASE("copying a graph costs allocations per node, not per edge") {
+	auto resource = counting_resource();
+	auto g = gdwg::graph<int, int>(&resource);
+	auto constexpr nodes = 50;
+	for (auto i = 0; i < nodes; ++i) {
+		g.insert_node(i);
+	}
+	for (auto i = 0; i < nodes; ++i) {
+		for (auto j = 0; j < nodes; ++j) {
+			g.insert_edge(i, j, i * j);
+		}
+	}
+	auto const before = resource.allocations;
+	auto copy = gdwg::graph<int, int>(g, &resource);
+	// one map node per node plus the id tables
+	CHECK(resource.allocations - before <= nodes + 4);
+
+	// a write clones only the bucket it touches, which then grows once
+	auto const shared = resource.allocations;
+	copy.insert_edge(0, 1);
+	CHECK(resource.allocations - shared <= 3);
+	CHECK_FALSE(g.find(0, 1) != g.end());
+}
+TEST_CASE("copy, assignment, clear and destruction split large graphs across threads") {
+	auto const previous = gdwg::get_parallel_options();
+	gdwg::set_parallel_options({.threads = 4, .threshold = 1});
+	CHECK(gdwg::get_parallel_options().threads == 4);
+
+	auto g = gdwg::graph<std::string, int>();
+	g.track_in_edges(true);
+	g.track_fingerprint(true);
+	for (auto i = 0; i < 200; ++i) {
+		g.insert_node(std::to_string(i));
+	}
+	for (auto i = 0; i < 200; ++i) {
+		g.insert_edge(std::to_string(i), std::to_string((i * 7) % 200), i);
+		g.insert_edge(std::to_string(i), std::to_string((i * 3) % 200));
+	}
+	g.erase_node("5");
+
+	auto copy = g;
+	CHECK(copy == g);
+	CHECK(copy.fingerprint() == g.fingerprint());
+	CHECK(copy.in_degree("21") == g.in_degree("21"));
+	auto assigned = gdwg::graph<std::string, int>{"x"};
+	assigned = g;
+	CHECK(assigned == g);
+	CHECK(assigned.insert_node("5"));
+
+	// a resource that isn't thread safe is still copied into, one bucket at a time
+	auto synchronized = std::pmr::synchronized_pool_resource();
+	auto unsynchronized = std::pmr::unsynchronized_pool_resource();
+	for (auto* resource : std::initializer_list<std::pmr::memory_resource*>{&synchronized, &unsynchronized}) {
+		auto deep = gdwg::graph<std::string, int>(g, resource);
+		CHECK(deep == g);
+		deep.insert_edge("0", "1", -1);
+		CHECK_FALSE(g.is_connected("0", "1"));
+		auto reassigned = gdwg::graph<std::string, int>(resource);
+		reassigned = deep;
+		CHECK(reassigned == deep);
+	}
+
+	copy.clear();
+	CHECK(copy.empty());
+	CHECK(copy.fingerprint() == 0);
+	CHECK(g.is_node("0"));
+	CHECK(g.in_degree("0") == 2);
+	gdwg::set_parallel_options(previous);
+}
+TEST_CASE("operator== compares graphs built in different orders") {
+	auto a = gdwg::graph<std::string, int>{"a", "b", "c"};
+	auto b = gdwg::graph<std::string, int>{"c", "b", "a"};
+	a.insert_edge("a", "b", 1);
+	a.insert_edge("a", "b");
+	a.insert_edge("c", "a", 2);
+	b.insert_edge("c", "a", 2);
+	b.insert_edge("a", "b");
+	b.insert_edge("a", "b", 1);
+	CHECK(a == b);
+	b.erase_edge("a", "b");
+	b.insert_edge("a", "c");
+	CHECK_FALSE(a == b);
+	b.erase_node("b");
+	CHECK_FALSE(a == b);
+}
+TEST_CASE("the fingerprint follows every mutation") {
+	auto const fresh = [](gdwg::graph<int, int> g) {
+		g.track_fingerprint(false);
+		g.track_fingerprint(true);
+		return g.fingerprint();
+	};
+	for (auto indexed : {false, true}) {
+		auto g = gdwg::graph<int, int>{1, 2, 3, 4, 5};
+		CHECK_FALSE(g.fingerprint());
+		g.track_in_edges(indexed);
+		g.track_fingerprint(true);
+		CHECK(g.fingerprint() == fresh(g));
+		auto const empty = g.fingerprint();
+
+		g.insert_edge(1, 2, 3);
+		g.insert_edge(1, 1);
+		g.insert_edge(2, 3, 1);
+		g.insert_edge(4, 2, 7);
+		g.insert_edge(3, 4);
+		auto const edges = std::vector<std::tuple<int, int, int>>{{5, 1, 2}, {2, 3, 1}, {3, 5, 9}};
+		g.insert_edges(edges.begin(), edges.end());
+		CHECK(g.fingerprint() == fresh(g));
+		CHECK(g.fingerprint() != empty);
+
+		g.replace_node(2, 6);
+		CHECK(g.fingerprint() == fresh(g));
+		g.merge_replace_node(6, 3);
+		CHECK(g.fingerprint() == fresh(g));
+		g.erase_edge(g.find(3, 4));
+		g.erase_edge(1, 1);
+		CHECK(g.fingerprint() == fresh(g));
+		g.erase_node(5);
+		CHECK(g.fingerprint() == fresh(g));
+
+		auto copy = g;
+		CHECK(copy.fingerprint() == g.fingerprint());
+		copy.insert_edge(4, 4, 4);
+		CHECK(copy.fingerprint() != g.fingerprint());
+		CHECK_FALSE(copy == g);
+		copy.erase_edge(4, 4, 4);
+		CHECK(copy.fingerprint() == g.fingerprint());
+		CHECK(copy == g);
+
+		g.clear();
+		CHECK(g.fingerprint() == std::uint64_t{0});
+	}
+}
+TEST_CASE("batch: commit matches calling each operation in order") {
+	auto const fresh = [](gdwg::graph<int, int> g) {
+		g.track_fingerprint(false);
+		g.track_fingerprint(true);
+		return g.fingerprint();
+	};
+	for (auto indexed : {false, true}) {
+		auto seed = 12345U;
+		auto const next = [&seed](unsigned bound) {
+			seed = seed * 1103515245U + 12345U;
+			return static_cast<int>((seed >> 16U) % bound);
+		};
+		auto reference = gdwg::graph<int, int>{0, 1, 2, 3, 4, 5};
+		reference.insert_edge(0, 1, 1);
+		reference.insert_edge(2, 0);
+		reference.insert_edge(3, 3, 3);
+		auto g = reference;
+		g.track_in_edges(indexed);
+		g.track_fingerprint(true);
+		for (auto round = 0; round < 20; ++round) {
+			auto tx = g.batch();
+			for (auto i = 0; i < 40; ++i) {
+				auto const a = next(8);
+				auto const b = next(8);
+				auto const weight = next(3) == 0 ? std::nullopt : std::optional<int>(next(4));
+				switch (next(6)) {
+				case 0:
+					reference.insert_node(a);
+					tx.insert_node(a);
+					break;
+				case 1:
+					reference.erase_node(a);
+					tx.erase_node(a);
+					break;
+				case 2:
+				case 3:
+					if (reference.is_node(a) and reference.is_node(b)) {
+						reference.insert_edge(a, b, weight);
+						tx.insert_edge(a, b, weight);
+					}
+					break;
+				default:
+					if (reference.is_node(a) and reference.is_node(b)) {
+						reference.erase_edge(a, b, weight);
+						tx.erase_edge(a, b, weight);
+					}
+				}
+			}
+			tx.commit();
+			CHECK(tx.size() == 0);
+			REQUIRE(g == reference);
+			CHECK(g.fingerprint() == fresh(g));
+			for (auto const n : reference.nodes()) {
+				CHECK(g.predecessors(n) == reference.predecessors(n));
+			}
+		}
+	}
+}
+TEST_CASE("batch: a failing operation rolls the whole batch back") {
+	auto g = gdwg::graph<std::string, int>{"a", "b"};
+	g.insert_edge("a", "b", 1);
+	auto const before = g;
+	auto tx = g.batch();
+	tx.insert_node("c");
+	tx.insert_edge("a", "c", 2);
+	tx.erase_edge("a", "b", 1);
+	tx.erase_node("c");
+	tx.insert_edge("b", "c");
+	CHECK_THROWS_WITH(tx.commit(),
+	                  "Cannot call gdwg::graph<N, E>::insert_edge when either src or dst node does not exist");
+	CHECK(g == before);
+	CHECK(tx.size() == 0);
+
+	tx.erase_edge("a", "z");
+	CHECK_THROWS_WITH(tx.commit(),
+	                  "Cannot call gdwg::graph<N, E>::erase_edge on src or dst if they don't exist in the graph");
+	CHECK(g == before);
+
+	// nothing is applied until commit, and a node may come back after being erased
+	tx.erase_node("b");
+	tx.insert_node("b");
+	tx.insert_edge("b", "a");
+	CHECK(g == before);
+	tx.commit();
+	CHECK(g.find("a", "b", 1) == g.end());
+	CHECK(g.find("b", "a") != g.end());
+	CHECK(before.find("a", "b", 1) != before.end());
+}
+TEST_CASE("batch: an allocation failing part way through a commit rolls the batch back") {
+	auto resource = counting_resource();
+	auto g = gdwg::graph<std::string, int>({"a", "b", "c", "d"}, &resource);
+	g.track_in_edges(true);
+	g.track_fingerprint(true);
+	g.insert_edge("a", "b", 1);
+	g.insert_edge("b", "c", 2);
+	g.insert_edge("d", "a", 3);
+	auto const before = g;
+	// fail each allocation of the commit in turn, until the budget is large enough for all of them
+	for (auto budget = std::size_t{0};; ++budget) {
+		auto tx = g.batch();
+		tx.insert_node("e");
+		tx.insert_edge("a", "e", 4);
+		tx.insert_edge("e", "b");
+		tx.erase_edge("a", "b", 1);
+		tx.erase_node("d");
+		tx.insert_edge("c", "a", 5);
+		resource.limit = resource.allocations + budget;
+		try {
+			tx.commit();
+		} catch (std::bad_alloc const&) {
+			CHECK(g == before);
+			CHECK(g.fingerprint() == before.fingerprint());
+			CHECK(g.in_degree("b") == 1);
+			continue;
+		}
+		resource.limit = std::numeric_limits<std::size_t>::max();
+		CHECK(budget > 0);
+		CHECK(g.find("a", "e", 4) != g.end());
+		CHECK(g.find("a", "b", 1) == g.end());
+		CHECK_FALSE(g.is_node("d"));
+		CHECK(g.in_degree("a") == 1);
+		break;
+	}
+}
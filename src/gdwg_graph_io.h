@@ -0,0 +1,674 @@
+#ifndef GDWG_GRAPH_IO_H
+#define GDWG_GRAPH_IO_H
+#include "gdwg_graph.h"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+namespace gdwg {
+	namespace detail {
+		// Accumulates text in one large buffer and hands it to sink as std::string_view chunks.
+		// Numbers are formatted with std::to_chars, everything else goes through a reused stream.
+		template<typename Sink>
+		class text_buffer {
+		 public:
+			explicit text_buffer(Sink& sink)
+			: sink_(sink)
+			, buffer_(std::make_unique<char[]>(capacity)) {}
+
+			auto append(std::string_view text) -> void;
+			// literals have a known size, so the copy compiles down to a few moves
+			template<std::size_t Size>
+			auto append(char const (&text)[Size]) -> void;
+			template<typename T>
+			auto append_value(T const& value) -> void;
+			auto flush() -> void;
+
+		 private:
+			static constexpr std::size_t capacity = std::size_t{1} << 16U;
+			// longest to_chars output of a builtin arithmetic type, with room to spare
+			static constexpr std::size_t max_number = 64;
+			Sink& sink_;
+			std::unique_ptr<char[]> buffer_;
+			std::size_t size_ = 0;
+			std::ostringstream fallback_;
+		};
+
+		// parses one token as printed by operator<<, std::nullopt if it isn't a whole T
+		template<typename T>
+		auto parse_value(std::string_view text) -> std::optional<T>;
+
+		// read-only private mapping of a whole file
+		class mapped_file {
+		 public:
+			explicit mapped_file(std::string const& path);
+			mapped_file(mapped_file const&) = delete;
+			auto operator=(mapped_file const&) -> mapped_file& = delete;
+			~mapped_file();
+
+			[[nodiscard]] auto data() const noexcept -> char const*;
+			[[nodiscard]] auto size() const noexcept -> std::size_t;
+
+		 private:
+			void* data_ = nullptr;
+			std::size_t size_ = 0;
+		};
+	} // namespace detail
+
+	struct import_options {
+		// field separator, '\0' to use a tab if the first line has one and a comma otherwise
+		char delimiter = '\0';
+		// worker threads, 0 for one per core
+		std::size_t threads = 0;
+	};
+
+	struct import_stats {
+		// lines that parsed into an edge, whether or not the graph already had it
+		std::size_t rows = 0;
+		std::size_t malformed = 0;
+		// 1-based line number of the first malformed line, 0 if there was none
+		std::size_t first_malformed_line = 0;
+		std::size_t nodes_added = 0;
+		std::size_t edges_added = 0;
+		double seconds = 0;
+
+		[[nodiscard]] auto rows_per_second() const noexcept -> double {
+			return seconds > 0 ? static_cast<double>(rows) / seconds : 0;
+		}
+	};
+
+	// Writes g in exactly the format of operator<< on a stream with default formatting, walking the
+	// stored order directly. sink is either a std::ostream or callable with a std::string_view chunk.
+	template<typename N, typename E, typename Sink>
+	auto write_text(graph<N, E> const& g, Sink&& sink) -> void;
+
+	// Parses the format written by operator<< in one pass over text, without a string per line.
+	// Edges are grouped per source and merged into their buckets in bulk. Floating point values
+	// only round-trip to the 6 significant digits that operator<< prints.
+	template<typename N, typename E>
+	auto read_text(std::string_view text) -> graph<N, E>;
+	// read_text on the memory-mapped contents of the file at path
+	template<typename N, typename E>
+	auto load_text(std::string const& path) -> graph<N, E>;
+
+	// Adds the edges of a "src,dst[,weight]" edge list to g, one edge per line, creating the nodes
+	// it doesn't have yet. Fields may be padded with spaces and lines may end in "\r\n"; blank lines
+	// are ignored and malformed lines are skipped and counted. The text is split into one chunk per
+	// thread that is parsed in parallel, then the edges are sorted and merged per source in parallel.
+	template<typename N, typename E>
+	auto import_edges(graph<N, E>& g, std::string_view text, import_options const& options = {}) -> import_stats;
+	// import_edges on the memory-mapped contents of the file at path
+	template<typename N, typename E>
+	auto load_edges(graph<N, E>& g, std::string const& path, import_options const& options = {}) -> import_stats;
+} // namespace gdwg
+template<typename Sink>
+auto gdwg::detail::text_buffer<Sink>::append(std::string_view text) -> void {
+	if (text.size() > capacity - size_) {
+		flush();
+		// too large to be worth copying
+		if (text.size() > capacity) {
+			sink_(text);
+			return;
+		}
+	}
+	std::char_traits<char>::copy(buffer_.get() + size_, text.data(), text.size());
+	size_ += text.size();
+}
+template<typename Sink>
+template<std::size_t Size>
+auto gdwg::detail::text_buffer<Sink>::append(char const (&text)[Size]) -> void {
+	if (capacity - size_ < Size) {
+		flush();
+	}
+	std::memcpy(buffer_.get() + size_, text, Size - 1);
+	size_ += Size - 1;
+}
+template<typename Sink>
+template<typename T>
+auto gdwg::detail::text_buffer<Sink>::append_value(T const& value) -> void {
+	if constexpr (std::is_same_v<T, bool>) {
+		append(value ? "1" : "0");
+	}
+	else if constexpr (std::is_same_v<T, char> or std::is_same_v<T, signed char> or std::is_same_v<T, unsigned char>) {
+		// streams print character types as characters
+		auto const c = static_cast<char>(value);
+		append(std::string_view(&c, 1));
+	}
+	else if constexpr (std::is_arithmetic_v<T>) {
+		if (capacity - size_ < max_number) {
+			flush();
+		}
+		auto* const first = buffer_.get() + size_;
+		auto* const last = buffer_.get() + capacity;
+		auto result = std::to_chars_result();
+		if constexpr (std::is_floating_point_v<T>) {
+			// the stream default is %g with a precision of 6
+			result = std::to_chars(first, last, value, std::chars_format::general, 6);
+		}
+		else {
+			result = std::to_chars(first, last, value);
+		}
+		size_ = static_cast<std::size_t>(result.ptr - buffer_.get());
+	}
+	else if constexpr (std::is_convertible_v<T const&, std::string_view>) {
+		append(std::string_view(value));
+	}
+	else {
+		fallback_.str({});
+		fallback_ << value;
+		append(fallback_.view());
+	}
+}
+template<typename Sink>
+auto gdwg::detail::text_buffer<Sink>::flush() -> void {
+	if (size_ != 0) {
+		sink_(std::string_view(buffer_.get(), size_));
+		size_ = 0;
+	}
+}
+template<typename N, typename E, typename Sink>
+auto gdwg::write_text(graph<N, E> const& g, Sink&& sink) -> void {
+	if constexpr (std::is_base_of_v<std::ostream, std::remove_cvref_t<Sink>>) {
+		auto const to_stream = [&sink](std::string_view chunk) {
+			sink.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+		};
+		write_text(g, to_stream);
+	}
+	else {
+		auto out = detail::text_buffer<std::remove_reference_t<Sink>>(sink);
+		for (auto const& [node, id] : g.nodes_) {
+			out.append_value(node);
+			out.append(" (\n");
+			for (auto const& e : *g.edges_[id]) {
+				out.append("  ");
+				out.append_value(node);
+				out.append(" -> ");
+				out.append_value(*g.values_[e.dst]);
+				if (e.weight) {
+					out.append(" | W | ");
+					out.append_value(*e.weight);
+				}
+				else {
+					out.append(" | U");
+				}
+				out.append("\n");
+			}
+			out.append(")\n");
+		}
+		out.flush();
+	}
+}
+template<typename T>
+auto gdwg::detail::parse_value(std::string_view text) -> std::optional<T> {
+	if constexpr (std::is_same_v<T, bool>) {
+		if (text == "0" or text == "1") {
+			return text == "1";
+		}
+		return std::nullopt;
+	}
+	else if constexpr (std::is_same_v<T, char> or std::is_same_v<T, signed char> or std::is_same_v<T, unsigned char>) {
+		if (text.size() == 1) {
+			return static_cast<T>(text.front());
+		}
+		return std::nullopt;
+	}
+	else if constexpr (std::is_arithmetic_v<T>) {
+		auto value = T();
+		auto const* const last = text.data() + text.size();
+		auto result = std::from_chars_result();
+		if constexpr (std::is_floating_point_v<T>) {
+			result = std::from_chars(text.data(), last, value, std::chars_format::general);
+		}
+		else {
+			result = std::from_chars(text.data(), last, value);
+		}
+		if (result.ec != std::errc() or result.ptr != last) {
+			return std::nullopt;
+		}
+		return value;
+	}
+	else if constexpr (std::is_constructible_v<T, std::string_view>) {
+		return T(text);
+	}
+	else {
+		auto is = std::istringstream(std::string(text));
+		auto value = T();
+		if (!(is >> value) or is.peek() != std::char_traits<char>::eof()) {
+			return std::nullopt;
+		}
+		return value;
+	}
+}
+inline gdwg::detail::mapped_file::mapped_file(std::string const& path) {
+	auto const fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		throw std::runtime_error("Cannot open " + path + " for reading");
+	}
+	struct ::stat info = {};
+	if (::fstat(fd, &info) != 0) {
+		::close(fd);
+		throw std::runtime_error("Cannot open " + path + " for reading");
+	}
+	size_ = static_cast<std::size_t>(info.st_size);
+	// an empty file can't be mapped, and doesn't need to be
+	if (size_ != 0) {
+		data_ = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data_ == MAP_FAILED) {
+			data_ = nullptr;
+			::close(fd);
+			throw std::runtime_error("Cannot map " + path + " into memory");
+		}
+		::madvise(data_, size_, MADV_SEQUENTIAL);
+	}
+	::close(fd);
+}
+inline gdwg::detail::mapped_file::~mapped_file() {
+	if (data_ != nullptr) {
+		::munmap(data_, size_);
+	}
+}
+inline auto gdwg::detail::mapped_file::data() const noexcept -> char const* {
+	return static_cast<char const*>(data_);
+}
+inline auto gdwg::detail::mapped_file::size() const noexcept -> std::size_t {
+	return size_;
+}
+template<typename N, typename E>
+auto gdwg::read_text(std::string_view text) -> graph<N, E> {
+	using node_id = typename graph<N, E>::node_id;
+	struct pending_edge {
+		node_id src;
+		std::string_view dst;
+		std::optional<E> weight;
+		std::size_t line;
+	};
+	auto const malformed = [](std::size_t line) {
+		return std::runtime_error("Cannot call gdwg::read_text on malformed input at line " + std::to_string(line));
+	};
+	auto g = graph<N, E>();
+	// the text each node was printed as, by id
+	auto names = std::vector<std::string_view>();
+	// the parsed nodes by id, kept for numbers, whose printed form is cheap to parse again
+	auto values = std::vector<N>();
+	auto edges = std::vector<pending_edge>();
+	// the node whose block is open, if in_block
+	auto current = node_id{0};
+	auto in_block = false;
+	auto line_number = std::size_t{0};
+	for (auto pos = std::size_t{0}; pos < text.size();) {
+		auto const end = std::min(text.find('\n', pos), text.size());
+		auto const line = text.substr(pos, end - pos);
+		pos = end + 1;
+		++line_number;
+		if (!in_block) {
+			// "<node> ("
+			if (!line.ends_with(" (")) {
+				throw malformed(line_number);
+			}
+			auto const name = line.substr(0, line.size() - 2);
+			auto value = detail::parse_value<N>(name);
+			if (!value or !g.insert_node(*value)) {
+				throw malformed(line_number);
+			}
+			// a fresh graph hands out ids in insertion order
+			current = static_cast<node_id>(g.id_bound() - 1);
+			in_block = true;
+			names.push_back(name);
+			if constexpr (std::is_arithmetic_v<N>) {
+				values.push_back(*value);
+			}
+		}
+		else if (line == ")") {
+			in_block = false;
+		}
+		else {
+			// "  <src> -> <dst> | W | <weight>" or "  <src> -> <dst> | U"
+			auto const& src = names[current];
+			if (!line.starts_with("  ") or line.substr(2, src.size()) != src
+			    or line.substr(2 + src.size(), 4) != " -> ")
+			{
+				throw malformed(line_number);
+			}
+			auto const rest = line.substr(src.size() + 6);
+			if (rest.ends_with(" | U")) {
+				edges.push_back(pending_edge{current, rest.substr(0, rest.size() - 4), std::nullopt, line_number});
+				continue;
+			}
+			auto const separator = rest.find(" | W | ");
+			if (separator == std::string_view::npos) {
+				throw malformed(line_number);
+			}
+			auto weight = detail::parse_value<E>(rest.substr(separator + 7));
+			if (!weight) {
+				throw malformed(line_number);
+			}
+			edges.push_back(pending_edge{current, rest.substr(0, separator), std::move(weight), line_number});
+		}
+	}
+	if (in_block) {
+		throw malformed(line_number);
+	}
+	// destinations may be printed after their first use, so they are resolved once every node is known.
+	// operator<< prints nodes in order, so numbers are found by a binary search of the parsed nodes,
+	// other types by the text they were printed as
+	auto const searchable = std::is_arithmetic_v<N> and std::is_sorted(values.begin(), values.end());
+	auto ids = std::unordered_map<std::string_view, node_id>();
+	if (!searchable) {
+		ids.reserve(names.size());
+		for (auto id = node_id{0}; id < names.size(); ++id) {
+			ids.emplace(names[id], id);
+		}
+	}
+	// integer nodes are usually dense, then a table indexed by value replaces the search
+	auto direct = std::vector<node_id>();
+	auto constexpr absent = std::numeric_limits<node_id>::max();
+	// differences taken modulo 2^64 are exact for every integer type up to 64 bits
+	auto const offset = [&values](N const& value) {
+		if constexpr (std::is_integral_v<N>) {
+			auto const first = static_cast<std::uint64_t>(values.front());
+			return static_cast<std::size_t>(static_cast<std::uint64_t>(value) - first);
+		}
+		return std::size_t{0};
+	};
+	if (std::is_integral_v<N> and searchable and !values.empty() and offset(values.back()) < 4 * values.size()) {
+		direct.assign(offset(values.back()) + 1, absent);
+		for (auto id = node_id{0}; id < values.size(); ++id) {
+			direct[offset(values[id])] = id;
+		}
+	}
+	auto const resolve = [&](std::string_view name) -> std::optional<node_id> {
+		if (!direct.empty()) {
+			auto value = detail::parse_value<N>(name);
+			if (value and !(*value < values.front()) and !(values.back() < *value)
+			    and direct[offset(*value)] != absent)
+			{
+				return direct[offset(*value)];
+			}
+		}
+		else if (searchable) {
+			auto value = detail::parse_value<N>(name);
+			auto it = value ? std::lower_bound(values.begin(), values.end(), *value) : values.end();
+			if (it != values.end() and *it == *value) {
+				return static_cast<node_id>(it - values.begin());
+			}
+		}
+		else if (auto it = ids.find(name); it != ids.end()) {
+			return it->second;
+		}
+		// the same value may have been printed differently, e.g. with a sign
+		auto value = detail::parse_value<N>(name);
+		return value ? g.find_id(*value) : std::nullopt;
+	};
+	for (auto first = edges.begin(); first != edges.end();) {
+		auto const src = first->src;
+		auto records = typename graph<N, E>::bucket(g.get_allocator());
+		for (; first != edges.end() and first->src == src; ++first) {
+			auto id = resolve(first->dst);
+			if (!id) {
+				throw malformed(first->line);
+			}
+			records.push_back({*id, std::move(first->weight)});
+		}
+		g.merge_records(src, records);
+	}
+	return g;
+}
+template<typename N, typename E>
+auto gdwg::load_text(std::string const& path) -> graph<N, E> {
+	auto const file = detail::mapped_file(path);
+	return read_text<N, E>(std::string_view(file.data(), file.size()));
+}
+template<typename N, typename E>
+auto gdwg::import_edges(graph<N, E>& g, std::string_view text, import_options const& options) -> import_stats {
+	using node_id = typename graph<N, E>::node_id;
+	using edge_record = typename graph<N, E>::edge_record;
+	using bucket = typename graph<N, E>::bucket;
+	struct row {
+		N src;
+		N dst;
+		std::optional<E> weight;
+	};
+	struct resolved {
+		node_id src;
+		std::uint32_t dst_rank;
+		edge_record record;
+	};
+	struct chunk {
+		std::string_view text;
+		std::vector<row> rows;
+		// the distinct endpoints of rows, sorted
+		std::vector<N> nodes;
+		// the resolved rows, split by src id into one part per merge task
+		std::vector<std::vector<resolved>> parts;
+		std::size_t lines = 0;
+		std::size_t malformed = 0;
+		std::size_t first_malformed = 0;
+	};
+	auto const start = std::chrono::steady_clock::now();
+	auto stats = import_stats();
+	auto const delimiter = options.delimiter != '\0' ? options.delimiter
+	                       : text.substr(0, text.find('\n')).find('\t') != std::string_view::npos ? '\t'
+	                                                                                           : ',';
+	// a thread per chunk, but not so many that each gets only a few lines
+	auto constexpr min_chunk = std::size_t{1} << 16U;
+	auto const workers = std::min(detail::worker_count(options.threads), text.size() / min_chunk + 1);
+	auto chunks = std::vector<chunk>();
+	for (auto pos = std::size_t{0}; pos < text.size();) {
+		auto const remaining = workers - chunks.size();
+		auto end = remaining <= 1 ? text.size() : text.find('\n', pos + (text.size() - pos) / remaining);
+		end = end == std::string_view::npos ? text.size() : end + 1;
+		chunks.push_back(chunk{text.substr(pos, end - pos), {}, {}, {}, 0, 0, 0});
+		pos = end;
+	}
+
+	auto const trim = [](std::string_view field) {
+		while (!field.empty() and field.front() == ' ') {
+			field.remove_prefix(1);
+		}
+		while (!field.empty() and field.back() == ' ') {
+			field.remove_suffix(1);
+		}
+		return field;
+	};
+	auto const parse_line = [&](std::string_view line, chunk& c) -> bool {
+		auto const first = line.find(delimiter);
+		if (first == std::string_view::npos) {
+			return false;
+		}
+		auto const second = line.find(delimiter, first + 1);
+		auto const src_text = trim(line.substr(0, first));
+		auto const dst_text = trim(line.substr(first + 1, second - std::min(second, first + 1)));
+		if (src_text.empty() or dst_text.empty()) {
+			return false;
+		}
+		auto src = detail::parse_value<N>(src_text);
+		auto dst = detail::parse_value<N>(dst_text);
+		if (!src or !dst) {
+			return false;
+		}
+		auto weight = std::optional<E>();
+		if (second != std::string_view::npos) {
+			auto const weight_text = trim(line.substr(second + 1));
+			// an empty weight field leaves the edge unweighted
+			if (!weight_text.empty() and !(weight = detail::parse_value<E>(weight_text))) {
+				return false;
+			}
+		}
+		c.rows.push_back(row{std::move(*src), std::move(*dst), std::move(weight)});
+		return true;
+	};
+	detail::run_parallel(chunks.size(), [&](std::size_t i) {
+		auto& c = chunks[i];
+		for (auto pos = std::size_t{0}; pos < c.text.size();) {
+			auto const end = std::min(c.text.find('\n', pos), c.text.size());
+			auto line = c.text.substr(pos, end - pos);
+			pos = end + 1;
+			++c.lines;
+			if (line.ends_with('\r')) {
+				line.remove_suffix(1);
+			}
+			if (trim(line).empty() or parse_line(line, c)) {
+				continue;
+			}
+			if (c.malformed++ == 0) {
+				c.first_malformed = c.lines;
+			}
+		}
+		c.nodes.reserve(2 * c.rows.size());
+		for (auto const& r : c.rows) {
+			c.nodes.push_back(r.src);
+			c.nodes.push_back(r.dst);
+		}
+		std::sort(c.nodes.begin(), c.nodes.end());
+		c.nodes.erase(std::unique(c.nodes.begin(), c.nodes.end()), c.nodes.end());
+	});
+	auto line_offset = std::size_t{0};
+	for (auto const& c : chunks) {
+		stats.rows += c.rows.size();
+		if (c.malformed != 0 and stats.malformed == 0) {
+			stats.first_malformed_line = line_offset + c.first_malformed;
+		}
+		stats.malformed += c.malformed;
+		line_offset += c.lines;
+	}
+
+	// merge the chunks' node sets pairwise, halving the number of sets each round
+	for (auto step = std::size_t{1}; step < chunks.size(); step *= 2) {
+		detail::run_parallel((chunks.size() + 2 * step - 1) / (2 * step), [&](std::size_t i) {
+			auto const into = 2 * step * i;
+			if (into + step >= chunks.size()) {
+				return;
+			}
+			auto& a = chunks[into].nodes;
+			auto& b = chunks[into + step].nodes;
+			auto merged = std::vector<N>();
+			merged.reserve(a.size() + b.size());
+			std::merge(std::make_move_iterator(a.begin()),
+			           std::make_move_iterator(a.end()),
+			           std::make_move_iterator(b.begin()),
+			           std::make_move_iterator(b.end()),
+			           std::back_inserter(merged));
+			merged.erase(std::unique(merged.begin(), merged.end()), merged.end());
+			a = std::move(merged);
+			b = std::vector<N>();
+		});
+	}
+	auto const nodes = chunks.empty() ? std::vector<N>() : std::move(chunks.front().nodes);
+	// the node map is a single tree, so it grows on this thread
+	auto ids = std::vector<node_id>();
+	ids.reserve(nodes.size());
+	for (auto const& value : nodes) {
+		stats.nodes_added += g.insert_node(value) ? 1U : 0U;
+		ids.push_back(*g.find_id(value));
+	}
+
+	// resolve endpoints to their rank in the sorted node list, which orders like their values, and
+	// split the records by the task that merges them. Dense integers are ranked through a table
+	auto constexpr absent = std::numeric_limits<std::uint32_t>::max();
+	auto const offset = [&nodes](N const& value) {
+		if constexpr (std::is_integral_v<N>) {
+			auto const first = static_cast<std::uint64_t>(nodes.front());
+			return static_cast<std::size_t>(static_cast<std::uint64_t>(value) - first);
+		}
+		return std::size_t{0};
+	};
+	auto direct = std::vector<std::uint32_t>();
+	if (std::is_integral_v<N> and !nodes.empty() and offset(nodes.back()) < 4 * nodes.size()) {
+		direct.assign(offset(nodes.back()) + 1, absent);
+		for (auto rank = std::uint32_t{0}; rank < nodes.size(); ++rank) {
+			direct[offset(nodes[rank])] = rank;
+		}
+	}
+	auto const rank_of = [&](N const& value) {
+		if (!direct.empty()) {
+			return direct[offset(value)];
+		}
+		return static_cast<std::uint32_t>(std::lower_bound(nodes.begin(), nodes.end(), value) - nodes.begin());
+	};
+	auto const parts = chunks.size();
+	detail::run_parallel(chunks.size(), [&](std::size_t i) {
+		auto& c = chunks[i];
+		c.parts.resize(parts);
+		for (auto& r : c.rows) {
+			auto const src = ids[rank_of(r.src)];
+			auto const dst = rank_of(r.dst);
+			c.parts[src % parts].push_back(resolved{src, dst, edge_record{ids[dst], std::move(r.weight)}});
+		}
+		c.rows = std::vector<row>();
+	});
+
+	// each source's bucket is owned by one task, so buckets can be merged concurrently as long as
+	// nothing else is shared: no in-edge index or fingerprint, and a thread safe memory resource
+	auto const concurrent = !g.track_in_ and !g.fingerprint_ and detail::thread_safe(g.get_allocator().resource());
+	auto batches = std::vector<std::vector<std::pair<node_id, bucket>>>(parts);
+	auto added = std::vector<std::size_t>(parts);
+	// the bucket order, by destination value then weight, with ranks standing in for the values
+	auto const less = [](resolved const& a, resolved const& b) {
+		if (a.src != b.src) {
+			return a.src < b.src;
+		}
+		if (a.dst_rank != b.dst_rank) {
+			return a.dst_rank < b.dst_rank;
+		}
+		return a.record.weight < b.record.weight;
+	};
+	detail::run_parallel(parts, [&](std::size_t p) {
+		auto records = std::vector<resolved>();
+		for (auto& c : chunks) {
+			std::move(c.parts[p].begin(), c.parts[p].end(), std::back_inserter(records));
+			c.parts[p] = {};
+		}
+		std::sort(records.begin(), records.end(), less);
+		for (auto first = records.begin(); first != records.end();) {
+			auto const src = first->src;
+			auto batch = bucket(std::pmr::new_delete_resource());
+			for (; first != records.end() and first->src == src; ++first) {
+				batch.push_back(std::move(first->record));
+			}
+			if (concurrent) {
+				added[p] += g.merge_records(src, batch);
+			}
+			else {
+				batches[p].emplace_back(src, std::move(batch));
+			}
+		}
+	});
+	for (auto p = std::size_t{0}; p < parts; ++p) {
+		for (auto& [src, batch] : batches[p]) {
+			added[p] += g.merge_records(src, batch);
+		}
+		stats.edges_added += added[p];
+	}
+	stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return stats;
+}
+template<typename N, typename E>
+auto gdwg::load_edges(graph<N, E>& g, std::string const& path, import_options const& options) -> import_stats {
+	auto const file = detail::mapped_file(path);
+	return import_edges(g, std::string_view(file.data(), file.size()), options);
+}
+#endif // GDWG_GRAPH_IO_H
@@ -0,0 +1,279 @@
+#include "gdwg_graph_io.h"
+
+#include <catch2/catch.hpp>
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <memory_resource>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+	template<typename N, typename E>
+	auto streamed(gdwg::graph<N, E> const& g) -> std::string {
+		auto os = std::ostringstream();
+		os << g;
+		return os.str();
+	}
+
+	template<typename N, typename E>
+	auto written(gdwg::graph<N, E> const& g) -> std::string {
+		auto text = std::string();
+		gdwg::write_text(g, [&text](std::string_view chunk) { text += chunk; });
+		return text;
+	}
+
+	struct point {
+		int x;
+		int y;
+		friend auto operator<=>(point const&, point const&) = default;
+		friend auto operator<<(std::ostream& os, point const& p) -> std::ostream& {
+			return os << '<' << p.x << ", " << p.y << '>';
+		}
+	};
+} // namespace
+
+TEST_CASE("write_text: empty graph and nodes without edges") {
+	CHECK(written(gdwg::graph<int, int>{}).empty());
+	auto g = gdwg::graph<int, int>{3, -1, 2};
+	CHECK(written(g) == "-1 (\n)\n2 (\n)\n3 (\n)\n");
+	CHECK(written(g) == streamed(g));
+}
+TEST_CASE("write_text: matches operator<< for integers and strings") {
+	auto g = gdwg::graph<std::string, long>{"alpha", "beta", "gamma"};
+	g.insert_edge("alpha", "beta", std::numeric_limits<long>::min());
+	g.insert_edge("alpha", "beta");
+	g.insert_edge("alpha", "alpha", 0);
+	g.insert_edge("gamma", "beta", std::numeric_limits<long>::max());
+	CHECK(written(g) == streamed(g));
+}
+TEST_CASE("write_text: formats floating point weights like a default stream") {
+	auto g = gdwg::graph<int, double>{1, 2};
+	for (auto w : {0.0, -0.0, 1.5, 0.1 + 0.2, 1e-5, 123456.0, 1234567.0, 1e100, -2.5e-300, 1.0 / 3.0}) {
+		g.insert_edge(1, 2, w);
+	}
+	g.insert_edge(2, 1, std::numeric_limits<double>::infinity());
+	g.insert_edge(2, 1, -std::numeric_limits<double>::infinity());
+	CHECK(written(g) == streamed(g));
+
+	auto f = gdwg::graph<float, float>{0.25F, 3.14159265F};
+	f.insert_edge(0.25F, 3.14159265F, 1e7F);
+	CHECK(written(f) == streamed(f));
+}
+TEST_CASE("write_text: characters, booleans and streamable types") {
+	auto c = gdwg::graph<char, bool>{'a', 'z'};
+	c.insert_edge('a', 'z', true);
+	c.insert_edge('z', 'a', false);
+	CHECK(written(c) == streamed(c));
+
+	auto p = gdwg::graph<point, int>{point{1, 2}, point{0, 5}};
+	p.insert_edge(point{1, 2}, point{0, 5}, 7);
+	CHECK(written(p) == streamed(p));
+}
+TEST_CASE("write_text: large graphs are split into chunks without changing the output") {
+	auto g = gdwg::graph<int, int>{};
+	for (auto i = 0; i < 2000; ++i) {
+		g.insert_node(i);
+	}
+	for (auto i = 0; i < 2000; ++i) {
+		for (auto j = 0; j < 10; ++j) {
+			g.insert_edge(i, (i * 7 + j) % 2000, j % 3 == 0 ? std::nullopt : std::optional<int>(i - j));
+		}
+	}
+	auto chunks = 0;
+	auto text = std::string();
+	gdwg::write_text(g, [&](std::string_view chunk) {
+		++chunks;
+		text += chunk;
+	});
+	CHECK(chunks > 1);
+	CHECK(text == streamed(g));
+
+	auto os = std::ostringstream();
+	gdwg::write_text(g, os);
+	CHECK(os.str() == text);
+}
+TEST_CASE("read_text: round-trips what operator<< writes") {
+	auto g = gdwg::graph<std::string, double>{"alpha", "beta", "gamma", "delta"};
+	g.insert_edge("alpha", "beta", 1.5);
+	g.insert_edge("alpha", "beta");
+	g.insert_edge("alpha", "alpha", -0.25);
+	g.insert_edge("gamma", "alpha", 1e-5);
+	g.insert_edge("delta", "gamma", 123456.0);
+	auto const parsed = gdwg::read_text<std::string, double>(streamed(g));
+	CHECK(parsed == g);
+	CHECK(streamed(parsed) == streamed(g));
+
+	auto c = gdwg::graph<char, bool>{'a', 'b'};
+	c.insert_edge('a', 'b', true);
+	c.insert_edge('b', 'a');
+	CHECK(gdwg::read_text<char, bool>(written(c)) == c);
+
+	CHECK(gdwg::read_text<int, int>("").empty());
+}
+TEST_CASE("read_text: edges may point at nodes printed later") {
+	auto const text = std::string_view("1 (\n  1 -> 3 | W | 5\n  1 -> 2 | U\n)\n2 (\n)\n3 (\n  3 -> 1 | W | -4\n)\n");
+	auto g = gdwg::read_text<int, int>(text);
+	CHECK(g.nodes() == std::vector<int>{1, 2, 3});
+	CHECK(g.find(1, 3, 5) != g.end());
+	CHECK(g.find(1, 2) != g.end());
+	CHECK(g.find(3, 1, -4) != g.end());
+	CHECK(written(g) == "1 (\n  1 -> 2 | U\n  1 -> 3 | W | 5\n)\n2 (\n)\n3 (\n  3 -> 1 | W | -4\n)\n");
+}
+TEST_CASE("read_text: malformed input reports its line") {
+	auto const parse = [](std::string_view text) { return gdwg::read_text<int, int>(text); };
+	CHECK_THROWS_WITH(parse("1 (\n  1 -> 2 | U\n)\n"), "Cannot call gdwg::read_text on malformed input at line 2");
+	CHECK_THROWS_WITH(parse("1 (\n)\n2 (\n  1 -> 2 | U\n)\n"),
+	                  "Cannot call gdwg::read_text on malformed input at line 4");
+	CHECK_THROWS_AS(parse("1 (\n  1 -> 1 | W | x\n)\n"), std::runtime_error);
+	CHECK_THROWS_AS(parse("1 (\n  1 -> 1 | V\n)\n"), std::runtime_error);
+	CHECK_THROWS_AS(parse("1 (\n)\n1 (\n)\n"), std::runtime_error);
+	CHECK_THROWS_AS(parse("x (\n)\n"), std::runtime_error);
+	CHECK_THROWS_AS(parse("1 (\n  1 -> 1 | U\n"), std::runtime_error);
+	CHECK(parse("1 (\n)\n") == gdwg::graph<int, int>{1});
+}
+TEST_CASE("load_text: maps a file written by write_text") {
+	auto g = gdwg::graph<int, int>{};
+	for (auto i = 0; i < 500; ++i) {
+		g.insert_node(i);
+	}
+	for (auto i = 0; i < 500; ++i) {
+		g.insert_edge(i, (i * 31) % 500, i);
+		g.insert_edge(i, (i * 17) % 500);
+	}
+	auto const path = std::string("gdwg_graph_io_test.txt");
+	{
+		auto file = std::ofstream(path);
+		gdwg::write_text(g, file);
+	}
+	CHECK(gdwg::load_text<int, int>(path) == g);
+	std::ofstream(path).close();
+	CHECK(gdwg::load_text<int, int>(path).empty());
+	std::remove(path.c_str());
+	auto const load = [&path] { return gdwg::load_text<int, int>(path); };
+	CHECK_THROWS_AS(load(), std::runtime_error);
+}
+TEST_CASE("read_text: sparse, negative and out of order nodes") {
+	auto sparse = gdwg::graph<long, int>{-1'000'000, 0, 5, 1'000'000'000};
+	sparse.insert_edge(-1'000'000, 1'000'000'000, 1);
+	sparse.insert_edge(5, -1'000'000);
+	sparse.insert_edge(0, 0, 0);
+	CHECK(gdwg::read_text<long, int>(written(sparse)) == sparse);
+
+	auto dense = gdwg::graph<short, int>{-3, -2, -1, 0, 1};
+	dense.insert_edge(-3, 1, 4);
+	dense.insert_edge(1, -3);
+	CHECK(gdwg::read_text<short, int>(written(dense)) == dense);
+
+	// hand-written input need not list the nodes in order
+	auto const shuffled = gdwg::read_text<int, int>("3 (\n  3 -> 1 | U\n)\n1 (\n  1 -> 3 | W | 2\n)\n");
+	auto expected = gdwg::graph<int, int>{1, 3};
+	expected.insert_edge(3, 1);
+	expected.insert_edge(1, 3, 2);
+	CHECK(shuffled == expected);
+}
+TEST_CASE("import_edges: comma separated rows with and without weights") {
+	auto g = gdwg::graph<int, int>{};
+	auto const stats = gdwg::import_edges(g, "1,2,5\n2,3\n 3 , 1 , -4 \r\n\n1,2,5\n4,4,\n");
+	auto expected = gdwg::graph<int, int>{1, 2, 3, 4};
+	expected.insert_edge(1, 2, 5);
+	expected.insert_edge(2, 3);
+	expected.insert_edge(3, 1, -4);
+	expected.insert_edge(4, 4);
+	CHECK(g == expected);
+	CHECK(stats.rows == 5);
+	CHECK(stats.malformed == 0);
+	CHECK(stats.first_malformed_line == 0);
+	CHECK(stats.nodes_added == 4);
+	CHECK(stats.edges_added == 4);
+
+	auto const empty = gdwg::import_edges(g, "");
+	CHECK(empty.rows == 0);
+	CHECK(g == expected);
+}
+TEST_CASE("import_edges: tabs are detected and malformed lines are counted") {
+	auto g = gdwg::graph<std::string, double>{"a"};
+	g.insert_edge("a", "a", 1.0);
+	auto const stats = gdwg::import_edges(g, "a\tb\t0.5\nno separator\nb\t\t1\nb\tc\tx\nc\ta\na\tb\tc\td\n");
+	CHECK(stats.rows == 2);
+	CHECK(stats.malformed == 4);
+	CHECK(stats.first_malformed_line == 2);
+	CHECK(stats.nodes_added == 2);
+	CHECK(stats.edges_added == 2);
+	CHECK(g.nodes() == std::vector<std::string>{"a", "b", "c"});
+	CHECK(g.find("a", "b", 0.5) != g.end());
+	CHECK(g.find("c", "a") != g.end());
+	CHECK(g.find("a", "a", 1.0) != g.end());
+
+	auto semicolons = gdwg::graph<int, int>{};
+	auto const custom = gdwg::import_edges(semicolons, "1;2;3\n1,2,3\n", {.delimiter = ';'});
+	CHECK(custom.rows == 1);
+	CHECK(custom.malformed == 1);
+	CHECK(custom.first_malformed_line == 2);
+}
+TEST_CASE("import_edges: parallel import matches inserting edge by edge") {
+	auto text = std::string();
+	auto expected = gdwg::graph<int, int>{-1};
+	expected.insert_edge(-1, -1, 7);
+	for (auto i = 0; i < 40'000; ++i) {
+		auto const src = (i * 7919) % 5000;
+		auto const dst = (i * 104729) % 6000;
+		expected.insert_node(src);
+		expected.insert_node(dst);
+		if (i % 3 == 0) {
+			text += std::to_string(src) + "," + std::to_string(dst) + "\n";
+			expected.insert_edge(src, dst);
+		}
+		else {
+			text += std::to_string(src) + "," + std::to_string(dst) + "," + std::to_string(i % 50) + "\n";
+			expected.insert_edge(src, dst, i % 50);
+		}
+		if (i % 10'000 == 0) {
+			text += "bad line\n";
+		}
+	}
+	for (auto const& threads : {std::size_t{1}, std::size_t{4}, std::size_t{16}}) {
+		auto g = gdwg::graph<int, int>{-1};
+		g.insert_edge(-1, -1, 7);
+		auto const stats = gdwg::import_edges(g, text, {.threads = threads});
+		CHECK(g == expected);
+		CHECK(stats.rows == 40'000);
+		CHECK(stats.malformed == 4);
+		CHECK(stats.first_malformed_line == 2);
+	}
+
+	// with an in-edge index and a fingerprint to maintain the buckets are merged on one thread
+	auto tracked = gdwg::graph<int, int>{-1};
+	tracked.insert_edge(-1, -1, 7);
+	tracked.track_in_edges(true);
+	tracked.track_fingerprint(true);
+	gdwg::import_edges(tracked, text, {.threads = 4});
+	CHECK(tracked == expected);
+	auto fresh = tracked;
+	fresh.track_fingerprint(false);
+	fresh.track_fingerprint(true);
+	CHECK(tracked.fingerprint() == fresh.fingerprint());
+	CHECK(tracked.in_edges(0).size() == expected.in_edges(0).size());
+
+	// a synchronized pool is safe to merge into concurrently
+	auto pool = std::pmr::synchronized_pool_resource();
+	auto pooled = gdwg::graph<int, int>({-1}, &pool);
+	pooled.insert_edge(-1, -1, 7);
+	gdwg::import_edges(pooled, text, {.threads = 4});
+	CHECK(pooled == expected);
+}
+TEST_CASE("load_edges: imports a file") {
+	auto const path = std::string("gdwg_graph_io_test.csv");
+	std::ofstream(path) << "x,y,1\ny,z\n";
+	auto g = gdwg::graph<std::string, int>{};
+	auto const stats = gdwg::load_edges(g, path);
+	CHECK(stats.rows == 2);
+	CHECK(g.is_connected("x", "y"));
+	CHECK(g.is_connected("y", "z"));
+	std::remove(path.c_str());
+	auto const load = [&path, &g] { return gdwg::load_edges(g, path); };
+	CHECK_THROWS_AS(load(), std::runtime_error);
+}
@@ -0,0 +1,566 @@
+#ifndef GDWG_JOURNAL_H
+#define GDWG_JOURNAL_H
+#include "gdwg_graph.h"
+#include "gdwg_graph_io.h"
+#include "gdwg_mapped_graph.h"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+namespace gdwg {
+	namespace detail {
+		// Journal layout: a journal_header, then records of a u32 payload size, a u32 checksum of
+		// the op and payload, a u8 journal_op and the payload. A record cut short or failing its
+		// checksum marks the end of what was committed before a crash.
+		inline constexpr auto journal_magic = std::array<char, 8>{'G', 'D', 'W', 'G', 'J', 'R', 'N', 'L'};
+		inline constexpr auto journal_version = std::uint32_t{1};
+
+		struct journal_header {
+			std::array<char, 8> magic;
+			std::uint32_t version;
+			std::uint32_t byte_order;
+			// sizeof(N), or 0 when the nodes are strings
+			std::uint32_t node_size;
+			std::uint32_t weight_size;
+		};
+
+		enum class journal_op : std::uint8_t {
+			insert_node = 1,
+			insert_edge,
+			erase_edge,
+			replace_node,
+			merge_replace_node,
+			erase_node,
+			clear,
+		};
+
+		// 32-bit FNV-1a, enough to tell a torn write from a whole record
+		auto journal_checksum(std::string_view bytes) noexcept -> std::uint32_t;
+
+		// append-only file descriptor
+		class journal_file {
+		 public:
+			journal_file() = default;
+			explicit journal_file(std::string const& path);
+			journal_file(journal_file&& other) noexcept;
+			auto operator=(journal_file&& other) noexcept -> journal_file&;
+			~journal_file();
+
+			auto write(std::string_view bytes) -> void;
+			auto sync() -> void;
+
+		 private:
+			int fd_ = -1;
+			std::string path_;
+		};
+
+		// fsyncs the file or directory at path, so a rename or a file written through a stream is durable
+		auto sync_path(std::string const& path) -> void;
+	} // namespace detail
+
+	struct journal_options {
+		// mutations buffered before they're written to the journal as one group
+		std::size_t group_size = 256;
+		// fdatasync each group; without it a group survives a process crash but not a power loss
+		bool sync = true;
+		// checkpoint once the journal holds this many bytes, 0 to checkpoint only when asked
+		std::size_t checkpoint_bytes = std::size_t{64} << 20U;
+	};
+
+	// A graph whose mutations are logged to an append-only journal in a directory, so it can be
+	// recovered after a crash by loading the last checkpoint and replaying the journal after it.
+	// Mutations are buffered and written in groups, commit() makes everything so far durable.
+	// A checkpoint writes a save_binary snapshot and starts an empty journal, both numbered by
+	// generation; recovery uses the newest complete snapshot. N must be trivially copyable or
+	// std::string and E trivially copyable, as for save_binary.
+	template<typename N, typename E>
+	class journaled_graph {
+	 public:
+		// recovers the graph stored in directory, creating the directory if needed
+		explicit journaled_graph(std::string directory, journal_options options = {});
+		journaled_graph(journaled_graph const&) = delete;
+		auto operator=(journaled_graph const&) -> journaled_graph& = delete;
+		// commits what's buffered, errors are lost; call commit() first to see them
+		~journaled_graph();
+
+		// the recovered and updated graph, for reading
+		[[nodiscard]] auto get() const noexcept -> graph<N, E> const&;
+
+		auto insert_node(N const& value) -> bool;
+		auto insert_edge(N const& src, N const& dst, std::optional<E> weight = std::nullopt) -> bool;
+		template<typename InputIt>
+		auto insert_edges(InputIt first, InputIt last) -> std::size_t;
+		auto replace_node(N const& old_data, N const& new_data) -> bool;
+		auto merge_replace_node(N const& old_data, N const& new_data) -> void;
+		auto erase_node(N const& value) -> bool;
+		auto erase_edge(N const& src, N const& dst, std::optional<E> weight = std::nullopt) -> bool;
+		auto clear() -> void;
+
+		// writes the buffered group to the journal, and syncs it if options.sync
+		auto commit() -> void;
+		// commits, then replaces the snapshot and journal with a snapshot of the current graph
+		auto checkpoint() -> void;
+
+		// records replayed from the journal when the graph was recovered
+		[[nodiscard]] auto replayed() const noexcept -> std::size_t;
+		[[nodiscard]] auto generation() const noexcept -> std::uint64_t;
+
+	 private:
+		std::string directory_;
+		journal_options options_;
+		graph<N, E> graph_;
+		detail::journal_file journal_;
+		std::uint64_t generation_ = 0;
+		std::size_t journal_bytes_ = 0;
+		std::size_t replayed_ = 0;
+		// encoded records not yet written
+		std::string pending_;
+		std::size_t pending_count_ = 0;
+
+		[[nodiscard]] auto snapshot_path(std::uint64_t generation) const -> std::string;
+		[[nodiscard]] auto journal_path(std::uint64_t generation) const -> std::string;
+		static auto header() noexcept -> detail::journal_header;
+		// starts an empty journal for generation
+		auto create_journal(std::uint64_t generation) -> void;
+		// replays the journal of generation_ into graph_, returns the length of its committed prefix
+		auto replay(std::string const& path) -> std::size_t;
+		auto apply(detail::journal_op op, std::string_view payload) -> void;
+
+		auto log(detail::journal_op op, std::string const& payload) -> void;
+		static auto put_node(std::string& out, N const& value) -> void;
+		static auto put_weight(std::string& out, std::optional<E> const& weight) -> void;
+		static auto get_node(std::string_view& in) -> N;
+		static auto get_weight(std::string_view& in) -> std::optional<E>;
+	};
+} // namespace gdwg
+inline auto gdwg::detail::journal_checksum(std::string_view bytes) noexcept -> std::uint32_t {
+	auto hash = std::uint32_t{2166136261U};
+	for (auto const c : bytes) {
+		hash = (hash ^ static_cast<unsigned char>(c)) * 16777619U;
+	}
+	return hash;
+}
+inline gdwg::detail::journal_file::journal_file(std::string const& path)
+: fd_(::open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644))
+, path_(path) {
+	if (fd_ < 0) {
+		throw std::runtime_error("Cannot open " + path + " for writing");
+	}
+}
+inline gdwg::detail::journal_file::journal_file(journal_file&& other) noexcept
+: fd_(std::exchange(other.fd_, -1))
+, path_(std::move(other.path_)) {}
+inline auto gdwg::detail::journal_file::operator=(journal_file&& other) noexcept -> journal_file& {
+	if (this != &other) {
+		if (fd_ >= 0) {
+			::close(fd_);
+		}
+		fd_ = std::exchange(other.fd_, -1);
+		path_ = std::move(other.path_);
+	}
+	return *this;
+}
+inline gdwg::detail::journal_file::~journal_file() {
+	if (fd_ >= 0) {
+		::close(fd_);
+	}
+}
+inline auto gdwg::detail::journal_file::write(std::string_view bytes) -> void {
+	while (!bytes.empty()) {
+		auto const written = ::write(fd_, bytes.data(), bytes.size());
+		if (written < 0) {
+			throw std::runtime_error("Cannot write " + path_);
+		}
+		bytes.remove_prefix(static_cast<std::size_t>(written));
+	}
+}
+inline auto gdwg::detail::journal_file::sync() -> void {
+	if (::fdatasync(fd_) != 0) {
+		throw std::runtime_error("Cannot sync " + path_);
+	}
+}
+inline auto gdwg::detail::sync_path(std::string const& path) -> void {
+	auto const fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		throw std::runtime_error("Cannot open " + path + " for reading");
+	}
+	auto const synced = ::fsync(fd) == 0;
+	::close(fd);
+	if (!synced) {
+		throw std::runtime_error("Cannot sync " + path);
+	}
+}
+template<typename N, typename E>
+gdwg::journaled_graph<N, E>::journaled_graph(std::string directory, journal_options options)
+: directory_(std::move(directory))
+, options_(options) {
+	static_assert(std::is_same_v<N, std::string> or std::is_trivially_copyable_v<N>,
+	              "journaled_graph nodes must be trivially copyable or std::string");
+	static_assert(std::is_trivially_copyable_v<E>, "journaled_graph weights must be trivially copyable");
+	namespace fs = std::filesystem;
+	fs::create_directories(directory_);
+	// the newest complete snapshot wins, a checkpoint only renames its snapshot into place once written
+	auto found = std::vector<std::uint64_t>();
+	for (auto const& entry : fs::directory_iterator(directory_)) {
+		auto const name = entry.path().filename().string();
+		auto generation = std::uint64_t{0};
+		auto const* const last = name.data() + name.size();
+		if (name.starts_with("snapshot.") and std::from_chars(name.data() + 9, last, generation).ptr == last) {
+			found.push_back(generation);
+		}
+	}
+	if (!found.empty()) {
+		generation_ = *std::max_element(found.begin(), found.end());
+		graph_ = load_binary<N, E>(snapshot_path(generation_)).thaw();
+	}
+	auto const path = journal_path(generation_);
+	if (fs::exists(path)) {
+		journal_bytes_ = replay(path);
+		// drop a torn tail so new records follow the last whole one
+		fs::resize_file(path, journal_bytes_);
+		journal_ = detail::journal_file(path);
+	}
+	else {
+		create_journal(generation_);
+	}
+	// files of older generations, and snapshots a crash left half written
+	for (auto const& entry : fs::directory_iterator(directory_)) {
+		auto const name = entry.path().filename().string();
+		auto const current = std::to_string(generation_);
+		if ((name.starts_with("snapshot.") or name.starts_with("journal.")) and name != "snapshot." + current
+		    and name != "journal." + current)
+		{
+			fs::remove(entry.path());
+		}
+	}
+}
+template<typename N, typename E>
+gdwg::journaled_graph<N, E>::~journaled_graph() {
+	try {
+		commit();
+	} catch (...) {
+	}
+}
+template<typename N, typename E>
+auto gdwg::journaled_graph<N, E>::get() const noexcept -> graph<N, E> const& {
+	return graph_;
+}
+template<typename N, typename E>
+auto gdwg::journaled_graph<N, E>::snapshot_path(std::uint64_t generation) const -> std::string {
+	return directory_ + "/snapshot." + std::to_string(generation);
+}
+template<typename N, typename E>
+auto gdwg::journaled_graph<N, E>::journal_path(std::uint64_t generation) const -> std::string {
+	return directory_ + "/journal." + std::to_string(generation);
+}
+template<typename N, typename E>
+auto gdwg::journaled_graph<N, E>::header() noexcept -> detail::journal_header {
+	auto result = detail::journal_header();
+	std::memset(&result, 0, sizeof(result));
+	result.magic = detail::journal_magic;
+	result.version = detail::journal_version;
+	result.byte_order = detail::snapshot_byte_order;
+	result.node_size = std::is_same_v<N, std::string> ? 0 : static_cast<std::uint32_t>(sizeof(N));
+	result.weight_size = static_cast<std::uint32_t>(sizeof(E));
+	return result;
+}
+template<typename N, typename E>
+auto gdwg::journaled_graph<N, E>::create_journal(std::uint64_t generation) -> void {
+	auto const path = journal_path(generation);
+	std::filesystem::remove(path);
+	journal_ = detail::journal_file(path);
+	auto const h = header();
+	journal_.write(std::string_view(reinterpret_cast<char const*>(&h), sizeof(h)));
+	journal_.sync();
+	detail::sync_path(directory_);
+	journal_bytes_ = sizeof(h);
+}
+template<typename N, typename E>
+auto gdwg::journaled_graph<N, E>::replay(std::string const& path) -> std::size_t {
+	auto const file = detail::mapped_file(path);
+	auto const text = std::string_view(file.data(), file.size());
+	auto h = detail::journal_header();
+	// a crash while the journal was being created leaves less than a header, so nothing was logged
+	if (text.size() < sizeof(h)) {
+		create_journal(generation_);
+		return journal_bytes_;
+	}
+	std::memcpy(&h, text.data(), sizeof(h));
+	auto const expected = header();
+	if (std::memcmp(&h, &expected, sizeof(h)) != 0) {
+		throw std::runtime_error("Cannot call gdwg::journaled_graph on " + path
+		                         + ", it isn't a journal of this graph type");
+	}
+	auto pos = sizeof(h);
+	while (text.size() - pos >= 2 * sizeof(std::uint32_t) + 1) {
+		auto size = std::uint32_t{0};
+		auto checksum = std::uint32_t{0};
+		std::memcpy(&size, text.data() + pos, sizeof(size));
+		std::memcpy(&checksum, text.data() + pos + sizeof(size), sizeof(checksum));
+		auto const body_at = pos + 2 * sizeof(std::uint32_t);
+		if (size >= text.size() - body_at) {
+			break;
+		}
+		auto const body = text.substr(body_at, size + 1);
+		if (detail::journal_checksum(body) != checksum) {
+			break;
+		}
+		apply(static_cast<detail::journal_op>(body.front()), body.substr(1));
+		++replayed_;
+		pos = body_at + body.size();
+	}
+	return pos;
+}
+template<typename N, typename E>
+auto gdwg::journaled_graph<N, E>::apply(detail::journal_op op, std::string_view payload) -> void {
+	switch (op) {
+	case detail::journal_op::insert_node: graph_.insert_node(get_node(payload)); break;
+	case detail::journal_op::insert_edge: {
+		auto src = get_node(payload);
+		auto dst = get_node(payload);
+		graph_.insert_edge(src, dst, get_weight(payload));
+		break;
+	}
+	case detail::journal_op::erase_edge: {
+		auto src = get_node(payload);
+		auto dst = get_node(payload);
+		graph_.erase_edge(src, dst, get_weight(payload));
+		break;
+	}
+	case detail::journal_op::replace_node: {
+		auto old_data = get_node(payload);
+		graph_.replace_node(old_data, get_node(payload));
+		break;
+	}
+	case detail::journal_op::merge_replace_node: {
+		auto old_data = get_node(payload);
+		graph_.merge_replace_node(old_data, get_node(payload));
+		break;
+	}
+	case detail::journal_op::erase_node: graph_.erase_node(get_node(payload)); break;
+	case detail::journal_op::clear: graph_.clear(); break;
+	default: throw std::runtime_error("Cannot call gdwg::journaled_graph on a journal with an unknown record");
+	}
+}
+template<typename N, typename E>
+auto gdwg::journaled_graph<N, E>::put_node(std::string& out, N const& value) -> void {
+	if constexpr (std::is_same_v<N, std::string>) {
+		auto const size = static_cast<std::uint32_t>(value.size());
+		out.append(reinterpret_cast<char const*>(&size), sizeof(size));
+		out.append(value);
+	}
+	else {
+		out.append(reinterpret_cast<char const*>(&value), sizeof(N));
+	}
+}
+template<typename N, typename E>
+auto gdwg::journaled_graph<N, E>::put_weight(std::string& out, std::optional<E> const& weight) -> void {
+	out.push_back(weight ? '\1' : '\0');
+	if (weight) {
+		out.append(reinterpret_cast<char const*>(&*weight), sizeof(E));
+	}
+}
+template<typename N, typename E>
+auto gdwg::journaled_graph<N, E>::get_node(std::string_view& in) -> N {
+	auto const malformed = [] {
+		return std::runtime_error("Cannot call gdwg::journaled_graph on a journal with a malformed record");
+	};
+	if constexpr (std::is_same_v<N, std::string>) {
+		auto size = std::uint32_t{0};
+		if (in.size() < sizeof(size)) {
+			throw malformed();
+		}
+		std::memcpy(&size, in.data(), sizeof(size));
+		in.remove_prefix(sizeof(size));
+		if (in.size() < size) {
+			throw malformed();
+		}
+		auto value = std::string(in.substr(0, size));
+		in.remove_prefix(size);
+		return value;
+	}
+	else {
+		auto value = N();
+		if (in.size() < sizeof(N)) {
+			throw malformed();
+		}
+		std::memcpy(&value, in.data(), sizeof(N));
+		in.remove_prefix(sizeof(N));
+		return value;
+	}
+}
+template<typename N, typename E>
+auto gdwg::journaled_graph<N, E>::get_weight(std::string_view& in) -> std::optional<E> {
+	auto const malformed = [] {
+		return std::runtime_error("Cannot call gdwg::journaled_graph on a journal with a malformed record");
+	};
+	if (in.empty()) {
+		throw malformed();
+	}
+	auto const weighted = in.front() != '\0';
+	in.remove_prefix(1);
+	if (!weighted) {
+		return std::nullopt;
+	}
+	if (in.size() < sizeof(E)) {
+		throw malformed();
+	}
+	auto weight = E();
+	std::memcpy(&weight, in.data(), sizeof(E));
+	in.remove_prefix(sizeof(E));
+	return weight;
+}
+template<typename N, typename E>
+auto gdwg::journaled_graph<N, E>::log(detail::journal_op op, std::string const& payload) -> void {
+	auto const size = static_cast<std::uint32_t>(payload.size());
+	auto const at = pending_.size();
+	// the checksum is filled in once the body is in place
+	pending_.append(reinterpret_cast<char const*>(&size), sizeof(size));
+	pending_.append(sizeof(std::uint32_t), '\0');
+	pending_.push_back(static_cast<char>(op));
+	pending_.append(payload);
+	auto const body_at = at + 2 * sizeof(std::uint32_t);
+	auto const checksum = detail::journal_checksum(std::string_view(pending_).substr(body_at));
+	std::memcpy(pending_.data() + at + sizeof(size), &checksum, sizeof(checksum));
+	if (++pending_count_ >= options_.group_size) {
+		commit();
+	}
+}
+template<typename N, typename E>
+auto gdwg::journaled_graph<N, E>::insert_node(N const& value) -> bool {
+	if (!graph_.insert_node(value)) {
+		return false;
+	}
+	auto payload = std::string();
+	put_node(payload, value);
+	log(detail::journal_op::insert_node, payload);
+	return true;
+}
+template<typename N, typename E>
+auto gdwg::journaled_graph<N, E>::insert_edge(N const& src, N const& dst, std::optional<E> weight) -> bool {
+	if (!graph_.insert_edge(src, dst, weight)) {
+		return false;
+	}
+	auto payload = std::string();
+	put_node(payload, src);
+	put_node(payload, dst);
+	put_weight(payload, weight);
+	log(detail::journal_op::insert_edge, payload);
+	return true;
+}
+template<typename N, typename E>
+template<typename InputIt>
+auto gdwg::journaled_graph<N, E>::insert_edges(InputIt first, InputIt last) -> std::size_t {
+	// replaying an insert of an edge that exists is a no-op, so every triple is logged as given
+	auto const triples = std::vector<typename std::iterator_traits<InputIt>::value_type>(first, last);
+	auto const added = graph_.insert_edges(triples.begin(), triples.end());
+	auto payload = std::string();
+	for (auto const& [src, dst, weight] : triples) {
+		payload.clear();
+		put_node(payload, src);
+		put_node(payload, dst);
+		put_weight(payload, weight);
+		log(detail::journal_op::insert_edge, payload);
+	}
+	return added;
+}
+template<typename N, typename E>
+auto gdwg::journaled_graph<N, E>::replace_node(N const& old_data, N const& new_data) -> bool {
+	if (!graph_.replace_node(old_data, new_data)) {
+		return false;
+	}
+	auto payload = std::string();
+	put_node(payload, old_data);
+	put_node(payload, new_data);
+	log(detail::journal_op::replace_node, payload);
+	return true;
+}
+template<typename N, typename E>
+auto gdwg::journaled_graph<N, E>::merge_replace_node(N const& old_data, N const& new_data) -> void {
+	graph_.merge_replace_node(old_data, new_data);
+	auto payload = std::string();
+	put_node(payload, old_data);
+	put_node(payload, new_data);
+	log(detail::journal_op::merge_replace_node, payload);
+}
+template<typename N, typename E>
+auto gdwg::journaled_graph<N, E>::erase_node(N const& value) -> bool {
+	if (!graph_.erase_node(value)) {
+		return false;
+	}
+	auto payload = std::string();
+	put_node(payload, value);
+	log(detail::journal_op::erase_node, payload);
+	return true;
+}
+template<typename N, typename E>
+auto gdwg::journaled_graph<N, E>::erase_edge(N const& src, N const& dst, std::optional<E> weight) -> bool {
+	if (!graph_.erase_edge(src, dst, weight)) {
+		return false;
+	}
+	auto payload = std::string();
+	put_node(payload, src);
+	put_node(payload, dst);
+	put_weight(payload, weight);
+	log(detail::journal_op::erase_edge, payload);
+	return true;
+}
+template<typename N, typename E>
+auto gdwg::journaled_graph<N, E>::clear() -> void {
+	graph_.clear();
+	log(detail::journal_op::clear, std::string());
+}
+template<typename N, typename E>
+auto gdwg::journaled_graph<N, E>::commit() -> void {
+	if (pending_.empty()) {
+		return;
+	}
+	journal_.write(pending_);
+	if (options_.sync) {
+		journal_.sync();
+	}
+	journal_bytes_ += pending_.size();
+	pending_.clear();
+	pending_count_ = 0;
+	if (options_.checkpoint_bytes != 0 and journal_bytes_ >= options_.checkpoint_bytes) {
+		checkpoint();
+	}
+}
+template<typename N, typename E>
+auto gdwg::journaled_graph<N, E>::checkpoint() -> void {
+	commit();
+	auto const next = generation_ + 1;
+	auto const temporary = snapshot_path(next) + ".tmp";
+	save_binary(graph_, temporary);
+	detail::sync_path(temporary);
+	// from here on recovery starts at next, whose journal is empty until it's created below
+	std::filesystem::rename(temporary, snapshot_path(next));
+	create_journal(next);
+	std::filesystem::remove(journal_path(generation_));
+	std::filesystem::remove(snapshot_path(generation_));
+	generation_ = next;
+}
+template<typename N, typename E>
+auto gdwg::journaled_graph<N, E>::replayed() const noexcept -> std::size_t {
+	return replayed_;
+}
+template<typename N, typename E>
+auto gdwg::journaled_graph<N, E>::generation() const noexcept -> std::uint64_t {
+	return generation_;
+}
+#endif // GDWG_JOURNAL_H
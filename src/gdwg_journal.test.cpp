@@ -0,0 +1,154 @@
+#include "gdwg_journal.h"
+
+#include <catch2/catch.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace {
+	// a fresh directory for one test, removed again when the test ends
+	struct scratch_directory {
+		std::string path;
+		explicit scratch_directory(std::string name)
+		: path(std::move(name)) {
+			std::filesystem::remove_all(path);
+		}
+		scratch_directory(scratch_directory const&) = delete;
+		auto operator=(scratch_directory const&) -> scratch_directory& = delete;
+		~scratch_directory() {
+			std::filesystem::remove_all(path);
+		}
+	};
+
+	// the committed state a crash would leave behind, taken while the journaled graph is still open
+	auto crash_copy(std::string const& from, std::string const& to) -> void {
+		std::filesystem::remove_all(to);
+		std::filesystem::copy(from, to);
+	}
+} // namespace
+
+TEST_CASE("journaled_graph: every kind of mutation is replayed") {
+	auto const dir = scratch_directory("gdwg_journal_test_replay");
+	auto expected = gdwg::graph<std::string, int>();
+	{
+		auto j = gdwg::journaled_graph<std::string, int>(dir.path);
+		CHECK(j.get().nodes().empty());
+		CHECK(j.insert_node("a"));
+		CHECK(j.insert_node("b"));
+		CHECK(j.insert_node("c"));
+		CHECK_FALSE(j.insert_node("a"));
+		CHECK(j.insert_edge("a", "b", 1));
+		CHECK(j.insert_edge("a", "b"));
+		CHECK(j.insert_edge("b", "c", 2));
+		CHECK(j.insert_edge("c", "a", 3));
+		auto const triples = std::vector<std::tuple<std::string, std::string, std::optional<int>>>{
+		    {"c", "c", 4},
+		    {"a", "c", std::nullopt},
+		};
+		CHECK(j.insert_edges(triples.begin(), triples.end()) == 2);
+		CHECK(j.erase_edge("a", "b", 1));
+		CHECK(j.replace_node("c", "d"));
+		j.merge_replace_node("b", "a");
+		CHECK(j.erase_node("d"));
+		CHECK(j.insert_node("e"));
+		expected = j.get();
+	}
+	auto const recovered = gdwg::journaled_graph<std::string, int>(dir.path);
+	CHECK(recovered.get() == expected);
+	CHECK(recovered.replayed() == 14);
+	CHECK(recovered.get().nodes() == std::vector<std::string>{"a", "e"});
+
+	{
+		auto j = gdwg::journaled_graph<std::string, int>(dir.path);
+		j.clear();
+	}
+	CHECK(gdwg::journaled_graph<std::string, int>(dir.path).get().nodes().empty());
+}
+TEST_CASE("journaled_graph: only committed groups survive a crash") {
+	auto const dir = scratch_directory("gdwg_journal_test_groups");
+	auto const crashed = scratch_directory("gdwg_journal_test_groups_crashed");
+	auto j = gdwg::journaled_graph<int, double>(dir.path, {.group_size = 4, .sync = false});
+	for (auto i = 0; i < 6; ++i) {
+		j.insert_node(i);
+	}
+	// four mutations filled a group and were written, two are still buffered
+	crash_copy(dir.path, crashed.path);
+	CHECK(gdwg::journaled_graph<int, double>(crashed.path).get().nodes() == std::vector<int>{0, 1, 2, 3});
+
+	j.commit();
+	crash_copy(dir.path, crashed.path);
+	CHECK(gdwg::journaled_graph<int, double>(crashed.path).get() == j.get());
+}
+TEST_CASE("journaled_graph: a torn record at the end of the journal is dropped") {
+	auto const dir = scratch_directory("gdwg_journal_test_torn");
+	{
+		auto j = gdwg::journaled_graph<int, int>(dir.path);
+		j.insert_node(1);
+		j.insert_node(2);
+		j.insert_edge(1, 2, 3);
+	}
+	auto const journal = dir.path + "/journal.0";
+	auto const size = std::filesystem::file_size(journal);
+	std::filesystem::resize_file(journal, size - 2);
+	{
+		auto j = gdwg::journaled_graph<int, int>(dir.path);
+		CHECK(j.replayed() == 2);
+		CHECK(j.get().nodes() == std::vector<int>{1, 2});
+		CHECK_FALSE(j.get().is_node(3));
+		// new records follow the last whole one
+		j.insert_edge(2, 1);
+	}
+	auto const recovered = gdwg::journaled_graph<int, int>(dir.path);
+	CHECK(recovered.replayed() == 3);
+	CHECK(recovered.get().find(2, 1) != recovered.get().end());
+	CHECK(recovered.get().find(1, 2, 3) == recovered.get().end());
+
+	std::ofstream(journal, std::ios::app) << "garbage that fails its checksum";
+	CHECK(gdwg::journaled_graph<int, int>(dir.path).replayed() == 3);
+	auto const wrong_type = [&dir] { return gdwg::journaled_graph<long, int>(dir.path); };
+	CHECK_THROWS_AS(wrong_type(), std::runtime_error);
+}
+TEST_CASE("journaled_graph: checkpoints replace the journal with a snapshot") {
+	auto const dir = scratch_directory("gdwg_journal_test_checkpoint");
+	auto const crashed = scratch_directory("gdwg_journal_test_checkpoint_crashed");
+	auto expected = gdwg::graph<int, int>();
+	{
+		auto j = gdwg::journaled_graph<int, int>(dir.path, {.group_size = 1, .sync = false, .checkpoint_bytes = 0});
+		for (auto i = 0; i < 100; ++i) {
+			j.insert_node(i);
+		}
+		j.checkpoint();
+		CHECK(j.generation() == 1);
+		for (auto i = 0; i < 100; ++i) {
+			j.insert_edge(i, (i * 7) % 100, i);
+		}
+		crash_copy(dir.path, crashed.path);
+		expected = j.get();
+	}
+	auto const recovered = gdwg::journaled_graph<int, int>(crashed.path);
+	CHECK(recovered.get() == expected);
+	CHECK(recovered.generation() == 1);
+	CHECK(recovered.replayed() == 100);
+	CHECK_FALSE(std::filesystem::exists(crashed.path + "/journal.0"));
+	CHECK_FALSE(std::filesystem::exists(crashed.path + "/snapshot.0"));
+
+	// a snapshot left half written by a crash during a checkpoint is ignored
+	std::ofstream(crashed.path + "/snapshot.2.tmp") << "partial";
+	auto const after = gdwg::journaled_graph<int, int>(crashed.path);
+	CHECK(after.get() == expected);
+	CHECK_FALSE(std::filesystem::exists(crashed.path + "/snapshot.2.tmp"));
+
+	// the journal checkpoints by itself once it grows past checkpoint_bytes
+	auto j = gdwg::journaled_graph<int, int>(dir.path, {.group_size = 8, .sync = false, .checkpoint_bytes = 512});
+	for (auto i = 0; i < 200; ++i) {
+		j.insert_edge(i % 100, (i * 3) % 100, -i);
+	}
+	CHECK(j.generation() > 1);
+	expected = j.get();
+	j.commit();
+	crash_copy(dir.path, crashed.path);
+	CHECK(gdwg::journaled_graph<int, int>(crashed.path).get() == expected);
+}
@@ -0,0 +1,506 @@
+#ifndef GDWG_MAPPED_GRAPH_H
+#define GDWG_MAPPED_GRAPH_H
+#include "gdwg_graph.h"
+#include "gdwg_graph_io.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+namespace gdwg {
+	namespace detail {
+		// Snapshot layout: the header, then sections aligned to snapshot_alignment. Nodes are stored
+		// sorted, so a node's id is its rank. The out-edges of node i are the records
+		// [offsets[i], offsets[i + 1]), sorted by (dst, weight) with the unweighted edge first.
+		inline constexpr auto snapshot_magic = std::array<char, 8>{'G', 'D', 'W', 'G', 'S', 'N', 'A', 'P'};
+		inline constexpr auto snapshot_version = std::uint32_t{1};
+		inline constexpr auto snapshot_byte_order = std::uint32_t{0x01020304};
+		inline constexpr auto snapshot_alignment = std::size_t{64};
+
+		struct snapshot_header {
+			std::array<char, 8> magic;
+			std::uint32_t version;
+			// snapshot_byte_order as written, so a snapshot from a different byte order is rejected
+			std::uint32_t byte_order;
+			// sizeof(N), or 0 when the nodes are strings kept in a string table
+			std::uint32_t node_size;
+			std::uint32_t weight_size;
+			std::uint64_t node_count;
+			std::uint64_t edge_count;
+			// byte offsets of the sections, nodes_at is the string table's offsets for string nodes
+			std::uint64_t nodes_at;
+			std::uint64_t names_at;
+			std::uint64_t offsets_at;
+			std::uint64_t records_at;
+			std::uint64_t file_size;
+		};
+
+		template<typename E>
+		struct snapshot_record {
+			std::uint32_t dst;
+			std::uint32_t weighted;
+			E weight;
+		};
+	} // namespace detail
+
+	// Read-only graph over a memory-mapped snapshot written by save_binary. Opening it only checks
+	// the header, queries read the mapping in place. N must be trivially copyable or std::string,
+	// E trivially copyable.
+	template<typename N, typename E>
+	class mapped_graph {
+	 public:
+		using node_id = std::uint32_t;
+		using edge = gdwg::edge<N, E>;
+		static constexpr bool string_nodes = std::is_same_v<N, std::string>;
+		static_assert(string_nodes or std::is_trivially_copyable_v<N>,
+		              "mapped_graph nodes must be trivially copyable or std::string");
+		static_assert(std::is_trivially_copyable_v<E>, "mapped_graph weights must be trivially copyable");
+
+		class iterator {
+		 public:
+			using value_type = typename graph<N, E>::iterator::value_type;
+			using reference = const value_type;
+			using pointer = void;
+			using difference_type = std::ptrdiff_t;
+			using iterator_category = std::bidirectional_iterator_tag;
+
+			iterator() = default;
+			auto operator*() const -> const reference;
+			auto operator++() -> iterator&;
+			auto operator++(int) -> iterator;
+			auto operator--() -> iterator&;
+			auto operator--(int) -> iterator;
+			auto operator==(iterator const& other) const -> bool;
+
+		 private:
+			const mapped_graph* g = nullptr;
+			std::size_t src = 0;
+			std::size_t pos = 0;
+			iterator(const mapped_graph* graph, std::size_t src, std::size_t pos);
+
+			friend class mapped_graph;
+		};
+
+		explicit mapped_graph(std::string const& path);
+
+		// copies the snapshot into a mutable graph
+		[[nodiscard]] auto thaw() const -> graph<N, E>;
+
+		[[nodiscard]] auto is_node(N const& value) const noexcept -> bool;
+		[[nodiscard]] auto empty() const noexcept -> bool;
+		[[nodiscard]] auto is_connected(N const& src, N const& dst) const -> bool;
+		[[nodiscard]] auto nodes() const -> std::vector<N>;
+		[[nodiscard]] auto edges(N const& src, N const& dst) const -> std::vector<std::unique_ptr<edge>>;
+		[[nodiscard]] auto find(N const& src, N const& dst, std::optional<E> weight = std::nullopt) const -> iterator;
+		[[nodiscard]] auto connections(N const& src) const -> std::vector<N>;
+		[[nodiscard]] auto node_count() const noexcept -> std::size_t;
+		[[nodiscard]] auto edge_count() const noexcept -> std::size_t;
+
+		[[nodiscard]] auto begin() const -> iterator;
+		[[nodiscard]] auto end() const -> iterator;
+
+	 private:
+		using record = detail::snapshot_record<E>;
+		// a string node is read as a view into the string table
+		using node_ref = std::conditional_t<string_nodes, std::string_view, N const&>;
+
+		std::unique_ptr<detail::mapped_file> file_;
+		std::size_t node_count_ = 0;
+		std::size_t edge_count_ = 0;
+		N const* nodes_ = nullptr;
+		std::uint64_t const* name_offsets_ = nullptr;
+		char const* names_ = nullptr;
+		std::uint64_t const* offsets_ = nullptr;
+		record const* records_ = nullptr;
+
+		[[nodiscard]] auto node(std::size_t id) const noexcept -> node_ref;
+		[[nodiscard]] auto id_of(N const& value) const noexcept -> std::optional<node_id>;
+		// the [first, last) positions of the records src -> dst
+		[[nodiscard]] auto edge_range(node_id src, node_id dst) const noexcept -> std::pair<std::size_t, std::size_t>;
+		[[nodiscard]] auto weight_of(std::size_t pos) const -> std::optional<E>;
+	};
+
+	// Writes g as a snapshot that load_binary can map
+	template<typename N, typename E>
+	auto save_binary(graph<N, E> const& g, std::string const& path) -> void;
+	template<typename N, typename E>
+	auto load_binary(std::string const& path) -> mapped_graph<N, E>;
+} // namespace gdwg
+template<typename N, typename E>
+auto gdwg::save_binary(graph<N, E> const& g, std::string const& path) -> void {
+	using node_id = typename graph<N, E>::node_id;
+	using record = detail::snapshot_record<E>;
+	static_assert(std::is_same_v<N, std::string> or std::is_trivially_copyable_v<N>,
+	              "save_binary nodes must be trivially copyable or std::string");
+	static_assert(std::is_trivially_copyable_v<E>, "save_binary weights must be trivially copyable");
+	auto const aligned = [](std::uint64_t at) {
+		return (at + detail::snapshot_alignment - 1) / detail::snapshot_alignment * detail::snapshot_alignment;
+	};
+	// ranks in value order become the snapshot's ids
+	auto rank = std::vector<node_id>(g.id_bound());
+	auto next = node_id{0};
+	auto names_size = std::uint64_t{0};
+	for (auto const& [value, id] : g.nodes_) {
+		rank[id] = next++;
+		if constexpr (std::is_same_v<N, std::string>) {
+			names_size += value.size();
+		}
+	}
+	auto header = detail::snapshot_header();
+	std::memset(&header, 0, sizeof(header));
+	header.magic = detail::snapshot_magic;
+	header.version = detail::snapshot_version;
+	header.byte_order = detail::snapshot_byte_order;
+	header.node_size = std::is_same_v<N, std::string> ? 0 : static_cast<std::uint32_t>(sizeof(N));
+	header.weight_size = static_cast<std::uint32_t>(sizeof(E));
+	header.node_count = g.nodes_.size();
+	for (auto const& [value, id] : g.nodes_) {
+		header.edge_count += g.edges_[id]->size();
+	}
+	header.nodes_at = aligned(sizeof(header));
+	if constexpr (std::is_same_v<N, std::string>) {
+		header.names_at = aligned(header.nodes_at + (header.node_count + 1) * sizeof(std::uint64_t));
+		header.offsets_at = aligned(header.names_at + names_size);
+	}
+	else {
+		header.offsets_at = aligned(header.nodes_at + header.node_count * sizeof(N));
+	}
+	header.records_at = aligned(header.offsets_at + (header.node_count + 1) * sizeof(std::uint64_t));
+	header.file_size = header.records_at + header.edge_count * sizeof(record);
+
+	auto out = std::ofstream(path, std::ios::binary | std::ios::trunc);
+	if (!out) {
+		throw std::runtime_error("Cannot open " + path + " for writing");
+	}
+	auto written = std::uint64_t{0};
+	auto const write = [&](void const* data, std::size_t size) {
+		out.write(static_cast<char const*>(data), static_cast<std::streamsize>(size));
+		written += size;
+	};
+	auto const pad_to = [&](std::uint64_t at) {
+		static constexpr auto zeros = std::array<char, detail::snapshot_alignment>{};
+		write(zeros.data(), static_cast<std::size_t>(at - written));
+	};
+	write(&header, sizeof(header));
+	pad_to(header.nodes_at);
+	if constexpr (std::is_same_v<N, std::string>) {
+		auto at = std::uint64_t{0};
+		write(&at, sizeof(at));
+		for (auto const& [value, id] : g.nodes_) {
+			at += value.size();
+			write(&at, sizeof(at));
+		}
+		pad_to(header.names_at);
+		for (auto const& [value, id] : g.nodes_) {
+			write(value.data(), value.size());
+		}
+	}
+	else {
+		for (auto const& [value, id] : g.nodes_) {
+			write(&value, sizeof(N));
+		}
+	}
+	pad_to(header.offsets_at);
+	auto offset = std::uint64_t{0};
+	write(&offset, sizeof(offset));
+	for (auto const& [value, id] : g.nodes_) {
+		offset += g.edges_[id]->size();
+		write(&offset, sizeof(offset));
+	}
+	pad_to(header.records_at);
+	// buckets are sorted by destination value, which is rank order, so records are written as stored
+	for (auto const& [value, id] : g.nodes_) {
+		for (auto const& e : *g.edges_[id]) {
+			auto r = record();
+			std::memset(&r, 0, sizeof(r));
+			r.dst = rank[e.dst];
+			r.weighted = e.weight ? 1U : 0U;
+			if (e.weight) {
+				r.weight = *e.weight;
+			}
+			write(&r, sizeof(r));
+		}
+	}
+	out.close();
+	if (!out) {
+		throw std::runtime_error("Cannot write " + path);
+	}
+}
+template<typename N, typename E>
+auto gdwg::load_binary(std::string const& path) -> mapped_graph<N, E> {
+	return mapped_graph<N, E>(path);
+}
+template<typename N, typename E>
+gdwg::mapped_graph<N, E>::mapped_graph(std::string const& path)
+: file_(std::make_unique<detail::mapped_file>(path)) {
+	auto const invalid = [&path] {
+		return std::runtime_error("Cannot call gdwg::load_binary on " + path
+		                          + ", it isn't a snapshot of this graph type");
+	};
+	auto header = detail::snapshot_header();
+	if (file_->size() < sizeof(header)) {
+		throw invalid();
+	}
+	std::memcpy(&header, file_->data(), sizeof(header));
+	auto const node_size = string_nodes ? 0 : sizeof(N);
+	if (header.magic != detail::snapshot_magic or header.version != detail::snapshot_version
+	    or header.byte_order != detail::snapshot_byte_order or header.node_size != node_size
+	    or header.weight_size != sizeof(E) or header.file_size != file_->size())
+	{
+		throw invalid();
+	}
+	// every section has to lie inside the file before anything is read from it
+	auto const fits = [&header](std::uint64_t at, std::uint64_t count, std::uint64_t size) {
+		return at % detail::snapshot_alignment == 0 and at <= header.file_size
+		       and count <= (header.file_size - at) / size;
+	};
+	if (!fits(header.offsets_at, header.node_count + 1, sizeof(std::uint64_t))
+	    or !fits(header.records_at, header.edge_count, sizeof(record))
+	    or (!string_nodes and !fits(header.nodes_at, header.node_count, sizeof(N)))
+	    or (string_nodes and !fits(header.nodes_at, header.node_count + 1, sizeof(std::uint64_t))))
+	{
+		throw invalid();
+	}
+	node_count_ = static_cast<std::size_t>(header.node_count);
+	edge_count_ = static_cast<std::size_t>(header.edge_count);
+	auto const* const base = file_->data();
+	offsets_ = reinterpret_cast<std::uint64_t const*>(base + header.offsets_at);
+	records_ = reinterpret_cast<record const*>(base + header.records_at);
+	// lookups index with what was read, so the offsets have to run in order from 0 to edge_count and
+	// every record has to point at a node
+	if (offsets_[0] != 0 or offsets_[node_count_] != header.edge_count
+	    or !std::is_sorted(offsets_, offsets_ + node_count_ + 1)
+	    or !std::all_of(records_, records_ + edge_count_, [this](record const& r) { return r.dst < node_count_; }))
+	{
+		throw invalid();
+	}
+	if constexpr (string_nodes) {
+		name_offsets_ = reinterpret_cast<std::uint64_t const*>(base + header.nodes_at);
+		names_ = base + header.names_at;
+		if (name_offsets_[0] != 0 or !std::is_sorted(name_offsets_, name_offsets_ + node_count_ + 1)
+		    or !fits(header.names_at, name_offsets_[node_count_], 1))
+		{
+			throw invalid();
+		}
+	}
+	else {
+		nodes_ = reinterpret_cast<N const*>(base + header.nodes_at);
+	}
+}
+template<typename N, typename E>
+gdwg::mapped_graph<N, E>::iterator::iterator(const mapped_graph* graph, std::size_t src, std::size_t pos)
+: g(graph)
+, src(src)
+, pos(pos) {}
+template<typename N, typename E>
+auto gdwg::mapped_graph<N, E>::iterator::operator*() const -> const reference {
+	return reference{N(g->node(src)), N(g->node(g->records_[pos].dst)), g->weight_of(pos)};
+}
+template<typename N, typename E>
+auto gdwg::mapped_graph<N, E>::iterator::operator++() -> iterator& {
+	++pos;
+	// skip the sources whose records end at or before pos
+	while (src < g->node_count_ and g->offsets_[src + 1] <= pos) {
+		++src;
+	}
+	return *this;
+}
+template<typename N, typename E>
+auto gdwg::mapped_graph<N, E>::iterator::operator++(int) -> iterator {
+	auto temp = *this;
+	++(*this);
+	return temp;
+}
+template<typename N, typename E>
+auto gdwg::mapped_graph<N, E>::iterator::operator--() -> iterator& {
+	--pos;
+	while (g->offsets_[src] > pos) {
+		--src;
+	}
+	return *this;
+}
+template<typename N, typename E>
+auto gdwg::mapped_graph<N, E>::iterator::operator--(int) -> iterator {
+	auto temp = *this;
+	--(*this);
+	return temp;
+}
+template<typename N, typename E>
+auto gdwg::mapped_graph<N, E>::iterator::operator==(iterator const& other) const -> bool {
+	return g == other.g and pos == other.pos;
+}
+template<typename N, typename E>
+auto gdwg::mapped_graph<N, E>::node(std::size_t id) const noexcept -> node_ref {
+	if constexpr (string_nodes) {
+		auto const first = name_offsets_[id];
+		return std::string_view(names_ + first, static_cast<std::size_t>(name_offsets_[id + 1] - first));
+	}
+	else {
+		return nodes_[id];
+	}
+}
+template<typename N, typename E>
+auto gdwg::mapped_graph<N, E>::id_of(N const& value) const noexcept -> std::optional<node_id> {
+	// binary search over the ranks, nodes are stored in order
+	auto first = std::size_t{0};
+	auto count = node_count_;
+	while (count > 0) {
+		auto const half = count / 2;
+		if (node(first + half) < value) {
+			first += half + 1;
+			count -= half + 1;
+		}
+		else {
+			count = half;
+		}
+	}
+	if (first == node_count_ or node(first) != value) {
+		return std::nullopt;
+	}
+	return static_cast<node_id>(first);
+}
+template<typename N, typename E>
+auto gdwg::mapped_graph<N, E>::edge_range(node_id src, node_id dst) const noexcept
+    -> std::pair<std::size_t, std::size_t> {
+	auto const* const first = records_ + offsets_[src];
+	auto const* const last = records_ + offsets_[src + 1];
+	auto const lo = std::lower_bound(first, last, dst, [](record const& r, node_id id) { return r.dst < id; });
+	auto const hi = std::upper_bound(lo, last, dst, [](node_id id, record const& r) { return id < r.dst; });
+	return {static_cast<std::size_t>(lo - records_), static_cast<std::size_t>(hi - records_)};
+}
+template<typename N, typename E>
+auto gdwg::mapped_graph<N, E>::weight_of(std::size_t pos) const -> std::optional<E> {
+	if (records_[pos].weighted == 0) {
+		return std::nullopt;
+	}
+	return records_[pos].weight;
+}
+template<typename N, typename E>
+auto gdwg::mapped_graph<N, E>::thaw() const -> graph<N, E> {
+	auto const values = nodes();
+	auto g = graph<N, E>(values.begin(), values.end());
+	g.insert_edges(begin(), end());
+	return g;
+}
+template<typename N, typename E>
+auto gdwg::mapped_graph<N, E>::is_node(N const& value) const noexcept -> bool {
+	return id_of(value).has_value();
+}
+template<typename N, typename E>
+auto gdwg::mapped_graph<N, E>::empty() const noexcept -> bool {
+	return node_count_ == 0;
+}
+template<typename N, typename E>
+auto gdwg::mapped_graph<N, E>::is_connected(N const& src, N const& dst) const -> bool {
+	auto src_id = id_of(src);
+	auto dst_id = id_of(dst);
+	if (!src_id or !dst_id) {
+		throw std::runtime_error("Cannot call gdwg::mapped_graph<N, E>::is_connected if src or dst node don't exist in "
+		                         "the graph");
+	}
+	auto [first, last] = edge_range(*src_id, *dst_id);
+	return first != last;
+}
+template<typename N, typename E>
+auto gdwg::mapped_graph<N, E>::nodes() const -> std::vector<N> {
+	auto result = std::vector<N>();
+	result.reserve(node_count_);
+	for (auto id = std::size_t{0}; id < node_count_; ++id) {
+		result.emplace_back(node(id));
+	}
+	return result;
+}
+template<typename N, typename E>
+auto gdwg::mapped_graph<N, E>::edges(N const& src, N const& dst) const -> std::vector<std::unique_ptr<edge>> {
+	auto src_id = id_of(src);
+	auto dst_id = id_of(dst);
+	if (!src_id or !dst_id) {
+		throw std::runtime_error("Cannot call gdwg::mapped_graph<N, E>::edges if src or dst node don't exist in the "
+		                         "graph");
+	}
+	auto result = std::vector<std::unique_ptr<edge>>();
+	auto [first, last] = edge_range(*src_id, *dst_id);
+	for (auto i = first; i != last; ++i) {
+		if (records_[i].weighted != 0) {
+			result.push_back(std::make_unique<weighted_edge<N, E>>(src, dst, records_[i].weight));
+		}
+		else {
+			result.push_back(std::make_unique<unweighted_edge<N, E>>(src, dst));
+		}
+	}
+	return result;
+}
+template<typename N, typename E>
+auto gdwg::mapped_graph<N, E>::find(N const& src, N const& dst, std::optional<E> weight) const -> iterator {
+	auto src_id = id_of(src);
+	auto dst_id = id_of(dst);
+	if (!src_id or !dst_id) {
+		return end();
+	}
+	auto [first, last] = edge_range(*src_id, *dst_id);
+	// weights within one (src, dst) run are sorted with the unweighted edge first
+	auto const less = [this](std::size_t pos, std::optional<E> const& w) { return weight_of(pos) < w; };
+	auto lo = first;
+	auto count = last - first;
+	while (count > 0) {
+		auto const half = count / 2;
+		if (less(lo + half, weight)) {
+			lo += half + 1;
+			count -= half + 1;
+		}
+		else {
+			count = half;
+		}
+	}
+	if (lo == last or weight_of(lo) != weight) {
+		return end();
+	}
+	return iterator(this, *src_id, lo);
+}
+template<typename N, typename E>
+auto gdwg::mapped_graph<N, E>::connections(N const& src) const -> std::vector<N> {
+	auto src_id = id_of(src);
+	if (!src_id) {
+		throw std::runtime_error("Cannot call gdwg::mapped_graph<N, E>::connections if src doesn't exist in the graph");
+	}
+	auto result = std::vector<N>();
+	for (auto i = offsets_[*src_id]; i != offsets_[*src_id + 1]; ++i) {
+		if (i == offsets_[*src_id] or records_[i].dst != records_[i - 1].dst) {
+			result.emplace_back(node(records_[i].dst));
+		}
+	}
+	return result;
+}
+template<typename N, typename E>
+auto gdwg::mapped_graph<N, E>::node_count() const noexcept -> std::size_t {
+	return node_count_;
+}
+template<typename N, typename E>
+auto gdwg::mapped_graph<N, E>::edge_count() const noexcept -> std::size_t {
+	return edge_count_;
+}
+template<typename N, typename E>
+auto gdwg::mapped_graph<N, E>::begin() const -> iterator {
+	auto it = iterator(this, 0, 0);
+	// position on the first source that owns an edge
+	while (it.src < node_count_ and offsets_[it.src + 1] == 0) {
+		++it.src;
+	}
+	return it;
+}
+template<typename N, typename E>
+auto gdwg::mapped_graph<N, E>::end() const -> iterator {
+	return iterator(this, node_count_, edge_count_);
+}
+#endif // GDWG_MAPPED_GRAPH_H
@@ -0,0 +1,142 @@
+#include "gdwg_mapped_graph.h"
+
+#include <catch2/catch.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+	auto make_graph() -> gdwg::graph<std::string, int> {
+		auto g = gdwg::graph<std::string, int>{"A", "B", "C", "D"};
+		g.insert_edge("A", "B", 3);
+		g.insert_edge("A", "B");
+		g.insert_edge("A", "B", 1);
+		g.insert_edge("A", "C", 2);
+		g.insert_edge("C", "A");
+		g.insert_edge("C", "C", 5);
+		return g;
+	}
+} // namespace
+
+TEST_CASE("save_binary: empty graph") {
+	auto const path = std::string("gdwg_mapped_graph_test_empty.bin");
+	gdwg::save_binary(gdwg::graph<int, int>{}, path);
+	auto const m = gdwg::load_binary<int, int>(path);
+	CHECK(m.empty());
+	CHECK(m.begin() == m.end());
+	CHECK(m.node_count() == 0);
+	CHECK(m.edge_count() == 0);
+	CHECK(m.thaw().empty());
+	std::remove(path.c_str());
+}
+TEST_CASE("load_binary: string nodes answer the same queries as the source graph") {
+	auto const g = make_graph();
+	auto const path = std::string("gdwg_mapped_graph_test_strings.bin");
+	gdwg::save_binary(g, path);
+	auto const m = gdwg::load_binary<std::string, int>(path);
+	CHECK(m.nodes() == g.nodes());
+	CHECK(m.node_count() == 4);
+	CHECK(m.edge_count() == 6);
+	CHECK(m.is_node("D"));
+	CHECK_FALSE(m.is_node("E"));
+	CHECK(m.is_connected("A", "B"));
+	CHECK_FALSE(m.is_connected("B", "A"));
+	CHECK(m.connections("A") == std::vector<std::string>{"B", "C"});
+	CHECK(m.connections("D").empty());
+
+	auto const edges = m.edges("A", "B");
+	REQUIRE(edges.size() == 3);
+	CHECK_FALSE(edges[0]->is_weighted());
+	CHECK(edges[1]->get_weight() == 1);
+	CHECK(edges[2]->get_weight() == 3);
+
+	auto it = m.find("A", "B", 3);
+	REQUIRE(it != m.end());
+	CHECK((*it).from == "A");
+	CHECK((*it).to == "B");
+	CHECK((*it).weight == 3);
+	CHECK(m.find("A", "B") != m.end());
+	CHECK(m.find("A", "B", 2) == m.end());
+	CHECK(m.find("A", "E") == m.end());
+
+	CHECK_THROWS_WITH(m.connections("E"),
+	                  "Cannot call gdwg::mapped_graph<N, E>::connections if src doesn't exist in the graph");
+	CHECK(m.thaw() == g);
+	std::remove(path.c_str());
+}
+TEST_CASE("load_binary: iteration matches the source graph in both directions") {
+	auto g = gdwg::graph<int, double>{};
+	for (auto i = 0; i < 300; ++i) {
+		g.insert_node(i * 3 - 100);
+	}
+	for (auto i = 0; i < 300; ++i) {
+		g.insert_edge(i * 3 - 100, ((i * 37) % 300) * 3 - 100, i * 0.5);
+		if (i % 4 == 0) {
+			g.insert_edge(i * 3 - 100, ((i * 11) % 300) * 3 - 100);
+		}
+	}
+	auto const path = std::string("gdwg_mapped_graph_test_ints.bin");
+	gdwg::save_binary(g, path);
+	auto const m = gdwg::load_binary<int, double>(path);
+	auto expected = std::vector<gdwg::graph<int, double>::iterator::value_type>(g.begin(), g.end());
+	auto actual = std::vector<gdwg::graph<int, double>::iterator::value_type>(m.begin(), m.end());
+	REQUIRE(actual.size() == expected.size());
+	for (auto i = std::size_t{0}; i < actual.size(); ++i) {
+		CHECK(actual[i].from == expected[i].from);
+		CHECK(actual[i].to == expected[i].to);
+		CHECK(actual[i].weight == expected[i].weight);
+	}
+	auto it = m.end();
+	for (auto i = expected.size(); i > 0; --i) {
+		--it;
+		CHECK((*it).from == expected[i - 1].from);
+		CHECK((*it).to == expected[i - 1].to);
+	}
+	CHECK(it == m.begin());
+	CHECK(m.thaw() == g);
+	std::remove(path.c_str());
+}
+TEST_CASE("load_binary: rejects files that aren't a snapshot of the graph type") {
+	auto const path = std::string("gdwg_mapped_graph_test_invalid.bin");
+	gdwg::save_binary(make_graph(), path);
+	auto const load_ints = [&path] { return gdwg::load_binary<int, int>(path); };
+	auto const load_doubles = [&path] { return gdwg::load_binary<std::string, double>(path); };
+	CHECK_THROWS_WITH(load_ints(),
+	                  "Cannot call gdwg::load_binary on " + path + ", it isn't a snapshot of this graph type");
+	CHECK_THROWS_AS(load_doubles(), std::runtime_error);
+
+	// a truncated snapshot fails the size check rather than reading past the mapping
+	auto const load = [&path] { return gdwg::load_binary<std::string, int>(path); };
+	std::ofstream(path) << "GDWGSNAP";
+	CHECK_THROWS_AS(load(), std::runtime_error);
+	std::remove(path.c_str());
+	CHECK_THROWS_AS(load(), std::runtime_error);
+}
+TEST_CASE("load_binary: rejects snapshots whose sections point outside themselves") {
+	auto const path = std::string("gdwg_mapped_graph_test_corrupt.bin");
+	auto const load = [&path] { return gdwg::load_binary<std::string, int>(path); };
+	gdwg::save_binary(make_graph(), path);
+	REQUIRE(load().edge_count() == 6);
+	auto header = gdwg::detail::snapshot_header();
+	std::ifstream(path, std::ios::binary).read(reinterpret_cast<char*>(&header), sizeof(header));
+	// saves a fresh snapshot and overwrites the 8 bytes at offset with value
+	auto const corrupt = [&path](std::uint64_t offset, std::uint64_t value) {
+		gdwg::save_binary(make_graph(), path);
+		auto file = std::fstream(path, std::ios::in | std::ios::out | std::ios::binary);
+		file.seekp(static_cast<std::streamoff>(offset));
+		file.write(reinterpret_cast<char const*>(&value), sizeof(value));
+	};
+
+	// edge offsets that go backwards, a record pointing past the last node and name offsets out of order
+	corrupt(header.offsets_at + sizeof(std::uint64_t), 5);
+	CHECK_THROWS_WITH(load(),
+	                  "Cannot call gdwg::load_binary on " + path + ", it isn't a snapshot of this graph type");
+	corrupt(header.records_at, 4);
+	CHECK_THROWS_AS(load(), std::runtime_error);
+	corrupt(header.nodes_at + 2 * sizeof(std::uint64_t), 0);
+	CHECK_THROWS_AS(load(), std::runtime_error);
+	std::remove(path.c_str());
+}
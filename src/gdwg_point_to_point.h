@@ -0,0 +1,353 @@
+#ifndef GDWG_POINT_TO_POINT_H
+#define GDWG_POINT_TO_POINT_H
+#include "gdwg_shortest_paths.h"
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+namespace gdwg {
+	// Searches for a single (src, dst) pair that settle fewer nodes than shortest_path. Like it they
+	// return std::nullopt when dst can't be reached, and report their work through the trees'
+	// settled_count().
+
+	// Dijkstra forward from src and backward from dst over the in-edge index, so g must track
+	// in-edges. The searches take turns by smallest key and stop once no shorter path can meet.
+	template<typename N, typename E>
+	    requires std::is_arithmetic_v<E>
+	auto bidirectional_shortest_path(graph<N, E> const& g,
+	                                 N const& src,
+	                                 N const& dst,
+	                                 shortest_path_tree<E>& forward,
+	                                 shortest_path_tree<E>& backward,
+	                                 shortest_path_options<E> const& options = {})
+	    -> std::optional<shortest_path_result<N, E>>;
+
+	// A* from src, queueing nodes by distance plus heuristic(node), an estimate of the distance on
+	// to dst. The heuristic must be consistent: never more than an edge's cost plus the estimate
+	// at its head, and zero at dst. It is then a lower bound and the path found is shortest.
+	template<typename N, typename E, typename Heuristic>
+	    requires std::is_arithmetic_v<E> and std::regular_invocable<Heuristic const&, N const&>
+	auto astar_shortest_path(graph<N, E> const& g,
+	                         N const& src,
+	                         N const& dst,
+	                         Heuristic const& heuristic,
+	                         shortest_path_tree<E>& tree,
+	                         shortest_path_options<E> const& options = {})
+	    -> std::optional<shortest_path_result<N, E>>;
+
+	// Distance tables to and from a few landmark nodes, whose triangle inequalities give the lower
+	// bounds alt_shortest_path uses as its A* heuristic. Building them runs two full searches per
+	// landmark, the backward one over the in-edge index, so g must track in-edges. They describe
+	// g as it was built from, and must be rebuilt after g changes.
+	template<typename N, typename E>
+	    requires std::is_arithmetic_v<E>
+	class landmarks {
+	 public:
+		// count landmarks chosen far apart: each next one is the node farthest from those so far
+		landmarks(graph<N, E> const& g, std::size_t count, shortest_path_options<E> const& options = {});
+		// the given landmark nodes
+		landmarks(graph<N, E> const& g, std::vector<N> const& nodes, shortest_path_options<E> const& options = {});
+
+		// the landmark node ids, in the order chosen
+		[[nodiscard]] auto ids() const noexcept -> std::vector<std::uint32_t> const&;
+		[[nodiscard]] auto options() const noexcept -> shortest_path_options<E> const&;
+		// a lower bound on the distance from id to target, both below the id_bound of the graph
+		[[nodiscard]] auto lower_bound(std::size_t id, std::size_t target) const noexcept -> E;
+
+	 private:
+		static constexpr auto unreached = std::numeric_limits<E>::max();
+
+		shortest_path_options<E> options_;
+		std::size_t id_bound_ = 0;
+		std::vector<std::uint32_t> ids_;
+		// landmark-major tables of d(landmark, id) and d(id, landmark), unreached where no path exists
+		std::vector<E> from_;
+		std::vector<E> to_;
+
+		auto add(graph<N, E> const& g, std::uint32_t landmark, shortest_path_tree<E>& tree) -> void;
+
+		template<typename Node, typename Edge>
+		    requires std::is_arithmetic_v<Edge>
+		friend auto alt_shortest_path(graph<Node, Edge> const& g,
+		                              Node const& src,
+		                              Node const& dst,
+		                              landmarks<Node, Edge> const& tables,
+		                              shortest_path_tree<Edge>& tree)
+		    -> std::optional<shortest_path_result<Node, Edge>>;
+	};
+
+	// A* with the landmark lower bounds (ALT), edges costing what they did when tables were built
+	template<typename N, typename E>
+	    requires std::is_arithmetic_v<E>
+	auto alt_shortest_path(graph<N, E> const& g,
+	                       N const& src,
+	                       N const& dst,
+	                       landmarks<N, E> const& tables,
+	                       shortest_path_tree<E>& tree) -> std::optional<shortest_path_result<N, E>>;
+
+	namespace detail {
+		// A* from src until dst is settled, by a potential over node ids
+		template<typename N, typename E, typename Potential>
+		auto astar(graph<N, E> const& g,
+		           std::uint32_t src,
+		           std::uint32_t dst,
+		           shortest_path_tree<E>& tree,
+		           shortest_path_options<E> const& options,
+		           Potential const& potential) -> std::optional<shortest_path_result<N, E>>;
+	} // namespace detail
+} // namespace gdwg
+
+template<typename N, typename E>
+    requires std::is_arithmetic_v<E>
+auto gdwg::bidirectional_shortest_path(graph<N, E> const& g,
+                                       N const& src,
+                                       N const& dst,
+                                       shortest_path_tree<E>& forward,
+                                       shortest_path_tree<E>& backward,
+                                       shortest_path_options<E> const& options)
+    -> std::optional<shortest_path_result<N, E>> {
+	if (not g.is_node(src) or not g.is_node(dst)) {
+		throw std::runtime_error("Cannot call gdwg::bidirectional_shortest_path if src or dst node don't exist in the "
+		                         "graph");
+	}
+	if (not g.tracks_in_edges()) {
+		throw std::runtime_error("Cannot call gdwg::bidirectional_shortest_path on a graph that doesn't track "
+		                         "in-edges");
+	}
+	using search = detail::tree_search;
+	auto constexpr no_node = shortest_path_tree<E>::no_node;
+	auto const s = g.id_of(src);
+	auto const t = g.id_of(dst);
+	search::start(forward, g.id_bound(), s, E{});
+	search::start(backward, g.id_bound(), t, E{});
+	// the shortest path met so far runs s ~> meet_from -> meet_to ~> t
+	auto best = std::optional<E>();
+	auto meet_from = s;
+	auto meet_to = no_node;
+	if (s == t) {
+		best = E{};
+	}
+	// Once either search runs dry it has scanned every edge of its side of a shortest path, one of
+	// which reached a node the other search labelled, so best is final
+	while (not search::empty(forward) and not search::empty(backward)) {
+		auto const forward_key = search::top(forward);
+		auto const backward_key = search::top(backward);
+		if (best and not(forward_key + backward_key < *best)) {
+			break;
+		}
+		if (not(backward_key < forward_key)) {
+			auto const id = search::pop(forward);
+			detail::expand(forward, id, g.out_records(id), options, detail::zero_potential{});
+			auto const base = forward.distance(id);
+			for (auto const& edge : g.out_records(id)) {
+				if (backward.reached(edge.dst)) {
+					auto const cost = edge.weight ? *edge.weight : options.unweighted_cost;
+					auto const length = static_cast<E>(base + cost + backward.distance(edge.dst));
+					if (not best or length < *best) {
+						best = length;
+						meet_from = id;
+						meet_to = edge.dst;
+					}
+				}
+			}
+		}
+		else {
+			auto const id = search::pop(backward);
+			detail::expand(backward, id, g.in_records(id), options, detail::zero_potential{});
+			auto const base = backward.distance(id);
+			for (auto const& edge : g.in_records(id)) {
+				if (forward.reached(edge.dst)) {
+					auto const cost = edge.weight ? *edge.weight : options.unweighted_cost;
+					auto const length = static_cast<E>(forward.distance(edge.dst) + cost + base);
+					if (not best or length < *best) {
+						best = length;
+						meet_from = edge.dst;
+						meet_to = id;
+					}
+				}
+			}
+		}
+	}
+	if (not best) {
+		return std::nullopt;
+	}
+	auto result = detail::path_to(g, forward, meet_from);
+	result.distance = *best;
+	// the backward tree's predecessors lead on towards t
+	for (auto id = meet_to; id != no_node; id = backward.predecessor(id)) {
+		result.nodes.push_back(g.node_at(id));
+	}
+	return result;
+}
+
+template<typename N, typename E, typename Potential>
+auto gdwg::detail::astar(graph<N, E> const& g,
+                         std::uint32_t src,
+                         std::uint32_t dst,
+                         shortest_path_tree<E>& tree,
+                         shortest_path_options<E> const& options,
+                         Potential const& potential) -> std::optional<shortest_path_result<N, E>> {
+	tree_search::start(tree, g.id_bound(), src, potential(src));
+	while (not tree_search::empty(tree)) {
+		auto const id = tree_search::pop(tree);
+		if (id == dst) {
+			return detail::path_to(g, tree, dst);
+		}
+		detail::expand(tree, id, g.out_records(id), options, potential);
+	}
+	return std::nullopt;
+}
+template<typename N, typename E, typename Heuristic>
+    requires std::is_arithmetic_v<E> and std::regular_invocable<Heuristic const&, N const&>
+auto gdwg::astar_shortest_path(graph<N, E> const& g,
+                               N const& src,
+                               N const& dst,
+                               Heuristic const& heuristic,
+                               shortest_path_tree<E>& tree,
+                               shortest_path_options<E> const& options) -> std::optional<shortest_path_result<N, E>> {
+	if (not g.is_node(src) or not g.is_node(dst)) {
+		throw std::runtime_error("Cannot call gdwg::astar_shortest_path if src or dst node don't exist in the graph");
+	}
+	return detail::astar(g, g.id_of(src), g.id_of(dst), tree, options, [&](std::uint32_t id) {
+		return static_cast<E>(heuristic(g.node_at(id)));
+	});
+}
+
+template<typename N, typename E>
+    requires std::is_arithmetic_v<E>
+gdwg::landmarks<N, E>::landmarks(graph<N, E> const& g, std::size_t count, shortest_path_options<E> const& options)
+: options_(options)
+, id_bound_(g.id_bound()) {
+	if (not g.tracks_in_edges()) {
+		throw std::runtime_error("Cannot call gdwg::landmarks<N, E>::landmarks on a graph that doesn't track "
+		                         "in-edges");
+	}
+	auto const nodes = g.nodes();
+	if (nodes.empty() or count == 0) {
+		return;
+	}
+	auto tree = shortest_path_tree<E>();
+	// the first landmark is the node farthest from an arbitrary one
+	auto const start = g.id_of(nodes.front());
+	detail::dijkstra(g, start, tree, options_, [](std::uint32_t) { return false; });
+	auto farthest = start;
+	for (auto id = std::uint32_t{0}; id < id_bound_; ++id) {
+		if (tree.reached(id) and tree.distance(farthest) < tree.distance(id)) {
+			farthest = id;
+		}
+	}
+	add(g, farthest, tree);
+	// then the node whose nearest landmark is farthest away, among those some landmark reaches
+	while (ids_.size() < count) {
+		auto next = std::optional<std::uint32_t>();
+		auto next_distance = E{};
+		for (auto id = std::uint32_t{0}; id < id_bound_; ++id) {
+			auto nearest = unreached;
+			for (auto l = std::size_t{0}; l < ids_.size(); ++l) {
+				nearest = std::min(nearest, from_[l * id_bound_ + id]);
+			}
+			if (nearest != unreached and next_distance < nearest) {
+				next = id;
+				next_distance = nearest;
+			}
+		}
+		// every node reached is a landmark or no farther than one
+		if (not next) {
+			break;
+		}
+		add(g, *next, tree);
+	}
+}
+template<typename N, typename E>
+    requires std::is_arithmetic_v<E>
+gdwg::landmarks<N, E>::landmarks(graph<N, E> const& g,
+                                 std::vector<N> const& nodes,
+                                 shortest_path_options<E> const& options)
+: options_(options)
+, id_bound_(g.id_bound()) {
+	if (not g.tracks_in_edges()) {
+		throw std::runtime_error("Cannot call gdwg::landmarks<N, E>::landmarks on a graph that doesn't track "
+		                         "in-edges");
+	}
+	for (auto const& node : nodes) {
+		if (not g.is_node(node)) {
+			throw std::runtime_error("Cannot call gdwg::landmarks<N, E>::landmarks with a landmark that doesn't exist "
+			                         "in the graph");
+		}
+	}
+	auto tree = shortest_path_tree<E>();
+	for (auto const& node : nodes) {
+		add(g, g.id_of(node), tree);
+	}
+}
+template<typename N, typename E>
+    requires std::is_arithmetic_v<E>
+auto gdwg::landmarks<N, E>::ids() const noexcept -> std::vector<std::uint32_t> const& {
+	return ids_;
+}
+template<typename N, typename E>
+    requires std::is_arithmetic_v<E>
+auto gdwg::landmarks<N, E>::options() const noexcept -> shortest_path_options<E> const& {
+	return options_;
+}
+template<typename N, typename E>
+    requires std::is_arithmetic_v<E>
+auto gdwg::landmarks<N, E>::lower_bound(std::size_t id, std::size_t target) const noexcept -> E {
+	auto bound = E{};
+	for (auto l = std::size_t{0}; l < ids_.size(); ++l) {
+		auto const row = l * id_bound_;
+		// d(l, target) <= d(l, id) + d(id, target)
+		auto const from_id = from_[row + id];
+		auto const from_target = from_[row + target];
+		if (from_id != unreached and from_target != unreached and from_id < from_target) {
+			bound = std::max(bound, static_cast<E>(from_target - from_id));
+		}
+		// d(id, l) <= d(id, target) + d(target, l)
+		auto const to_id = to_[row + id];
+		auto const to_target = to_[row + target];
+		if (to_id != unreached and to_target != unreached and to_target < to_id) {
+			bound = std::max(bound, static_cast<E>(to_id - to_target));
+		}
+	}
+	return bound;
+}
+template<typename N, typename E>
+    requires std::is_arithmetic_v<E>
+auto gdwg::landmarks<N, E>::add(graph<N, E> const& g, std::uint32_t landmark, shortest_path_tree<E>& tree) -> void {
+	auto const never = [](std::uint32_t) { return false; };
+	auto const copy_into = [&](std::vector<E>& table) {
+		for (auto id = std::uint32_t{0}; id < id_bound_; ++id) {
+			table.push_back(tree.reached(id) ? tree.distance(id) : unreached);
+		}
+	};
+	ids_.push_back(landmark);
+	detail::dijkstra(g, landmark, tree, options_, never);
+	copy_into(from_);
+	detail::dijkstra<true>(g, landmark, tree, options_, never);
+	copy_into(to_);
+}
+
+template<typename N, typename E>
+    requires std::is_arithmetic_v<E>
+auto gdwg::alt_shortest_path(graph<N, E> const& g,
+                             N const& src,
+                             N const& dst,
+                             landmarks<N, E> const& tables,
+                             shortest_path_tree<E>& tree) -> std::optional<shortest_path_result<N, E>> {
+	if (not g.is_node(src) or not g.is_node(dst)) {
+		throw std::runtime_error("Cannot call gdwg::alt_shortest_path if src or dst node don't exist in the graph");
+	}
+	if (g.id_bound() != tables.id_bound_) {
+		throw std::runtime_error("Cannot call gdwg::alt_shortest_path with landmarks built from another graph");
+	}
+	auto const target = g.id_of(dst);
+	return detail::astar(g, g.id_of(src), target, tree, tables.options_, [&](std::uint32_t id) {
+		return tables.lower_bound(id, target);
+	});
+}
+#endif // GDWG_POINT_TO_POINT_H
@@ -0,0 +1,145 @@
+#include "gdwg_point_to_point.h"
+#include "gdwg_test_graphs.h"
+
+#include <catch2/catch.hpp>
+
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+TEST_CASE("point to point searches agree with shortest_path on random graphs") {
+	auto rng = std::mt19937(11);
+	auto dijkstra = gdwg::shortest_path_tree<int>();
+	auto forward = gdwg::shortest_path_tree<int>();
+	auto backward = gdwg::shortest_path_tree<int>();
+	for (auto const nodes : {40, 200}) {
+		auto g = gdwg::test::random_graph(nodes, nodes * 3, 30, static_cast<unsigned>(nodes));
+		g.track_in_edges(true);
+		g.erase_node(2);
+		auto node = std::uniform_int_distribution<int>(0, nodes - 1);
+		auto const options = gdwg::shortest_path_options<int>{.unweighted_cost = 3};
+		auto const tables = gdwg::landmarks<int, int>(g, 4, options);
+		CHECK(tables.ids().size() == 4);
+		for (auto query = 0; query < 100; ++query) {
+			auto const src = node(rng) * 2;
+			auto const dst = node(rng) * 2;
+			if (not g.is_node(src) or not g.is_node(dst)) {
+				continue;
+			}
+			auto const expected = gdwg::shortest_path(g, src, dst, dijkstra, options);
+			auto const bidirectional = gdwg::bidirectional_shortest_path(g, src, dst, forward, backward, options);
+			auto const zero = [](int) { return 0; };
+			auto const astar = gdwg::astar_shortest_path(g, src, dst, zero, forward, options);
+			auto const alt = gdwg::alt_shortest_path(g, src, dst, tables, backward);
+			REQUIRE(bidirectional.has_value() == expected.has_value());
+			REQUIRE(astar.has_value() == expected.has_value());
+			REQUIRE(alt.has_value() == expected.has_value());
+			if (not expected) {
+				continue;
+			}
+			for (auto const* found : {&*bidirectional, &*astar, &*alt}) {
+				CHECK(found->distance == expected->distance);
+				CHECK(found->nodes.front() == src);
+				CHECK(found->nodes.back() == dst);
+				CHECK(gdwg::test::path_cost(g, found->nodes, 3) == expected->distance);
+			}
+			CHECK(tables.lower_bound(g.id_of(src), g.id_of(dst)) <= expected->distance);
+		}
+	}
+}
+TEST_CASE("goal directed searches settle fewer nodes on a grid") {
+	// a 30 x 30 grid of (x, y) with edges both ways between neighbours costing 1 to 5
+	using point = std::pair<int, int>;
+	auto constexpr side = 30;
+	auto g = gdwg::graph<point, int>();
+	g.track_in_edges(true);
+	auto rng = std::mt19937(3);
+	auto weight = std::uniform_int_distribution<int>(1, 5);
+	for (auto x = 0; x < side; ++x) {
+		for (auto y = 0; y < side; ++y) {
+			g.insert_node({x, y});
+		}
+	}
+	for (auto x = 0; x < side; ++x) {
+		for (auto y = 0; y < side; ++y) {
+			if (x + 1 < side) {
+				g.insert_edge({x, y}, {x + 1, y}, weight(rng));
+				g.insert_edge({x + 1, y}, {x, y}, weight(rng));
+			}
+			if (y + 1 < side) {
+				g.insert_edge({x, y}, {x, y + 1}, weight(rng));
+				g.insert_edge({x, y + 1}, {x, y}, weight(rng));
+			}
+		}
+	}
+	auto const src = point{2, 3};
+	auto const dst = point{25, 20};
+	auto dijkstra = gdwg::shortest_path_tree<int>();
+	auto const expected = gdwg::shortest_path(g, src, dst, dijkstra);
+	REQUIRE(expected);
+
+	auto forward = gdwg::shortest_path_tree<int>();
+	auto backward = gdwg::shortest_path_tree<int>();
+	auto const bidirectional = gdwg::bidirectional_shortest_path(g, src, dst, forward, backward);
+	REQUIRE(bidirectional);
+	CHECK(bidirectional->distance == expected->distance);
+	CHECK(forward.settled_count() + backward.settled_count() < dijkstra.settled_count());
+
+	// every edge costs at least 1, so the manhattan distance never overestimates
+	auto const manhattan = [&](point const& p) {
+		return std::abs(p.first - dst.first) + std::abs(p.second - dst.second);
+	};
+	auto astar = gdwg::shortest_path_tree<int>();
+	auto const guided = gdwg::astar_shortest_path(g, src, dst, manhattan, astar);
+	REQUIRE(guided);
+	CHECK(guided->distance == expected->distance);
+	CHECK(astar.settled_count() < dijkstra.settled_count());
+
+	auto const corners = gdwg::landmarks<point, int>(g, std::vector<point>{{0, 0}, {side - 1, side - 1}});
+	CHECK(corners.ids() == std::vector<std::uint32_t>{g.id_of({0, 0}), g.id_of({side - 1, side - 1})});
+	auto alt = gdwg::shortest_path_tree<int>();
+	auto const landmarked = gdwg::alt_shortest_path(g, src, dst, corners, alt);
+	REQUIRE(landmarked);
+	CHECK(landmarked->distance == expected->distance);
+	CHECK(alt.settled_count() < dijkstra.settled_count());
+	CHECK(corners.lower_bound(g.id_of(dst), g.id_of(dst)) == 0);
+}
+TEST_CASE("point to point searches check their arguments") {
+	auto g = gdwg::graph<std::string, int>{"a", "b", "c"};
+	g.insert_edge("a", "b", 2);
+	g.insert_edge("b", "c", 2);
+	auto forward = gdwg::shortest_path_tree<int>();
+	auto backward = gdwg::shortest_path_tree<int>();
+	auto const a = std::string("a");
+	auto const c = std::string("c");
+	CHECK_THROWS_WITH(gdwg::bidirectional_shortest_path(g, a, c, forward, backward),
+	                  "Cannot call gdwg::bidirectional_shortest_path on a graph that doesn't track in-edges");
+	auto const build = [&] { return gdwg::landmarks<std::string, int>(g, 2); };
+	CHECK_THROWS_WITH(build(),
+	                  "Cannot call gdwg::landmarks<N, E>::landmarks on a graph that doesn't track in-edges");
+	g.track_in_edges(true);
+	auto const missing = std::string("d");
+	CHECK_THROWS_WITH(gdwg::bidirectional_shortest_path(g, a, missing, forward, backward),
+	                  "Cannot call gdwg::bidirectional_shortest_path if src or dst node don't exist in the graph");
+	auto const unit = [](std::string const&) { return 0; };
+	CHECK_THROWS_WITH(gdwg::astar_shortest_path(g, missing, c, unit, forward),
+	                  "Cannot call gdwg::astar_shortest_path if src or dst node don't exist in the graph");
+
+	auto const self = gdwg::bidirectional_shortest_path(g, a, a, forward, backward);
+	REQUIRE(self);
+	CHECK(self->distance == 0);
+	CHECK(self->nodes == std::vector<std::string>{"a"});
+	CHECK_FALSE(gdwg::bidirectional_shortest_path(g, c, a, forward, backward));
+
+	auto const tables = gdwg::landmarks<std::string, int>(g, 5);
+	// c is the farthest from a, then every node is reached from c or no farther from it than a
+	CHECK(tables.ids().size() <= 3);
+	auto const path = gdwg::alt_shortest_path(g, a, c, tables, forward);
+	REQUIRE(path);
+	CHECK(path->nodes == std::vector<std::string>{"a", "b", "c"});
+	g.insert_node("d");
+	CHECK_THROWS_WITH(gdwg::alt_shortest_path(g, a, c, tables, forward),
+	                  "Cannot call gdwg::alt_shortest_path with landmarks built from another graph");
+}
@@ -0,0 +1,788 @@
+#ifndef GDWG_RCU_GRAPH_H
+#define GDWG_RCU_GRAPH_H
+#include "gdwg_graph.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <forward_list>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+namespace gdwg {
+	namespace detail {
+		// Epoch-based reclamation shared by every rcu_graph. A pinned thread publishes the epoch it
+		// was pinned in; memory retired in an epoch is freed once every pinned thread was pinned in a
+		// later one. Pinning is a load, a store and a fence, never a lock or read-modify-write.
+		class epoch_domain {
+		 public:
+			[[nodiscard]] static auto instance() -> epoch_domain&;
+
+			// pins nest, only the outermost one publishes an epoch
+			auto pin() -> void;
+			auto unpin() -> void;
+			// starts the next epoch, returning the one that ended
+			auto advance() noexcept -> std::uint64_t;
+			// the earliest epoch a pinned thread may be in, the maximum when none is pinned
+			[[nodiscard]] auto oldest_pinned() -> std::uint64_t;
+
+		 private:
+			struct alignas(64) thread_record {
+				std::atomic<std::uint64_t> pinned = 0;
+				// only the owning thread reads or writes depth
+				std::size_t depth = 0;
+				bool in_use = true;
+			};
+			// a thread's claim on a record, given back when the thread exits
+			struct registration {
+				epoch_domain* domain;
+				thread_record* record;
+				explicit registration(epoch_domain& owner);
+				registration(registration const&) = delete;
+				auto operator=(registration const&) -> registration& = delete;
+				~registration();
+			};
+
+			std::atomic<std::uint64_t> epoch_ = 1;
+			std::mutex mutex_;
+			// records never move, so a pinned thread can keep using its own without the mutex
+			std::forward_list<thread_record> records_;
+
+			[[nodiscard]] auto record() -> thread_record&;
+		};
+	} // namespace detail
+
+	// A graph whose readers take no locks. A writer builds a new version of the buckets it changes,
+	// sharing the rest with the current version, and publishes it with one atomic store. A reader
+	// sees the version that was current when it was opened until it is destroyed, and the buckets
+	// writers replace are freed once no reader can still hold them. Writers are serialised.
+	//
+	// Buckets hang off a persistent 64-way trie indexed by node slot, so a writer copies one bucket
+	// and a path of trie nodes per change. The sorted node table is shared between versions and
+	// copied when a node is inserted or erased; build large graphs with the graph constructor.
+	template<typename N, typename E>
+	class rcu_graph {
+		struct version;
+
+	 public:
+		using edge = gdwg::edge<N, E>;
+
+		// A consistent read-only view of one published version. Opening one pins the calling
+		// thread, so it must be destroyed on the thread that opened it.
+		class reader {
+		 public:
+			class iterator {
+			 public:
+				using value_type = typename graph<N, E>::iterator::value_type;
+				using reference = const value_type;
+				using pointer = void;
+				using difference_type = std::ptrdiff_t;
+				using iterator_category = std::bidirectional_iterator_tag;
+
+				iterator() = default;
+				auto operator*() const -> const reference;
+				auto operator++() -> iterator&;
+				auto operator++(int) -> iterator;
+				auto operator--() -> iterator&;
+				auto operator--(int) -> iterator;
+				auto operator==(iterator const& other) const -> bool;
+
+			 private:
+				const reader* r = nullptr;
+				std::size_t node = 0;
+				std::size_t pos = 0;
+				iterator(const reader* view, std::size_t node, std::size_t pos);
+
+				friend class reader;
+			};
+
+			reader(reader const&) = delete;
+			auto operator=(reader const&) -> reader& = delete;
+			~reader();
+
+			// copies the version into a mutable graph
+			[[nodiscard]] auto thaw() const -> graph<N, E>;
+
+			[[nodiscard]] auto is_node(N const& value) const noexcept -> bool;
+			[[nodiscard]] auto empty() const noexcept -> bool;
+			[[nodiscard]] auto is_connected(N const& src, N const& dst) const -> bool;
+			[[nodiscard]] auto nodes() const -> std::vector<N>;
+			[[nodiscard]] auto edges(N const& src, N const& dst) const -> std::vector<std::unique_ptr<edge>>;
+			[[nodiscard]] auto find(N const& src, N const& dst, std::optional<E> weight = std::nullopt) const
+			   -> iterator;
+			[[nodiscard]] auto connections(N const& src) const -> std::vector<N>;
+			[[nodiscard]] auto node_count() const noexcept -> std::size_t;
+			[[nodiscard]] auto edge_count() const noexcept -> std::size_t;
+
+			[[nodiscard]] auto begin() const -> iterator;
+			[[nodiscard]] auto end() const -> iterator;
+
+		 private:
+			version const* v_;
+
+			explicit reader(std::atomic<version*> const& published);
+			// the index of value in the node table
+			[[nodiscard]] auto index_of(N const& value) const noexcept -> std::optional<std::size_t>;
+			[[nodiscard]] auto out(std::size_t index) const noexcept
+			   -> std::vector<std::pair<N, std::optional<E>>> const&;
+
+			friend class rcu_graph;
+		};
+
+		rcu_graph();
+		explicit rcu_graph(graph<N, E> const& g);
+		rcu_graph(rcu_graph const&) = delete;
+		auto operator=(rcu_graph const&) -> rcu_graph& = delete;
+		// no reader of this graph may still be open
+		~rcu_graph();
+
+		auto insert_node(N const& value) -> bool;
+		auto insert_edge(N const& src, N const& dst, std::optional<E> weight = std::nullopt) -> bool;
+		// inserts every (src, dst, weight) triple and publishes them as one version
+		template<typename InputIt>
+		auto insert_edges(InputIt first, InputIt last) -> std::size_t;
+		auto erase_node(N const& value) -> bool;
+		auto erase_edge(N const& src, N const& dst, std::optional<E> weight = std::nullopt) -> bool;
+		auto clear() -> void;
+
+		[[nodiscard]] auto read() const -> reader;
+		[[nodiscard]] auto snapshot() const -> graph<N, E>;
+
+	 private:
+		using slot = std::uint32_t;
+		using record = std::pair<N, std::optional<E>>;
+		static constexpr auto fanout_bits = 6U;
+		static constexpr auto fanout = std::size_t{1} << fanout_bits;
+
+		// stamp is the draft that allocated the object, which may change it in place until it is published
+		struct bucket {
+			std::uint64_t stamp;
+			// sorted by (dst, weight), the unweighted edge first
+			std::vector<record> out;
+		};
+		struct trie_node {
+			std::uint64_t stamp;
+			// trie_node children above the last level, bucket children on it
+			std::array<void*, fanout> child;
+		};
+		struct node_table {
+			std::uint64_t stamp;
+			// sorted by value
+			std::vector<std::pair<N, slot>> entries;
+		};
+		struct version {
+			node_table* nodes;
+			// a trie of depth levels, or the bucket of slot 0 when depth is 0
+			void* root;
+			unsigned depth;
+			std::size_t edge_count;
+		};
+		struct retired {
+			void* object;
+			void (*drop)(void*);
+			std::uint64_t epoch;
+		};
+		// retired objects are freed in batches of this many
+		static constexpr auto reclaim_batch = std::size_t{1024};
+
+		std::atomic<version*> current_;
+		std::mutex writer_;
+		// the rest is only touched by the writer holding writer_
+		std::uint64_t stamp_ = 0;
+		// the source slot of every in-edge of each slot, once per edge
+		std::vector<std::vector<slot>> sources_;
+		std::vector<slot> free_slots_;
+		std::vector<retired> pending_;
+		std::vector<retired> retired_;
+
+		template<typename T>
+		static auto drop(void* object) -> void;
+		template<typename T>
+		auto retire(T* object) -> void;
+		// frees a trie and its buckets, or retires them when retiring is set
+		auto release(void* link, unsigned level, bool retiring) -> void;
+
+		// a copy of the current version that the next stamp may change in place
+		[[nodiscard]] auto draft() -> std::unique_ptr<version>;
+		auto publish(std::unique_ptr<version> next) -> void;
+		auto reclaim() -> void;
+
+		[[nodiscard]] auto mutable_nodes(version& next) -> std::vector<std::pair<N, slot>>&;
+		// the bucket of s in next, copied along with its trie path unless this draft already did
+		[[nodiscard]] auto mutable_bucket(version& next, slot s) -> std::vector<record>&;
+		auto erase_bucket(version& next, slot s) -> void;
+		[[nodiscard]] auto allocate_slot() -> slot;
+		[[nodiscard]] static auto slot_of(version const& v, N const& value) noexcept -> std::optional<slot>;
+		[[nodiscard]] static auto bucket_of(version const& v, slot s) noexcept -> bucket const*;
+	};
+} // namespace gdwg
+
+inline auto gdwg::detail::epoch_domain::instance() -> epoch_domain& {
+	static auto domain = epoch_domain();
+	return domain;
+}
+inline gdwg::detail::epoch_domain::registration::registration(epoch_domain& owner)
+: domain(&owner)
+, record(nullptr) {
+	auto lock = std::lock_guard(owner.mutex_);
+	for (auto& r : owner.records_) {
+		if (not r.in_use) {
+			r.in_use = true;
+			record = &r;
+			return;
+		}
+	}
+	record = &owner.records_.emplace_front();
+}
+inline gdwg::detail::epoch_domain::registration::~registration() {
+	auto lock = std::lock_guard(domain->mutex_);
+	record->in_use = false;
+}
+inline auto gdwg::detail::epoch_domain::record() -> thread_record& {
+	thread_local auto const owned = registration(*this);
+	return *owned.record;
+}
+inline auto gdwg::detail::epoch_domain::pin() -> void {
+	auto& r = record();
+	if (r.depth++ == 0) {
+		// acquiring the epoch makes every version published before it visible
+		r.pinned.store(epoch_.load(std::memory_order_acquire), std::memory_order_relaxed);
+		// and the pin must be visible to writers before anything published is read
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+	}
+}
+inline auto gdwg::detail::epoch_domain::unpin() -> void {
+	auto& r = record();
+	if (--r.depth == 0) {
+		r.pinned.store(0, std::memory_order_release);
+	}
+}
+inline auto gdwg::detail::epoch_domain::advance() noexcept -> std::uint64_t {
+	return epoch_.fetch_add(1, std::memory_order_seq_cst);
+}
+inline auto gdwg::detail::epoch_domain::oldest_pinned() -> std::uint64_t {
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	auto lock = std::lock_guard(mutex_);
+	auto oldest = std::numeric_limits<std::uint64_t>::max();
+	for (auto const& r : records_) {
+		if (auto const pinned = r.pinned.load(std::memory_order_acquire); pinned != 0) {
+			oldest = std::min(oldest, pinned);
+		}
+	}
+	return oldest;
+}
+
+template<typename N, typename E>
+gdwg::rcu_graph<N, E>::reader::iterator::iterator(const reader* view, std::size_t node, std::size_t pos)
+: r(view)
+, node(node)
+, pos(pos) {}
+template<typename N, typename E>
+auto gdwg::rcu_graph<N, E>::reader::iterator::operator*() const -> const reference {
+	auto const& [dst, weight] = r->out(node)[pos];
+	return reference{r->v_->nodes->entries[node].first, dst, weight};
+}
+template<typename N, typename E>
+auto gdwg::rcu_graph<N, E>::reader::iterator::operator++() -> iterator& {
+	++pos;
+	auto const count = r->v_->nodes->entries.size();
+	while (node < count and pos >= r->out(node).size()) {
+		++node;
+		pos = 0;
+	}
+	return *this;
+}
+template<typename N, typename E>
+auto gdwg::rcu_graph<N, E>::reader::iterator::operator++(int) -> iterator {
+	auto temp = *this;
+	++(*this);
+	return temp;
+}
+template<typename N, typename E>
+auto gdwg::rcu_graph<N, E>::reader::iterator::operator--() -> iterator& {
+	while (pos == 0) {
+		--node;
+		pos = r->out(node).size();
+	}
+	--pos;
+	return *this;
+}
+template<typename N, typename E>
+auto gdwg::rcu_graph<N, E>::reader::iterator::operator--(int) -> iterator {
+	auto temp = *this;
+	--(*this);
+	return temp;
+}
+template<typename N, typename E>
+auto gdwg::rcu_graph<N, E>::reader::iterator::operator==(iterator const& other) const -> bool {
+	return r == other.r and node == other.node and pos == other.pos;
+}
+
+template<typename N, typename E>
+gdwg::rcu_graph<N, E>::reader::reader(std::atomic<version*> const& published) {
+	detail::epoch_domain::instance().pin();
+	v_ = published.load(std::memory_order_acquire);
+}
+template<typename N, typename E>
+gdwg::rcu_graph<N, E>::reader::~reader() {
+	detail::epoch_domain::instance().unpin();
+}
+template<typename N, typename E>
+auto gdwg::rcu_graph<N, E>::reader::index_of(N const& value) const noexcept -> std::optional<std::size_t> {
+	auto const& entries = v_->nodes->entries;
+	auto it = std::lower_bound(entries.begin(), entries.end(), value, [](auto const& e, N const& v) {
+		return e.first < v;
+	});
+	if (it == entries.end() or it->first != value) {
+		return std::nullopt;
+	}
+	return static_cast<std::size_t>(it - entries.begin());
+}
+template<typename N, typename E>
+auto gdwg::rcu_graph<N, E>::reader::out(std::size_t index) const noexcept
+   -> std::vector<std::pair<N, std::optional<E>>> const& {
+	static auto const none = std::vector<record>();
+	auto const* b = bucket_of(*v_, v_->nodes->entries[index].second);
+	return b == nullptr ? none : b->out;
+}
+template<typename N, typename E>
+auto gdwg::rcu_graph<N, E>::reader::thaw() const -> graph<N, E> {
+	auto values = nodes();
+	auto g = graph<N, E>(values.begin(), values.end());
+	auto triples = std::vector<std::tuple<N, N, std::optional<E>>>();
+	triples.reserve(edge_count());
+	for (auto const& [from, to, weight] : *this) {
+		triples.emplace_back(from, to, weight);
+	}
+	g.insert_edges(triples.begin(), triples.end());
+	return g;
+}
+template<typename N, typename E>
+auto gdwg::rcu_graph<N, E>::reader::is_node(N const& value) const noexcept -> bool {
+	return index_of(value).has_value();
+}
+template<typename N, typename E>
+auto gdwg::rcu_graph<N, E>::reader::empty() const noexcept -> bool {
+	return v_->nodes->entries.empty();
+}
+template<typename N, typename E>
+auto gdwg::rcu_graph<N, E>::reader::is_connected(N const& src, N const& dst) const -> bool {
+	auto const s = index_of(src);
+	if (not s or not is_node(dst)) {
+		throw std::runtime_error("Cannot call gdwg::rcu_graph<N, E>::reader::is_connected if src or dst node don't "
+		                         "exist in the graph");
+	}
+	auto const& o = out(*s);
+	auto it = std::lower_bound(o.begin(), o.end(), dst, [](auto const& r, N const& v) { return r.first < v; });
+	return it != o.end() and it->first == dst;
+}
+template<typename N, typename E>
+auto gdwg::rcu_graph<N, E>::reader::nodes() const -> std::vector<N> {
+	auto result = std::vector<N>();
+	result.reserve(node_count());
+	for (auto const& entry : v_->nodes->entries) {
+		result.push_back(entry.first);
+	}
+	return result;
+}
+template<typename N, typename E>
+auto gdwg::rcu_graph<N, E>::reader::edges(N const& src, N const& dst) const -> std::vector<std::unique_ptr<edge>> {
+	auto const s = index_of(src);
+	if (not s or not is_node(dst)) {
+		throw std::runtime_error("Cannot call gdwg::rcu_graph<N, E>::reader::edges if src or dst node don't exist in "
+		                         "the graph");
+	}
+	auto result = std::vector<std::unique_ptr<edge>>();
+	auto const& o = out(*s);
+	auto it = std::lower_bound(o.begin(), o.end(), dst, [](auto const& r, N const& v) { return r.first < v; });
+	for (; it != o.end() and it->first == dst; ++it) {
+		if (it->second) {
+			result.push_back(std::make_unique<weighted_edge<N, E>>(src, dst, *it->second));
+		}
+		else {
+			result.push_back(std::make_unique<unweighted_edge<N, E>>(src, dst));
+		}
+	}
+	return result;
+}
+template<typename N, typename E>
+auto gdwg::rcu_graph<N, E>::reader::find(N const& src, N const& dst, std::optional<E> weight) const -> iterator {
+	auto const s = index_of(src);
+	if (not s) {
+		return end();
+	}
+	auto const& o = out(*s);
+	auto const target = record(dst, weight);
+	auto it = std::lower_bound(o.begin(), o.end(), target);
+	if (it == o.end() or *it != target) {
+		return end();
+	}
+	return iterator(this, *s, static_cast<std::size_t>(it - o.begin()));
+}
+template<typename N, typename E>
+auto gdwg::rcu_graph<N, E>::reader::connections(N const& src) const -> std::vector<N> {
+	auto const s = index_of(src);
+	if (not s) {
+		throw std::runtime_error("Cannot call gdwg::rcu_graph<N, E>::reader::connections if src doesn't exist in the "
+		                         "graph");
+	}
+	auto result = std::vector<N>();
+	for (auto const& [dst, weight] : out(*s)) {
+		if (result.empty() or result.back() != dst) {
+			result.push_back(dst);
+		}
+	}
+	return result;
+}
+template<typename N, typename E>
+auto gdwg::rcu_graph<N, E>::reader::node_count() const noexcept -> std::size_t {
+	return v_->nodes->entries.size();
+}
+template<typename N, typename E>
+auto gdwg::rcu_graph<N, E>::reader::edge_count() const noexcept -> std::size_t {
+	return v_->edge_count;
+}
+template<typename N, typename E>
+auto gdwg::rcu_graph<N, E>::reader::begin() const -> iterator {
+	auto it = iterator(this, 0, 0);
+	// position on the first node that owns an edge
+	while (it.node < node_count() and out(it.node).empty()) {
+		++it.node;
+	}
+	return it;
+}
+template<typename N, typename E>
+auto gdwg::rcu_graph<N, E>::reader::end() const -> iterator {
+	return iterator(this, node_count(), 0);
+}
+
+template<typename N, typename E>
+gdwg::rcu_graph<N, E>::rcu_graph()
+: current_(new version{new node_table{0, {}}, nullptr, 0, 0}) {}
+template<typename N, typename E>
+gdwg::rcu_graph<N, E>::rcu_graph(graph<N, E> const& g)
+: rcu_graph() {
+	auto& v = *current_.load(std::memory_order_relaxed);
+	auto& entries = v.nodes->entries;
+	for (auto const& value : g.nodes()) {
+		entries.emplace_back(value, allocate_slot());
+	}
+	// nothing is published yet, so every object may be built in place
+	for (auto const& [from, to, weight] : g) {
+		auto const s = *slot_of(v, from);
+		mutable_bucket(v, s).emplace_back(to, weight);
+		sources_[*slot_of(v, to)].push_back(s);
+		++v.edge_count;
+	}
+}
+template<typename N, typename E>
+gdwg::rcu_graph<N, E>::~rcu_graph() {
+	auto* v = current_.load(std::memory_order_relaxed);
+	release(v->root, v->depth, false);
+	delete v->nodes;
+	delete v;
+	for (auto const& r : retired_) {
+		r.drop(r.object);
+	}
+}
+
+template<typename N, typename E>
+template<typename T>
+auto gdwg::rcu_graph<N, E>::drop(void* object) -> void {
+	delete static_cast<T*>(object);
+}
+template<typename N, typename E>
+template<typename T>
+auto gdwg::rcu_graph<N, E>::retire(T* object) -> void {
+	pending_.push_back(retired{object, &drop<T>, 0});
+}
+template<typename N, typename E>
+auto gdwg::rcu_graph<N, E>::release(void* link, unsigned level, bool retiring) -> void {
+	if (link == nullptr) {
+		return;
+	}
+	if (level == 0) {
+		retiring ? retire(static_cast<bucket*>(link)) : drop<bucket>(link);
+		return;
+	}
+	auto* node = static_cast<trie_node*>(link);
+	for (auto* child : node->child) {
+		release(child, level - 1, retiring);
+	}
+	retiring ? retire(node) : drop<trie_node>(node);
+}
+template<typename N, typename E>
+auto gdwg::rcu_graph<N, E>::draft() -> std::unique_ptr<version> {
+	++stamp_;
+	pending_.clear();
+	return std::make_unique<version>(*current_.load(std::memory_order_relaxed));
+}
+template<typename N, typename E>
+auto gdwg::rcu_graph<N, E>::publish(std::unique_ptr<version> next) -> void {
+	retire(current_.load(std::memory_order_relaxed));
+	current_.store(next.release(), std::memory_order_release);
+	// readers pinned from the next epoch on can only see the new version
+	auto const epoch = detail::epoch_domain::instance().advance();
+	for (auto& r : pending_) {
+		r.epoch = epoch;
+		retired_.push_back(r);
+	}
+	pending_.clear();
+	if (retired_.size() >= reclaim_batch) {
+		reclaim();
+	}
+}
+template<typename N, typename E>
+auto gdwg::rcu_graph<N, E>::reclaim() -> void {
+	auto const oldest = detail::epoch_domain::instance().oldest_pinned();
+	auto freeable = std::partition(retired_.begin(), retired_.end(), [oldest](retired const& r) {
+		return r.epoch >= oldest;
+	});
+	for (auto it = freeable; it != retired_.end(); ++it) {
+		it->drop(it->object);
+	}
+	retired_.erase(freeable, retired_.end());
+}
+template<typename N, typename E>
+auto gdwg::rcu_graph<N, E>::mutable_nodes(version& next) -> std::vector<std::pair<N, slot>>& {
+	if (next.nodes->stamp != stamp_) {
+		retire(next.nodes);
+		next.nodes = new node_table{stamp_, next.nodes->entries};
+	}
+	return next.nodes->entries;
+}
+template<typename N, typename E>
+auto gdwg::rcu_graph<N, E>::mutable_bucket(version& next, slot s) -> std::vector<record>& {
+	// grow the trie until it has room for s, the old root becoming the first child
+	while ((std::uint64_t{s} >> (fanout_bits * next.depth)) != 0) {
+		if (next.root != nullptr) {
+			auto* root = new trie_node{stamp_, {}};
+			root->child[0] = next.root;
+			next.root = root;
+		}
+		++next.depth;
+	}
+	auto* link = &next.root;
+	for (auto level = next.depth; level > 0; --level) {
+		auto* node = static_cast<trie_node*>(*link);
+		if (node == nullptr) {
+			node = new trie_node{stamp_, {}};
+		}
+		else if (node->stamp != stamp_) {
+			retire(node);
+			node = new trie_node{stamp_, node->child};
+		}
+		*link = node;
+		link = &node->child[(s >> (fanout_bits * (level - 1))) & (fanout - 1)];
+	}
+	auto* b = static_cast<bucket*>(*link);
+	if (b == nullptr) {
+		b = new bucket{stamp_, {}};
+	}
+	else if (b->stamp != stamp_) {
+		retire(b);
+		b = new bucket{stamp_, b->out};
+	}
+	*link = b;
+	return b->out;
+}
+template<typename N, typename E>
+auto gdwg::rcu_graph<N, E>::erase_bucket(version& next, slot s) -> void {
+	if (bucket_of(next, s) == nullptr) {
+		return;
+	}
+	static_cast<void>(mutable_bucket(next, s));
+	// the path to s is now this draft's own, so the link can be cleared in place
+	auto* link = &next.root;
+	for (auto level = next.depth; level > 0; --level) {
+		link = &static_cast<trie_node*>(*link)->child[(s >> (fanout_bits * (level - 1))) & (fanout - 1)];
+	}
+	delete static_cast<bucket*>(*link);
+	*link = nullptr;
+}
+template<typename N, typename E>
+auto gdwg::rcu_graph<N, E>::allocate_slot() -> slot {
+	if (not free_slots_.empty()) {
+		auto const s = free_slots_.back();
+		free_slots_.pop_back();
+		return s;
+	}
+	sources_.emplace_back();
+	return static_cast<slot>(sources_.size() - 1);
+}
+template<typename N, typename E>
+auto gdwg::rcu_graph<N, E>::slot_of(version const& v, N const& value) noexcept -> std::optional<slot> {
+	auto const& entries = v.nodes->entries;
+	auto it = std::lower_bound(entries.begin(), entries.end(), value, [](auto const& e, N const& x) {
+		return e.first < x;
+	});
+	if (it == entries.end() or it->first != value) {
+		return std::nullopt;
+	}
+	return it->second;
+}
+template<typename N, typename E>
+auto gdwg::rcu_graph<N, E>::bucket_of(version const& v, slot s) noexcept -> bucket const* {
+	if ((std::uint64_t{s} >> (fanout_bits * v.depth)) != 0) {
+		return nullptr;
+	}
+	void const* link = v.root;
+	for (auto level = v.depth; level > 0 and link != nullptr; --level) {
+		link = static_cast<trie_node const*>(link)->child[(s >> (fanout_bits * (level - 1))) & (fanout - 1)];
+	}
+	return static_cast<bucket const*>(link);
+}
+
+template<typename N, typename E>
+auto gdwg::rcu_graph<N, E>::insert_node(N const& value) -> bool {
+	auto lock = std::lock_guard(writer_);
+	auto const& entries = current_.load(std::memory_order_relaxed)->nodes->entries;
+	auto pos = std::lower_bound(entries.begin(), entries.end(), value, [](auto const& e, N const& v) {
+		return e.first < v;
+	});
+	if (pos != entries.end() and pos->first == value) {
+		return false;
+	}
+	auto const index = pos - entries.begin();
+	auto next = draft();
+	auto& table = mutable_nodes(*next);
+	table.emplace(table.begin() + index, value, allocate_slot());
+	publish(std::move(next));
+	return true;
+}
+template<typename N, typename E>
+auto gdwg::rcu_graph<N, E>::insert_edge(N const& src, N const& dst, std::optional<E> weight) -> bool {
+	auto const triple = std::tuple<N const&, N const&, std::optional<E> const&>(src, dst, weight);
+	return insert_edges(&triple, &triple + 1) == 1;
+}
+template<typename N, typename E>
+template<typename InputIt>
+auto gdwg::rcu_graph<N, E>::insert_edges(InputIt first, InputIt last) -> std::size_t {
+	auto lock = std::lock_guard(writer_);
+	auto const& v = *current_.load(std::memory_order_relaxed);
+	// resolve every triple before drafting, so a missing node leaves the graph as it was
+	auto resolved = std::vector<std::tuple<slot, slot, record>>();
+	for (; first != last; ++first) {
+		auto const& [src, dst, weight] = *first;
+		auto const s = slot_of(v, src);
+		auto const d = slot_of(v, dst);
+		if (not s or not d) {
+			throw std::runtime_error("Cannot call gdwg::rcu_graph<N, E>::insert_edge when either src or dst node "
+			                         "does not exist");
+		}
+		resolved.emplace_back(*s, *d, record(dst, weight));
+	}
+	auto next = draft();
+	auto inserted = std::size_t{0};
+	for (auto& [s, d, r] : resolved) {
+		auto const* b = bucket_of(*next, s);
+		if (b != nullptr and std::binary_search(b->out.begin(), b->out.end(), r)) {
+			continue;
+		}
+		auto& out = mutable_bucket(*next, s);
+		out.insert(std::lower_bound(out.begin(), out.end(), r), std::move(r));
+		sources_[d].push_back(s);
+		++inserted;
+	}
+	if (inserted != 0) {
+		next->edge_count += inserted;
+		publish(std::move(next));
+	}
+	return inserted;
+}
+template<typename N, typename E>
+auto gdwg::rcu_graph<N, E>::erase_node(N const& value) -> bool {
+	auto lock = std::lock_guard(writer_);
+	auto const& v = *current_.load(std::memory_order_relaxed);
+	auto const s = slot_of(v, value);
+	if (not s) {
+		return false;
+	}
+	auto next = draft();
+	auto const drop_source = [this](slot d, slot src) {
+		auto& sources = sources_[d];
+		sources.erase(std::find(sources.begin(), sources.end(), src));
+	};
+	if (auto const* b = bucket_of(v, *s); b != nullptr) {
+		for (auto const& [dst, weight] : b->out) {
+			if (dst != value) {
+				drop_source(*slot_of(v, dst), *s);
+			}
+		}
+		next->edge_count -= b->out.size();
+	}
+	auto sources = std::move(sources_[*s]);
+	std::sort(sources.begin(), sources.end());
+	sources.erase(std::unique(sources.begin(), sources.end()), sources.end());
+	for (auto const src : sources) {
+		if (src == *s) {
+			continue;
+		}
+		auto& out = mutable_bucket(*next, src);
+		auto const size = out.size();
+		out.erase(std::remove_if(out.begin(), out.end(), [&value](record const& r) { return r.first == value; }),
+		          out.end());
+		next->edge_count -= size - out.size();
+	}
+	erase_bucket(*next, *s);
+	auto& table = mutable_nodes(*next);
+	table.erase(std::lower_bound(table.begin(), table.end(), value, [](auto const& e, N const& x) {
+		return e.first < x;
+	}));
+	sources_[*s].clear();
+	free_slots_.push_back(*s);
+	publish(std::move(next));
+	return true;
+}
+template<typename N, typename E>
+auto gdwg::rcu_graph<N, E>::erase_edge(N const& src, N const& dst, std::optional<E> weight) -> bool {
+	auto lock = std::lock_guard(writer_);
+	auto const& v = *current_.load(std::memory_order_relaxed);
+	auto const s = slot_of(v, src);
+	auto const d = slot_of(v, dst);
+	if (not s or not d) {
+		throw std::runtime_error("Cannot call gdwg::rcu_graph<N, E>::erase_edge on src or dst if they don't exist in "
+		                         "the graph");
+	}
+	auto const target = record(dst, weight);
+	auto const* b = bucket_of(v, *s);
+	if (b == nullptr or not std::binary_search(b->out.begin(), b->out.end(), target)) {
+		return false;
+	}
+	auto next = draft();
+	auto& out = mutable_bucket(*next, *s);
+	out.erase(std::lower_bound(out.begin(), out.end(), target));
+	auto& sources = sources_[*d];
+	sources.erase(std::find(sources.begin(), sources.end(), *s));
+	--next->edge_count;
+	publish(std::move(next));
+	return true;
+}
+template<typename N, typename E>
+auto gdwg::rcu_graph<N, E>::clear() -> void {
+	auto lock = std::lock_guard(writer_);
+	auto next = draft();
+	release(next->root, next->depth, true);
+	retire(next->nodes);
+	*next = version{new node_table{stamp_, {}}, nullptr, 0, 0};
+	sources_.clear();
+	free_slots_.clear();
+	publish(std::move(next));
+}
+template<typename N, typename E>
+auto gdwg::rcu_graph<N, E>::read() const -> reader {
+	return reader(current_);
+}
+template<typename N, typename E>
+auto gdwg::rcu_graph<N, E>::snapshot() const -> graph<N, E> {
+	return read().thaw();
+}
+#endif // GDWG_RCU_GRAPH_H
@@ -0,0 +1,162 @@
+#include "gdwg_rcu_graph.h"
+
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+TEST_CASE("rcu_graph: single threaded use matches graph") {
+	auto r = gdwg::rcu_graph<std::string, int>();
+	auto g = gdwg::graph<std::string, int>();
+	CHECK(r.read().empty());
+	for (auto const* n : {"d", "b", "a", "e", "c"}) {
+		CHECK(r.insert_node(n) == g.insert_node(n));
+	}
+	CHECK_FALSE(r.insert_node("a"));
+	auto const edges = std::vector<std::tuple<std::string, std::string, std::optional<int>>>{
+	    {"a", "b", 1}, {"a", "b", std::nullopt}, {"a", "c", 2}, {"b", "a", 3}, {"c", "c", 4},
+	    {"d", "a", 5}, {"e", "b", 6}, {"b", "e", std::nullopt}, {"a", "b", 1},
+	};
+	for (auto const& [src, dst, weight] : edges) {
+		CHECK(r.insert_edge(src, dst, weight) == g.insert_edge(src, dst, weight));
+	}
+	CHECK(r.snapshot() == g);
+	{
+		auto const view = r.read();
+		CHECK(view.node_count() == 5);
+		CHECK(view.edge_count() == 8);
+		CHECK(view.nodes() == g.nodes());
+		CHECK(view.is_connected("a", "b"));
+		CHECK_FALSE(view.is_connected("b", "c"));
+		CHECK(view.connections("a") == g.connections("a"));
+		auto const ab = view.edges("a", "b");
+		REQUIRE(ab.size() == 2);
+		CHECK(ab[0]->print_edge() == g.edges("a", "b")[0]->print_edge());
+		CHECK(ab[1]->print_edge() == g.edges("a", "b")[1]->print_edge());
+
+		auto it = view.find("a", "b", 1);
+		REQUIRE(it != view.end());
+		CHECK((*it).from == "a");
+		CHECK((*it).to == "b");
+		CHECK((*it).weight == 1);
+		CHECK(view.find("a", "b") != view.end());
+		CHECK(view.find("a", "b", 2) == view.end());
+		CHECK(view.find("f", "a") == view.end());
+
+		auto expected = std::vector<std::tuple<std::string, std::string, std::optional<int>>>();
+		for (auto const& [from, to, weight] : g) {
+			expected.emplace_back(from, to, weight);
+		}
+		auto forward = std::vector<std::tuple<std::string, std::string, std::optional<int>>>();
+		for (auto const& [from, to, weight] : view) {
+			forward.emplace_back(from, to, weight);
+		}
+		CHECK(forward == expected);
+		auto backward = view.end();
+		for (auto i = expected.size(); i > 0; --i) {
+			--backward;
+			CHECK((*backward).from == std::get<0>(expected[i - 1]));
+			CHECK((*backward).to == std::get<1>(expected[i - 1]));
+		}
+		CHECK(backward == view.begin());
+		CHECK_THROWS_WITH(view.connections("f"),
+		                  "Cannot call gdwg::rcu_graph<N, E>::reader::connections if src doesn't exist in the graph");
+	}
+
+	CHECK(r.erase_edge("a", "b", 1) == g.erase_edge("a", "b", 1));
+	CHECK_FALSE(r.erase_edge("a", "b", 1));
+	CHECK(r.erase_node("a") == g.erase_node("a"));
+	CHECK_FALSE(r.erase_node("a"));
+	CHECK(r.snapshot() == g);
+	CHECK(r.read().edge_count() == 3);
+	// the freed slot is reused by the next node
+	CHECK(r.insert_node("f") == g.insert_node("f"));
+	CHECK(r.insert_edge("f", "c", 7) == g.insert_edge("f", "c", 7));
+	CHECK(r.snapshot() == g);
+
+	auto const missing = [&r] { return r.insert_edge("a", "f"); };
+	CHECK_THROWS_WITH(missing(),
+	                  "Cannot call gdwg::rcu_graph<N, E>::insert_edge when either src or dst node does not exist");
+	CHECK(r.snapshot() == g);
+	r.clear();
+	auto const cleared = r.read();
+	CHECK(cleared.empty());
+	CHECK(cleared.begin() == cleared.end());
+}
+TEST_CASE("rcu_graph: a reader keeps the version it opened") {
+	auto g = gdwg::graph<int, int>();
+	for (auto i = 0; i < 500; ++i) {
+		g.insert_node(i);
+	}
+	for (auto i = 0; i < 500; ++i) {
+		g.insert_edge(i, (i * 7) % 500, i);
+	}
+	auto r = gdwg::rcu_graph<int, int>(g);
+	CHECK(r.snapshot() == g);
+
+	auto const before = r.read();
+	for (auto i = 1; i < 500; ++i) {
+		r.insert_edge(i, (i * 11) % 500, -i);
+	}
+	r.erase_node(0);
+	r.insert_node(1000);
+	CHECK(before.thaw() == g);
+	CHECK(before.is_node(0));
+	CHECK_FALSE(before.is_node(1000));
+	auto const after = r.read();
+	CHECK_FALSE(after.is_node(0));
+	CHECK(after.is_node(1000));
+	CHECK(after.edge_count() == 998);
+	CHECK(after.find(1, 11, -1) != after.end());
+}
+TEST_CASE("rcu_graph: readers never see half of a published batch") {
+	auto constexpr nodes = 256;
+	auto r = gdwg::rcu_graph<int, int>();
+	for (auto i = 0; i < nodes; ++i) {
+		r.insert_node(i);
+	}
+	auto done = std::atomic<bool>(false);
+	auto readers = std::vector<std::thread>();
+	auto torn = std::atomic<int>(0);
+	for (auto t = 0; t < 3; ++t) {
+		readers.emplace_back([&] {
+			while (not done.load()) {
+				// every batch inserts an edge and its reverse, so each view holds both or neither
+				auto const view = r.read();
+				auto count = std::size_t{0};
+				for (auto const& [from, to, weight] : view) {
+					++count;
+					if (view.find(to, from, weight) == view.end()) {
+						++torn;
+					}
+				}
+				if (count != view.edge_count()) {
+					++torn;
+				}
+			}
+		});
+	}
+	for (auto i = 0; i < 3000; ++i) {
+		auto const src = (i * 7) % nodes;
+		auto const dst = (i * 13 + 1) % nodes;
+		auto const pair = std::vector<std::tuple<int, int, std::optional<int>>>{{src, dst, i}, {dst, src, i}};
+		r.insert_edges(pair.begin(), pair.end());
+		if (i % 4 == 0) {
+			auto const victim = (i * 5) % nodes;
+			r.erase_node(victim);
+			r.insert_node(victim);
+		}
+	}
+	done = true;
+	for (auto& t : readers) {
+		t.join();
+	}
+	CHECK(torn == 0);
+	auto const view = r.read();
+	for (auto const& [from, to, weight] : view) {
+		CHECK(view.find(to, from, weight) != view.end());
+	}
+}
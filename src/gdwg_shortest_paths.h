@@ -0,0 +1,366 @@
+#ifndef GDWG_SHORTEST_PATHS_H
+#define GDWG_SHORTEST_PATHS_H
+#include "gdwg_graph.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+namespace gdwg {
+	template<typename E>
+	struct shortest_path_options {
+		// the cost of an unweighted edge
+		E unweighted_cost = E{1};
+	};
+
+	template<typename N, typename E>
+	struct shortest_path_result {
+		E distance;
+		// src to dst inclusive
+		std::vector<N> nodes;
+	};
+
+	template<typename E>
+	class shortest_path_tree;
+	namespace detail {
+		// the heap and labels of shortest_path_tree, for the searches built on it
+		struct tree_search;
+	} // namespace detail
+
+	// Distances and predecessors by node id from the last search run with this tree, plus the
+	// indexed 4-ary heap the search used. Entries are stamped with a search generation rather than
+	// cleared, so a search costs time for the nodes it reaches, not for the whole graph, and only
+	// allocates when it meets a graph with more ids than before.
+	template<typename E>
+	class shortest_path_tree {
+	 public:
+		static constexpr auto no_node = std::numeric_limits<std::uint32_t>::max();
+
+		// whether the last search labelled id; after shortest_paths, whether id is reachable
+		[[nodiscard]] auto reached(std::size_t id) const noexcept -> bool;
+		// whether the distance of id is final, every reached node after shortest_paths
+		[[nodiscard]] auto settled(std::size_t id) const noexcept -> bool;
+		// the distance of a reached id
+		[[nodiscard]] auto distance(std::size_t id) const -> E;
+		// the node before id on its shortest path, no_node for the source and nodes not reached
+		[[nodiscard]] auto predecessor(std::size_t id) const noexcept -> std::uint32_t;
+		// how many nodes the last search settled, the work it did
+		[[nodiscard]] auto settled_count() const noexcept -> std::size_t;
+
+	 private:
+		static constexpr auto arity = std::size_t{4};
+		static constexpr auto settled_position = std::numeric_limits<std::uint32_t>::max();
+
+		std::vector<E> distance_;
+		std::vector<std::uint32_t> predecessor_;
+		// the other entries of id belong to the current search when stamp_[id] == generation_
+		std::vector<std::uint32_t> stamp_;
+		// the index of id in heap_, or settled_position
+		std::vector<std::uint32_t> position_;
+		// (key, id) pairs. The key is the distance, plus a goal directed search's estimate of what
+		// remains, kept here so sifting stays within the heap
+		std::vector<std::pair<E, std::uint32_t>> heap_;
+		std::uint32_t generation_ = 0;
+		std::size_t settled_count_ = 0;
+
+		auto reset(std::size_t ids) -> void;
+		// labels id with distance through from if that is shorter than its current label, queued by
+		// key. A node's key must exceed its distance by the same amount every time it is relaxed
+		auto relax(std::uint32_t id, E distance, std::uint32_t from, E key) -> void;
+		// removes and settles the nearest labelled id
+		[[nodiscard]] auto pop() -> std::uint32_t;
+		auto sift_up(std::size_t index) -> void;
+		auto sift_down(std::size_t index) -> void;
+		auto place(std::size_t index, std::pair<E, std::uint32_t> entry) -> void;
+
+		friend struct detail::tree_search;
+	};
+
+	namespace detail {
+		struct tree_search {
+			// starts a search from src, queued by key
+			template<typename E>
+			static auto start(shortest_path_tree<E>& tree, std::size_t ids, std::uint32_t src, E key) -> void;
+			template<typename E>
+			[[nodiscard]] static auto empty(shortest_path_tree<E> const& tree) noexcept -> bool;
+			// the smallest key queued, the tree must not be empty
+			template<typename E>
+			[[nodiscard]] static auto top(shortest_path_tree<E> const& tree) noexcept -> E;
+			// removes and settles the labelled id with the smallest key
+			template<typename E>
+			[[nodiscard]] static auto pop(shortest_path_tree<E>& tree) -> std::uint32_t;
+			template<typename E>
+			static auto relax(shortest_path_tree<E>& tree, std::uint32_t id, E distance, std::uint32_t from, E key)
+			    -> void;
+		};
+
+		// the potential of a plain Dijkstra, queueing nodes by distance alone
+		struct zero_potential {};
+
+		// Relaxes the edges of id, just settled in tree: its out-records, or its in-records when
+		// searching backwards. Each node reached is queued by its distance plus potential(node id)
+		template<typename E, typename Record, typename Potential>
+		auto expand(shortest_path_tree<E>& tree,
+		            std::uint32_t id,
+		            std::span<Record const> edges,
+		            shortest_path_options<E> const& options,
+		            Potential const& potential) -> void;
+
+		// Dijkstra from src, calling settle(id) as each node's distance becomes final. The search
+		// stops early once settle returns true. Reverse searches the in-edges, towards src
+		template<bool Reverse = false, typename N, typename E, typename Settle>
+		auto dijkstra(graph<N, E> const& g,
+		              typename graph<N, E>::node_id src,
+		              shortest_path_tree<E>& tree,
+		              shortest_path_options<E> const& options,
+		              Settle const& settle) -> void;
+
+		// the path to target along the predecessors of tree, which settled it
+		template<typename N, typename E>
+		auto path_to(graph<N, E> const& g, shortest_path_tree<E> const& tree, std::uint32_t target)
+		    -> shortest_path_result<N, E>;
+	} // namespace detail
+
+	// Dijkstra from src over the stored weights, unweighted edges costing options.unweighted_cost.
+	// Weights must not be negative. Results are left in tree, indexed by node id
+	template<typename N, typename E>
+	    requires std::is_arithmetic_v<E>
+	auto shortest_paths(graph<N, E> const& g,
+	                    N const& src,
+	                    shortest_path_tree<E>& tree,
+	                    shortest_path_options<E> const& options = {}) -> void;
+	// the same search, stopped once dst is settled; std::nullopt if dst can't be reached from src
+	template<typename N, typename E>
+	    requires std::is_arithmetic_v<E>
+	auto shortest_path(graph<N, E> const& g,
+	                   N const& src,
+	                   N const& dst,
+	                   shortest_path_tree<E>& tree,
+	                   shortest_path_options<E> const& options = {}) -> std::optional<shortest_path_result<N, E>>;
+} // namespace gdwg
+
+template<typename E>
+auto gdwg::shortest_path_tree<E>::reached(std::size_t id) const noexcept -> bool {
+	return id < stamp_.size() and stamp_[id] == generation_ and generation_ != 0;
+}
+template<typename E>
+auto gdwg::shortest_path_tree<E>::settled(std::size_t id) const noexcept -> bool {
+	return reached(id) and position_[id] == settled_position;
+}
+template<typename E>
+auto gdwg::shortest_path_tree<E>::distance(std::size_t id) const -> E {
+	if (not reached(id)) {
+		throw std::runtime_error("Cannot call gdwg::shortest_path_tree<E>::distance on a node the search didn't "
+		                         "reach");
+	}
+	return distance_[id];
+}
+template<typename E>
+auto gdwg::shortest_path_tree<E>::predecessor(std::size_t id) const noexcept -> std::uint32_t {
+	return reached(id) ? predecessor_[id] : no_node;
+}
+template<typename E>
+auto gdwg::shortest_path_tree<E>::settled_count() const noexcept -> std::size_t {
+	return settled_count_;
+}
+template<typename E>
+auto gdwg::shortest_path_tree<E>::reset(std::size_t ids) -> void {
+	if (ids > stamp_.size()) {
+		distance_.resize(ids);
+		predecessor_.resize(ids);
+		stamp_.resize(ids, 0);
+		position_.resize(ids);
+	}
+	heap_.clear();
+	settled_count_ = 0;
+	// once the generations run out every stamp is cleared, so none can match a later search
+	if (++generation_ == 0) {
+		std::fill(stamp_.begin(), stamp_.end(), 0);
+		generation_ = 1;
+	}
+}
+template<typename E>
+auto gdwg::shortest_path_tree<E>::relax(std::uint32_t id, E distance, std::uint32_t from, E key) -> void {
+	if (stamp_[id] != generation_) {
+		stamp_[id] = generation_;
+		distance_[id] = distance;
+		predecessor_[id] = from;
+		heap_.emplace_back(key, id);
+		sift_up(heap_.size() - 1);
+	}
+	else if (distance < distance_[id] and position_[id] != settled_position) {
+		distance_[id] = distance;
+		predecessor_[id] = from;
+		heap_[position_[id]].first = key;
+		sift_up(position_[id]);
+	}
+}
+template<typename E>
+auto gdwg::shortest_path_tree<E>::pop() -> std::uint32_t {
+	auto const id = heap_.front().second;
+	position_[id] = settled_position;
+	++settled_count_;
+	auto const last = heap_.back();
+	heap_.pop_back();
+	if (not heap_.empty()) {
+		place(0, last);
+		sift_down(0);
+	}
+	return id;
+}
+template<typename E>
+auto gdwg::shortest_path_tree<E>::sift_up(std::size_t index) -> void {
+	auto const entry = heap_[index];
+	while (index > 0) {
+		auto const parent = (index - 1) / arity;
+		if (not(entry.first < heap_[parent].first)) {
+			break;
+		}
+		place(index, heap_[parent]);
+		index = parent;
+	}
+	place(index, entry);
+}
+template<typename E>
+auto gdwg::shortest_path_tree<E>::sift_down(std::size_t index) -> void {
+	auto const entry = heap_[index];
+	auto const size = heap_.size();
+	while (true) {
+		auto const first = index * arity + 1;
+		if (first >= size) {
+			break;
+		}
+		auto best = first;
+		for (auto child = first + 1; child < std::min(first + arity, size); ++child) {
+			if (heap_[child].first < heap_[best].first) {
+				best = child;
+			}
+		}
+		if (not(heap_[best].first < entry.first)) {
+			break;
+		}
+		place(index, heap_[best]);
+		index = best;
+	}
+	place(index, entry);
+}
+template<typename E>
+auto gdwg::shortest_path_tree<E>::place(std::size_t index, std::pair<E, std::uint32_t> entry) -> void {
+	heap_[index] = entry;
+	position_[entry.second] = static_cast<std::uint32_t>(index);
+}
+
+template<typename E>
+auto gdwg::detail::tree_search::start(shortest_path_tree<E>& tree, std::size_t ids, std::uint32_t src, E key)
+    -> void {
+	tree.reset(ids);
+	tree.relax(src, E{}, shortest_path_tree<E>::no_node, key);
+}
+template<typename E>
+auto gdwg::detail::tree_search::empty(shortest_path_tree<E> const& tree) noexcept -> bool {
+	return tree.heap_.empty();
+}
+template<typename E>
+auto gdwg::detail::tree_search::top(shortest_path_tree<E> const& tree) noexcept -> E {
+	return tree.heap_.front().first;
+}
+template<typename E>
+auto gdwg::detail::tree_search::pop(shortest_path_tree<E>& tree) -> std::uint32_t {
+	return tree.pop();
+}
+template<typename E>
+auto gdwg::detail::tree_search::relax(shortest_path_tree<E>& tree,
+                                      std::uint32_t id,
+                                      E distance,
+                                      std::uint32_t from,
+                                      E key) -> void {
+	tree.relax(id, distance, from, key);
+}
+template<typename E, typename Record, typename Potential>
+auto gdwg::detail::expand(shortest_path_tree<E>& tree,
+                          std::uint32_t id,
+                          std::span<Record const> edges,
+                          shortest_path_options<E> const& options,
+                          Potential const& potential) -> void {
+	auto const base = tree.distance(id);
+	for (auto const& edge : edges) {
+		auto const cost = edge.weight ? *edge.weight : options.unweighted_cost;
+		if constexpr (std::is_signed_v<E>) {
+			if (cost < E{}) {
+				throw std::runtime_error("Cannot call gdwg::shortest_paths on a graph with a negative weight");
+			}
+		}
+		auto const distance = static_cast<E>(base + cost);
+		if constexpr (std::is_same_v<Potential, zero_potential>) {
+			tree_search::relax(tree, edge.dst, distance, id, distance);
+		}
+		else {
+			tree_search::relax(tree, edge.dst, distance, id, static_cast<E>(distance + potential(edge.dst)));
+		}
+	}
+}
+template<bool Reverse, typename N, typename E, typename Settle>
+auto gdwg::detail::dijkstra(graph<N, E> const& g,
+                            typename graph<N, E>::node_id src,
+                            shortest_path_tree<E>& tree,
+                            shortest_path_options<E> const& options,
+                            Settle const& settle) -> void {
+	tree_search::start(tree, g.id_bound(), src, E{});
+	while (not tree_search::empty(tree)) {
+		auto const id = tree_search::pop(tree);
+		if (settle(id)) {
+			return;
+		}
+		if constexpr (Reverse) {
+			detail::expand(tree, id, g.in_records(id), options, zero_potential{});
+		}
+		else {
+			detail::expand(tree, id, g.out_records(id), options, zero_potential{});
+		}
+	}
+}
+template<typename N, typename E>
+auto gdwg::detail::path_to(graph<N, E> const& g, shortest_path_tree<E> const& tree, std::uint32_t target)
+    -> shortest_path_result<N, E> {
+	auto result = shortest_path_result<N, E>{tree.distance(target), {}};
+	for (auto id = target; id != shortest_path_tree<E>::no_node; id = tree.predecessor(id)) {
+		result.nodes.push_back(g.node_at(id));
+	}
+	std::reverse(result.nodes.begin(), result.nodes.end());
+	return result;
+}
+template<typename N, typename E>
+    requires std::is_arithmetic_v<E>
+auto gdwg::shortest_paths(graph<N, E> const& g,
+                          N const& src,
+                          shortest_path_tree<E>& tree,
+                          shortest_path_options<E> const& options) -> void {
+	if (not g.is_node(src)) {
+		throw std::runtime_error("Cannot call gdwg::shortest_paths if src doesn't exist in the graph");
+	}
+	detail::dijkstra(g, g.id_of(src), tree, options, [](std::uint32_t) { return false; });
+}
+template<typename N, typename E>
+    requires std::is_arithmetic_v<E>
+auto gdwg::shortest_path(graph<N, E> const& g,
+                         N const& src,
+                         N const& dst,
+                         shortest_path_tree<E>& tree,
+                         shortest_path_options<E> const& options) -> std::optional<shortest_path_result<N, E>> {
+	if (not g.is_node(src) or not g.is_node(dst)) {
+		throw std::runtime_error("Cannot call gdwg::shortest_path if src or dst node don't exist in the graph");
+	}
+	auto const target = g.id_of(dst);
+	detail::dijkstra(g, g.id_of(src), tree, options, [target](std::uint32_t id) { return id == target; });
+	if (not tree.settled(target)) {
+		return std::nullopt;
+	}
+	return detail::path_to(g, tree, target);
+}
+#endif // GDWG_SHORTEST_PATHS_H
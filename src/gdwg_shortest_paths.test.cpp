@@ -0,0 +1,106 @@
+#include "gdwg_shortest_paths.h"
+#include "gdwg_test_graphs.h"
+
+#include <catch2/catch.hpp>
+
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+	// Bellman-Ford over the edge list, the reference the heap based search is checked against
+	auto reference_distances(gdwg::graph<int, int> const& g, int src, int unweighted_cost) -> std::vector<long> {
+		auto constexpr unreached = std::numeric_limits<long>::max();
+		auto distance = std::vector<long>(g.id_bound(), unreached);
+		distance[g.id_of(src)] = 0;
+		for (auto changed = true; changed;) {
+			changed = false;
+			for (auto const& [from, to, weight] : g) {
+				auto const f = g.id_of(from);
+				auto const t = g.id_of(to);
+				if (distance[f] != unreached and distance[f] + weight.value_or(unweighted_cost) < distance[t]) {
+					distance[t] = distance[f] + weight.value_or(unweighted_cost);
+					changed = true;
+				}
+			}
+		}
+		return distance;
+	}
+} // namespace
+
+TEST_CASE("shortest_path: uses stored weights and the cost of unweighted edges") {
+	auto g = gdwg::graph<std::string, double>{"a", "b", "c", "d", "e"};
+	g.insert_edge("a", "b", 4.0);
+	g.insert_edge("a", "b", 1.5);
+	g.insert_edge("a", "c");
+	g.insert_edge("c", "b");
+	g.insert_edge("b", "d", 2.0);
+	g.insert_edge("c", "d", 5.0);
+	g.insert_edge("e", "a", 1.0);
+
+	auto tree = gdwg::shortest_path_tree<double>();
+	auto const path = gdwg::shortest_path(g, std::string("a"), std::string("d"), tree);
+	REQUIRE(path);
+	CHECK(path->distance == 3.5);
+	CHECK(path->nodes == std::vector<std::string>{"a", "b", "d"});
+
+	// unweighted edges made cheap change the route
+	auto const cheap = gdwg::shortest_path(g, std::string("a"), std::string("d"), tree, {.unweighted_cost = 0.25});
+	REQUIRE(cheap);
+	CHECK(cheap->distance == 2.5);
+	CHECK(cheap->nodes == std::vector<std::string>{"a", "c", "b", "d"});
+
+	auto const self = gdwg::shortest_path(g, std::string("a"), std::string("a"), tree);
+	REQUIRE(self);
+	CHECK(self->distance == 0.0);
+	CHECK(self->nodes == std::vector<std::string>{"a"});
+	CHECK_FALSE(gdwg::shortest_path(g, std::string("a"), std::string("e"), tree));
+
+	gdwg::shortest_paths(g, std::string("a"), tree);
+	CHECK(tree.distance(g.id_of("d")) == 3.5);
+	CHECK(tree.predecessor(g.id_of("d")) == g.id_of("b"));
+	CHECK(tree.predecessor(g.id_of("a")) == gdwg::shortest_path_tree<double>::no_node);
+	CHECK_FALSE(tree.reached(g.id_of("e")));
+	CHECK_THROWS_WITH(tree.distance(g.id_of("e")),
+	                  "Cannot call gdwg::shortest_path_tree<E>::distance on a node the search didn't reach");
+
+	auto const missing = [&] { return gdwg::shortest_path(g, std::string("a"), std::string("f"), tree); };
+	CHECK_THROWS_WITH(missing(), "Cannot call gdwg::shortest_path if src or dst node don't exist in the graph");
+	g.insert_edge("d", "e", -1.0);
+	CHECK_THROWS_WITH(gdwg::shortest_paths(g, std::string("a"), tree),
+	                  "Cannot call gdwg::shortest_paths on a graph with a negative weight");
+}
+TEST_CASE("shortest_paths: matches Bellman-Ford on random graphs, reusing one tree") {
+	auto tree = gdwg::shortest_path_tree<int>();
+	for (auto const& [nodes, seed] : {std::pair(50, 7U), std::pair(300, 8U), std::pair(20, 9U)}) {
+		auto g = gdwg::test::random_graph(nodes, nodes * 4, 20, seed);
+		// erased nodes leave free ids behind
+		g.erase_node(2);
+		for (auto const src : {0, 4, (nodes - 1) * 2}) {
+			gdwg::shortest_paths(g, src, tree, {.unweighted_cost = 2});
+			auto const expected = reference_distances(g, src, 2);
+			for (auto id = std::size_t{0}; id < g.id_bound(); ++id) {
+				if (expected[id] == std::numeric_limits<long>::max()) {
+					CHECK_FALSE(tree.reached(id));
+					continue;
+				}
+				REQUIRE(tree.settled(id));
+				CHECK(tree.distance(id) == expected[id]);
+				// the predecessor chain adds up to the distance
+				if (auto const p = tree.predecessor(id); p != gdwg::shortest_path_tree<int>::no_node) {
+					auto const edges = g.edges_between(g.node_at(p), g.node_at(static_cast<std::uint32_t>(id)));
+					auto cheapest = std::numeric_limits<int>::max();
+					for (auto const& e : edges) {
+						cheapest = std::min(cheapest, e.weight.value_or(2));
+					}
+					CHECK(tree.distance(p) + cheapest == tree.distance(id));
+				}
+			}
+			// the nodes shortest_path returns add up to its distance
+			if (auto const path = gdwg::shortest_path(g, src, (nodes - 2) * 2, tree, {.unweighted_cost = 2})) {
+				CHECK(gdwg::test::path_cost(g, path->nodes, 2) == path->distance);
+			}
+		}
+	}
+}
@@ -0,0 +1,48 @@
+#ifndef GDWG_TEST_GRAPHS_H
+#define GDWG_TEST_GRAPHS_H
+#include "gdwg_graph.h"
+
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <optional>
+#include <random>
+#include <vector>
+
+// graphs and checks shared by the search tests
+namespace gdwg::test {
+	// a random graph over 0, 2, 4, ... with parallel edges, self loops and weights in [1, max_weight],
+	// a weight of 0 is drawn as an unweighted edge
+	inline auto random_graph(int nodes, int edges, int max_weight, unsigned seed) -> graph<int, int> {
+		auto rng = std::mt19937(seed);
+		auto g = graph<int, int>();
+		for (auto i = 0; i < nodes; ++i) {
+			g.insert_node(i * 2);
+		}
+		auto node = std::uniform_int_distribution<int>(0, nodes - 1);
+		auto weight = std::uniform_int_distribution<int>(0, max_weight);
+		for (auto i = 0; i < edges; ++i) {
+			auto const w = weight(rng);
+			g.insert_edge(node(rng) * 2, node(rng) * 2, w == 0 ? std::nullopt : std::optional<int>(w));
+		}
+		return g;
+	}
+
+	// the cost of a path, taking the cheapest edge between each pair of nodes on it
+	template<typename N>
+	auto path_cost(graph<N, int> const& g, std::vector<N> const& nodes, int unweighted_cost) -> int {
+		auto total = 0;
+		for (auto i = std::size_t{1}; i < nodes.size(); ++i) {
+			auto cheapest = std::optional<int>();
+			for (auto const& e : g.edges_between(nodes[i - 1], nodes[i])) {
+				auto const cost = e.weight.value_or(unweighted_cost);
+				cheapest = cheapest ? std::min(*cheapest, cost) : cost;
+			}
+			REQUIRE(cheapest);
+			total += *cheapest;
+		}
+		return total;
+	}
+} // namespace gdwg::test
+#endif // GDWG_TEST_GRAPHS_H
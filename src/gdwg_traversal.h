@@ -0,0 +1,210 @@
+#ifndef GDWG_TRAVERSAL_H
+#define GDWG_TRAVERSAL_H
+#include "gdwg_graph.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+namespace gdwg {
+	class traversal_workspace;
+	namespace detail {
+		// the traversals from a node id
+		template<typename N, typename E, typename Visitor>
+		auto breadth_first(graph<N, E> const& g,
+		                   typename graph<N, E>::node_id src,
+		                   traversal_workspace& workspace,
+		                   Visitor& visitor) -> void;
+		template<typename N, typename E, typename Visitor>
+		auto depth_first(graph<N, E> const& g,
+		                 typename graph<N, E>::node_id src,
+		                 traversal_workspace& workspace,
+		                 Visitor& visitor) -> void;
+	} // namespace detail
+
+	// Scratch space for breadth_first_search and depth_first_search. A traversal only allocates when
+	// its graph has more ids than any graph the workspace was used with before. After a traversal,
+	// visited(id) tells whether id was reached.
+	class traversal_workspace {
+	 public:
+		[[nodiscard]] auto visited(std::size_t id) const noexcept -> bool;
+
+	 private:
+		std::vector<std::uint64_t> visited_;
+		// the bfs queue, consumed from head_
+		std::vector<std::uint32_t> queue_;
+		std::size_t head_ = 0;
+		// the dfs stack of (id, position of the next out-edge to examine)
+		std::vector<std::pair<std::uint32_t, std::size_t>> stack_;
+
+		auto reset(std::size_t ids) -> void;
+		// marks id visited, returning whether it was new
+		auto visit(std::size_t id) noexcept -> bool;
+
+		template<typename N, typename E, typename Visitor>
+		friend auto detail::breadth_first(graph<N, E> const& g,
+		                                  typename graph<N, E>::node_id src,
+		                                  traversal_workspace& workspace,
+		                                  Visitor& visitor) -> void;
+		template<typename N, typename E, typename Visitor>
+		friend auto detail::depth_first(graph<N, E> const& g,
+		                                typename graph<N, E>::node_id src,
+		                                traversal_workspace& workspace,
+		                                Visitor& visitor) -> void;
+	};
+
+	// Traversals from src over the out-edges, reporting nodes by id (see graph::node_at). The
+	// visitor's callbacks are all optional:
+	//   discover(id)            when id is first reached, src included
+	//   examine_edge(id, edge)  for each out-edge record of id as it is expanded
+	//   finish(id)              once every out-edge of id was examined; in depth first order, also
+	//                           once everything first reached through them is finished
+	// A callback returning bool stops the traversal when it returns false.
+	template<typename N, typename E, typename Visitor>
+	auto breadth_first_search(graph<N, E> const& g, N const& src, traversal_workspace& workspace, Visitor&& visitor)
+	    -> void;
+	template<typename N, typename E, typename Visitor>
+	auto depth_first_search(graph<N, E> const& g, N const& src, traversal_workspace& workspace, Visitor&& visitor)
+	    -> void;
+
+	namespace detail {
+		// runs the callback, false only when it returned false
+		template<typename F>
+		auto keep_going(F&& callback) -> bool {
+			if constexpr (std::is_same_v<std::invoke_result_t<F>, bool>) {
+				return callback();
+			}
+			else {
+				callback();
+				return true;
+			}
+		}
+		template<typename Visitor, typename Id>
+		auto discover(Visitor& visitor, Id id) -> bool {
+			if constexpr (requires { visitor.discover(id); }) {
+				return keep_going([&] { return visitor.discover(id); });
+			}
+			return true;
+		}
+		template<typename Visitor, typename Id, typename Record>
+		auto examine_edge(Visitor& visitor, Id id, Record const& edge) -> bool {
+			if constexpr (requires { visitor.examine_edge(id, edge); }) {
+				return keep_going([&] { return visitor.examine_edge(id, edge); });
+			}
+			return true;
+		}
+		template<typename Visitor, typename Id>
+		auto finish(Visitor& visitor, Id id) -> bool {
+			if constexpr (requires { visitor.finish(id); }) {
+				return keep_going([&] { return visitor.finish(id); });
+			}
+			return true;
+		}
+	} // namespace detail
+} // namespace gdwg
+
+inline auto gdwg::traversal_workspace::visited(std::size_t id) const noexcept -> bool {
+	return id / 64 < visited_.size() and (visited_[id / 64] >> (id % 64) & 1U) != 0;
+}
+inline auto gdwg::traversal_workspace::reset(std::size_t ids) -> void {
+	// assign keeps the capacity, so only a larger graph allocates
+	visited_.assign((ids + 63) / 64, 0);
+	queue_.clear();
+	head_ = 0;
+	stack_.clear();
+}
+inline auto gdwg::traversal_workspace::visit(std::size_t id) noexcept -> bool {
+	auto& word = visited_[id / 64];
+	auto const bit = std::uint64_t{1} << (id % 64);
+	if ((word & bit) != 0) {
+		return false;
+	}
+	word |= bit;
+	return true;
+}
+
+template<typename N, typename E, typename Visitor>
+auto gdwg::detail::breadth_first(graph<N, E> const& g,
+                                 typename graph<N, E>::node_id src,
+                                 traversal_workspace& workspace,
+                                 Visitor& visitor) -> void {
+	workspace.reset(g.id_bound());
+	workspace.visit(src);
+	if (not detail::discover(visitor, src)) {
+		return;
+	}
+	auto& queue = workspace.queue_;
+	queue.push_back(src);
+	while (workspace.head_ < queue.size()) {
+		auto const id = queue[workspace.head_++];
+		for (auto const& edge : g.out_records(id)) {
+			if (not detail::examine_edge(visitor, id, edge)) {
+				return;
+			}
+			if (workspace.visit(edge.dst)) {
+				if (not detail::discover(visitor, edge.dst)) {
+					return;
+				}
+				queue.push_back(edge.dst);
+			}
+		}
+		if (not detail::finish(visitor, id)) {
+			return;
+		}
+	}
+}
+template<typename N, typename E, typename Visitor>
+auto gdwg::detail::depth_first(graph<N, E> const& g,
+                               typename graph<N, E>::node_id src,
+                               traversal_workspace& workspace,
+                               Visitor& visitor) -> void {
+	workspace.reset(g.id_bound());
+	workspace.visit(src);
+	if (not detail::discover(visitor, src)) {
+		return;
+	}
+	auto& stack = workspace.stack_;
+	stack.emplace_back(src, 0);
+	while (not stack.empty()) {
+		auto& [id, next] = stack.back();
+		auto const edges = g.out_records(id);
+		if (next == edges.size()) {
+			auto const done = id;
+			stack.pop_back();
+			if (not detail::finish(visitor, done)) {
+				return;
+			}
+			continue;
+		}
+		auto const& edge = edges[next++];
+		if (not detail::examine_edge(visitor, id, edge)) {
+			return;
+		}
+		if (workspace.visit(edge.dst)) {
+			if (not detail::discover(visitor, edge.dst)) {
+				return;
+			}
+			// invalidates id and next, which aren't used again this iteration
+			stack.emplace_back(edge.dst, 0);
+		}
+	}
+}
+template<typename N, typename E, typename Visitor>
+auto gdwg::breadth_first_search(graph<N, E> const& g, N const& src, traversal_workspace& workspace, Visitor&& visitor)
+    -> void {
+	if (not g.is_node(src)) {
+		throw std::runtime_error("Cannot call gdwg::breadth_first_search if src doesn't exist in the graph");
+	}
+	detail::breadth_first(g, g.id_of(src), workspace, visitor);
+}
+template<typename N, typename E, typename Visitor>
+auto gdwg::depth_first_search(graph<N, E> const& g, N const& src, traversal_workspace& workspace, Visitor&& visitor)
+    -> void {
+	if (not g.is_node(src)) {
+		throw std::runtime_error("Cannot call gdwg::depth_first_search if src doesn't exist in the graph");
+	}
+	detail::depth_first(g, g.id_of(src), workspace, visitor);
+}
+#endif // GDWG_TRAVERSAL_H
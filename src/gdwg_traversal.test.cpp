@@ -0,0 +1,136 @@
+#include "gdwg_traversal.h"
+
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <vector>
+
+namespace {
+	// a -> b -> d, a -> c -> d, d -> a, with e unreachable and parallel edges a -> b
+	auto make_graph() -> gdwg::graph<std::string, int> {
+		auto g = gdwg::graph<std::string, int>{"a", "b", "c", "d", "e"};
+		g.insert_edge("a", "b", 1);
+		g.insert_edge("a", "b", 2);
+		g.insert_edge("a", "c");
+		g.insert_edge("b", "d", 3);
+		g.insert_edge("c", "d", 4);
+		g.insert_edge("d", "a", 5);
+		g.insert_edge("e", "a");
+		return g;
+	}
+
+	// records every callback as a line of text
+	struct recorder {
+		gdwg::graph<std::string, int> const* g;
+		std::vector<std::string> events;
+		auto discover(gdwg::graph<std::string, int>::node_id id) -> void {
+			events.push_back("discover " + g->node_at(id));
+		}
+		auto examine_edge(gdwg::graph<std::string, int>::node_id id,
+		                  gdwg::graph<std::string, int>::edge_record const& edge) -> void {
+			events.push_back("examine " + g->node_at(id) + " " + g->node_at(edge.dst));
+		}
+		auto finish(gdwg::graph<std::string, int>::node_id id) -> void {
+			events.push_back("finish " + g->node_at(id));
+		}
+	};
+} // namespace
+
+TEST_CASE("breadth_first_search: visits in order of distance") {
+	auto const g = make_graph();
+	auto workspace = gdwg::traversal_workspace();
+	auto r = recorder{&g, {}};
+	gdwg::breadth_first_search(g, std::string("a"), workspace, r);
+	CHECK(r.events
+	      == std::vector<std::string>{
+	          "discover a",
+	          "examine a b",
+	          "discover b",
+	          "examine a b",
+	          "examine a c",
+	          "discover c",
+	          "finish a",
+	          "examine b d",
+	          "discover d",
+	          "finish b",
+	          "examine c d",
+	          "finish c",
+	          "examine d a",
+	          "finish d",
+	      });
+	CHECK(workspace.visited(g.id_of("d")));
+	CHECK_FALSE(workspace.visited(g.id_of("e")));
+
+	CHECK_THROWS_WITH(gdwg::breadth_first_search(g, std::string("f"), workspace, r),
+	                  "Cannot call gdwg::breadth_first_search if src doesn't exist in the graph");
+}
+TEST_CASE("depth_first_search: finishes a node after everything reached through it") {
+	auto const g = make_graph();
+	auto workspace = gdwg::traversal_workspace();
+	auto r = recorder{&g, {}};
+	gdwg::depth_first_search(g, std::string("a"), workspace, r);
+	CHECK(r.events
+	      == std::vector<std::string>{
+	          "discover a",
+	          "examine a b",
+	          "discover b",
+	          "examine b d",
+	          "discover d",
+	          "examine d a",
+	          "finish d",
+	          "finish b",
+	          "examine a b",
+	          "examine a c",
+	          "discover c",
+	          "examine c d",
+	          "finish c",
+	          "finish a",
+	      });
+
+	// the workspace is reset for each traversal, also one over a different graph
+	auto other = gdwg::graph<int, int>{1, 2, 3};
+	other.insert_edge(3, 1);
+	auto order = std::vector<int>();
+	gdwg::depth_first_search(other, 3, workspace, [&] {
+		struct visitor {
+			gdwg::graph<int, int> const* g;
+			std::vector<int>* order;
+			auto discover(gdwg::graph<int, int>::node_id id) -> void {
+				order->push_back(g->node_at(id));
+			}
+		};
+		return visitor{&other, &order};
+	}());
+	CHECK(order == std::vector<int>{3, 1});
+	CHECK_FALSE(workspace.visited(other.id_of(2)));
+}
+TEST_CASE("traversals stop when a callback returns false") {
+	auto g = gdwg::graph<int, int>();
+	for (auto i = 0; i < 100; ++i) {
+		g.insert_node(i);
+	}
+	for (auto i = 0; i < 99; ++i) {
+		g.insert_edge(i, i + 1);
+		g.insert_edge(i, (i * 7) % 100);
+	}
+	struct until {
+		gdwg::graph<int, int> const* g;
+		int target;
+		int discovered = 0;
+		auto discover(gdwg::graph<int, int>::node_id id) -> bool {
+			++discovered;
+			return g->node_at(id) != target;
+		}
+	};
+	auto workspace = gdwg::traversal_workspace();
+	auto bfs = until{&g, 10};
+	gdwg::breadth_first_search(g, 0, workspace, bfs);
+	CHECK(workspace.visited(g.id_of(10)));
+	CHECK(bfs.discovered < 100);
+	auto dfs = until{&g, 10};
+	gdwg::depth_first_search(g, 0, workspace, dfs);
+	CHECK(dfs.discovered == 11);
+	auto all = until{&g, -1};
+	gdwg::depth_first_search(g, 0, workspace, all);
+	CHECK(all.discovered == 100);
+}